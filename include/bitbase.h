@@ -0,0 +1,242 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "piece.h"
+
+#define BITBASE_FILE_MAGIC 0x53425442U /* "BTBS" */
+#define BITBASE_FILE_VERSION 1
+#define BITBASE_FILE_EXTENSION ".bitbase"
+#define DEFAULT_BITBASE_DIRECTORY "bitbases"
+
+/* the most pieces a bitbase can have besides the kings, up to five pieces in all */
+#define BITBASE_MAX_PIECES 3
+
+/* pieces a pawn can promote to */
+#define BITBASE_NUM_OF_PROMOTIONS 4
+
+class Game;
+
+/**
+ * @brief value of a position in a bitbase, from the point of view of the player to move
+ */
+enum class BitbaseValue
+{
+  LOSS,
+  DRAW,
+  WIN
+};
+
+/**
+ * @brief position of a bitbase with the strong side as white
+ *
+ * strongKing, weakKing: positions of the kings
+ * pieces: positions of the pieces of the strong side, in the order of the signature
+ * isStrongToMove: true if the strong side is to move
+ */
+struct BitbasePosition
+{
+  int strongKing;
+  int weakKing;
+  int pieces[BITBASE_MAX_PIECES];
+  bool isStrongToMove;
+};
+
+/**
+ * @brief Bitbase class for the win/draw bitbases of the endgames of a few pieces
+ *          against a lone king, such as "KPK" or "KBNK"
+ *
+ * The lone king can never win, so a position takes a single bit: set if the strong
+ * side wins with correct play, whoever is to move. Positions are indexed by the side
+ * to move and the positions of the kings and pieces. Symmetry keeps the index small:
+ * with pawns the board is mirrored so the first pawn is on the files a to d, without
+ * them it is mirrored and flipped so the strong king is in the triangle a1-d1-d4.
+ *
+ * Bitbases are generated by retrograde analysis: starting from the mates, a position
+ * with the strong side to move is won if one of its moves leads to a won position,
+ * one with the weak side to move if all of its moves do. Every iteration works on
+ * index partitions in parallel until no new wins are found, so the iteration a
+ * position is found in gives its distance to mate. Captures by the lone king and
+ * promotions are looked up in the bitbases of the material they lead to.
+ *
+ * The file starts with the magic, the version and the number of positions as uint32,
+ * followed by the bits as little-endian uint64 words.
+ */
+class Bitbase
+{
+public:
+  /**
+   * @brief bitbase of a signature with the strong side first and the lone king last,
+   *          it has to be generated or loaded before it can be probed
+   */
+  Bitbase(std::string const &signature);
+
+  std::string const &getSignature() const;
+
+  size_t getNumOfPositions() const;
+
+  /**
+   * @brief checks if the bitbase has been generated or loaded
+   */
+  bool isReady() const;
+
+  /**
+   * @brief generates the bitbase by retrograde analysis
+   *
+   * @param numThreads number of threads the index partitions are spread over
+   * @param subtables generated bitbases that captures and promotions lead to, material
+   *          without one is taken as a draw
+   */
+  void generate(int const numThreads, std::vector<Bitbase const *> const &subtables);
+
+  bool save(std::string const &path) const;
+
+  /**
+   * @brief loads the bitbase from a file, the bitbase is unchanged if it fails
+   */
+  bool load(std::string const &path);
+
+  /**
+   * @brief checks if a material key is that of the bitbase, for either color as the strong side
+   */
+  bool hasMaterialKey(uint64_t const materialKey) const;
+
+  /**
+   * @brief index of the position of a game
+   *
+   * @return true if the material of the game is that of the bitbase, for either color
+   *          as the strong side, otherwise false
+   */
+  bool getIndex(Game &game, size_t &index) const;
+
+  /**
+   * @brief checks if a position is won for the strong side
+   */
+  bool isWon(size_t const index) const;
+
+  /**
+   * @brief plies until mate of a won position with best play by both sides
+   *
+   * @return the distance to mate, -1 if the position is not won or the bitbase was loaded
+   */
+  int getDistanceToMate(size_t const index) const;
+
+  /**
+   * @brief signatures of the material that captures and promotions lead to
+   */
+  std::vector<std::string> getSubtableSignatures() const;
+
+  /**
+   * @brief FEN-notation of a position with the strong side as white, empty if the
+   *          index is not a legal position
+   */
+  std::string getFEN(size_t const index) const;
+
+  /**
+   * @brief looks up the value of the position of a game
+   *
+   * @return true if the bitbase covers the material of the game, otherwise false
+   */
+  bool probe(Game &game, BitbaseValue &value) const;
+
+  /**
+   * @brief checks a position with a search of one ply over the legal moves of Game,
+   *          the value and the distance to mate have to follow from those of the moves
+   *
+   * @param bitbases the bitbase itself and the bitbases its captures and promotions lead to
+   * @return true if the position matches the search or is not legal, otherwise false
+   */
+  bool verifyPosition(size_t const index, std::vector<Bitbase const *> const &bitbases) const;
+
+private:
+  std::string signature;
+  Piece::Type pieces[BITBASE_MAX_PIECES];
+  int numOfPieces;
+
+  /* slot of the first pawn in pieces, the one the symmetry is taken from, -1 without pawns */
+  int pawnSlot;
+
+  size_t numOfPositions;
+  uint64_t materialKeys[2];
+  std::vector<uint64_t> bits;
+  std::vector<uint8_t> states;
+
+  /* bitbases of the generation that the capture of a piece and the promotions lead to */
+  Bitbase const *captureSubtables[BITBASE_MAX_PIECES];
+  Bitbase const *promotionSubtables[BITBASE_NUM_OF_PROMOTIONS];
+
+  size_t indexOf(BitbasePosition const &position) const;
+
+  BitbasePosition positionOf(size_t index) const;
+
+  bool isLegal(BitbasePosition const &position) const;
+
+  /**
+   * @brief checks if a position was found to be won before an iteration of the generation,
+   *          a loaded bitbase only knows if it is won
+   */
+  bool isWonBefore(BitbasePosition const &position, int const iteration) const;
+
+  /**
+   * @brief position in another bitbase after a capture or promotion
+   *
+   * @param types types of the pieces after the move, Piece::Type::BLANK for a captured one
+   */
+  BitbasePosition positionIn(Bitbase const &other, BitbasePosition const &position, Piece::Type const types[BITBASE_MAX_PIECES]) const;
+
+  /**
+   * @brief classifies an unknown position in an iteration of the generation
+   *
+   * @return the new state of the position, or the unknown state if it stays unknown
+   */
+  uint8_t classify(size_t const index, int const iteration) const;
+};
+
+/**
+ * @brief namespace for the bitbases used by the engines, loaded once and shared
+ */
+namespace Bitbases
+{
+  /**
+   * @brief signatures of the bitbases the evaluation uses
+   */
+  std::vector<std::string> const &getSignatures();
+
+  /**
+   * @brief checks if a signature is the kings around up to BITBASE_MAX_PIECES pieces
+   *          of the strong side, such as "KRPK"
+   */
+  bool isValidSignature(std::string const &signature);
+
+  /**
+   * @brief path of the file of a bitbase in a directory
+   */
+  std::string getPath(std::string const &directory, std::string const &signature);
+
+  /**
+   * @brief loads the bitbases of getSignatures found in a directory, bitbases that
+   *          were loaded before are replaced
+   *
+   * @return true if at least one bitbase is loaded, otherwise false
+   */
+  bool load(std::string const &directory);
+
+  bool isLoaded();
+
+  /**
+   * @brief checks if a bitbase for a material key is loaded
+   */
+  bool isAvailable(uint64_t const materialKey);
+
+  /**
+   * @brief looks up the value of the position of a game in the loaded bitbases
+   *
+   * @return true if a loaded bitbase covers the material of the game, otherwise false
+   */
+  bool probe(Game &game, BitbaseValue &value);
+};
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+#include "piece.h"
+#include "direction.h"
+
+#define NUM_OF_RAY_DIRECTIONS 8
+#define NUM_OF_POSITIVE_RAY_DIRECTIONS 4
+
+/**
+ * @brief set of positions on the board, bit i is set if position i is in the set
+ */
+typedef uint64_t Bitboard;
+
+/**
+ * @brief namespace for the bitboard helpers and the precomputed attack tables
+ */
+namespace Bitboards
+{
+  Bitboard const FILE_A = 0x0101010101010101ULL;
+  Bitboard const RANK_1 = 0xFFULL;
+
+  constexpr Bitboard positionToBitboard(int const pos)
+  {
+    return 1ULL << pos;
+  }
+
+  static inline Bitboard fileBitboard(int const column)
+  {
+    return FILE_A << column;
+  }
+
+  static inline Bitboard rankBitboard(int const row)
+  {
+    return RANK_1 << (row * BOARD_LENGTH);
+  }
+
+  static inline int popCount(Bitboard const bitboard)
+  {
+    return __builtin_popcountll(bitboard);
+  }
+
+  /**
+   * @brief getter for the lowest position in a non-empty bitboard
+   */
+  static inline int lsb(Bitboard const bitboard)
+  {
+    return __builtin_ctzll(bitboard);
+  }
+
+  /**
+   * @brief getter for the highest position in a non-empty bitboard
+   */
+  static inline int msb(Bitboard const bitboard)
+  {
+    return 63 - __builtin_clzll(bitboard);
+  }
+
+  /**
+   * @brief removes the lowest position from a non-empty bitboard and returns it
+   */
+  static inline int popLsb(Bitboard &bitboard)
+  {
+    int const pos = lsb(bitboard);
+    bitboard &= bitboard - 1;
+    return pos;
+  }
+
+  /**
+   * @brief bitboard of a step from a position, empty if the step leaves the board
+   */
+  constexpr Bitboard stepBitboard(int const pos, int const rowStep, int const columnStep)
+  {
+    int const row = pos / BOARD_LENGTH + rowStep;
+    int const column = pos % BOARD_LENGTH + columnStep;
+    if (row < 0 || row >= BOARD_LENGTH || column < 0 || column >= BOARD_LENGTH)
+    {
+      return 0;
+    }
+    return positionToBitboard(row * BOARD_LENGTH + column);
+  }
+
+  /* directions of the sliders as row and column steps, the even ones are straight and the odd
+     ones diagonal, the first four go to higher positions */
+  constexpr int rayDirections[NUM_OF_RAY_DIRECTIONS][2] = {{1, 0}, {1, 1}, {0, 1}, {1, -1}, {-1, 0}, {-1, -1}, {0, -1}, {-1, 1}};
+
+  /**
+   * @brief attacks on an empty board, rays[direction][pos] holds the positions from pos
+   *          in a direction up to the edge of the board
+   */
+  struct AttackTables
+  {
+    Bitboard knight[BOARD_SIZE];
+    Bitboard king[BOARD_SIZE];
+    Bitboard whitePawn[BOARD_SIZE];
+    Bitboard blackPawn[BOARD_SIZE];
+    Bitboard rays[NUM_OF_RAY_DIRECTIONS][BOARD_SIZE];
+  };
+
+  constexpr AttackTables generateAttackTables()
+  {
+    AttackTables tables = {};
+    int const knightSteps[8][2] = {{2, 1}, {1, 2}, {-1, 2}, {-2, 1}, {-2, -1}, {-1, -2}, {1, -2}, {2, -1}};
+    int const kingSteps[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+    for (int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+      for (int i = 0; i < 8; i++)
+      {
+        tables.knight[pos] |= stepBitboard(pos, knightSteps[i][0], knightSteps[i][1]);
+        tables.king[pos] |= stepBitboard(pos, kingSteps[i][0], kingSteps[i][1]);
+      }
+      tables.whitePawn[pos] = stepBitboard(pos, 1, -1) | stepBitboard(pos, 1, 1);
+      tables.blackPawn[pos] = stepBitboard(pos, -1, -1) | stepBitboard(pos, -1, 1);
+      for (int direction = 0; direction < NUM_OF_RAY_DIRECTIONS; direction++)
+      {
+        for (int distance = 1; distance < BOARD_LENGTH; distance++)
+        {
+          tables.rays[direction][pos] |= stepBitboard(pos, distance * rayDirections[direction][0], distance * rayDirections[direction][1]);
+        }
+      }
+    }
+    return tables;
+  }
+
+  inline constexpr AttackTables attackTables = generateAttackTables();
+
+  static inline Bitboard knightAttacks(int const pos)
+  {
+    return attackTables.knight[pos];
+  }
+
+  static inline Bitboard kingAttacks(int const pos)
+  {
+    return attackTables.king[pos];
+  }
+
+  /**
+   * @brief positions attacked by a pawn of a given color on a position
+   */
+  static inline Bitboard pawnAttacks(Piece::Color const color, int const pos)
+  {
+    return color == Piece::Color::WHITE ? attackTables.whitePawn[pos] : attackTables.blackPawn[pos];
+  }
+
+  /**
+   * @brief positions attacked by all pawns in a bitboard of a given color
+   */
+  static inline Bitboard pawnAttacksOfBitboard(Piece::Color const color, Bitboard const pawns)
+  {
+    Bitboard const notFileA = ~FILE_A;
+    Bitboard const notFileH = ~(FILE_A << (BOARD_LENGTH - 1));
+    if (color == Piece::Color::WHITE)
+    {
+      return ((pawns & notFileA) << (BOARD_LENGTH - 1)) | ((pawns & notFileH) << (BOARD_LENGTH + 1));
+    }
+    return ((pawns & notFileA) >> (BOARD_LENGTH + 1)) | ((pawns & notFileH) >> (BOARD_LENGTH - 1));
+  }
+
+  /**
+   * @brief positions in front of the positions of a bitboard as seen from a color,
+   *          up to the last rank and without the positions themselves
+   */
+  static inline Bitboard frontSpan(Piece::Color const color, Bitboard bitboard)
+  {
+    if (color == Piece::Color::WHITE)
+    {
+      bitboard <<= BOARD_LENGTH;
+      bitboard |= bitboard << BOARD_LENGTH;
+      bitboard |= bitboard << (2 * BOARD_LENGTH);
+      bitboard |= bitboard << (4 * BOARD_LENGTH);
+      return bitboard;
+    }
+    bitboard >>= BOARD_LENGTH;
+    bitboard |= bitboard >> BOARD_LENGTH;
+    bitboard |= bitboard >> (2 * BOARD_LENGTH);
+    bitboard |= bitboard >> (4 * BOARD_LENGTH);
+    return bitboard;
+  }
+
+  /**
+   * @brief positions directly left and right of the positions of a bitboard
+   */
+  static inline Bitboard adjacentColumns(Bitboard const bitboard)
+  {
+    Bitboard const notFileA = ~FILE_A;
+    Bitboard const notFileH = ~(FILE_A << (BOARD_LENGTH - 1));
+    return ((bitboard & notFileA) >> 1) | ((bitboard & notFileH) << 1);
+  }
+
+  /**
+   * @brief positions attacked by a slider moving in a direction until
+   *          it leaves the board or hits an occupied position, the ray
+   *          beyond the first occupied position is cut off
+   */
+  static inline Bitboard rayAttacks(int const pos, int const direction, Bitboard const occupied)
+  {
+    Bitboard attacks = attackTables.rays[direction][pos];
+    Bitboard const blockers = attacks & occupied;
+    if (blockers)
+    {
+      attacks ^= attackTables.rays[direction][direction < NUM_OF_POSITIVE_RAY_DIRECTIONS ? lsb(blockers) : msb(blockers)];
+    }
+    return attacks;
+  }
+
+  static inline Bitboard bishopAttacks(int const pos, Bitboard const occupied)
+  {
+    return rayAttacks(pos, 1, occupied) | rayAttacks(pos, 3, occupied) |
+           rayAttacks(pos, 5, occupied) | rayAttacks(pos, 7, occupied);
+  }
+
+  static inline Bitboard rookAttacks(int const pos, Bitboard const occupied)
+  {
+    return rayAttacks(pos, 0, occupied) | rayAttacks(pos, 2, occupied) |
+           rayAttacks(pos, 4, occupied) | rayAttacks(pos, 6, occupied);
+  }
+
+  static inline Bitboard queenAttacks(int const pos, Bitboard const occupied)
+  {
+    return bishopAttacks(pos, occupied) | rookAttacks(pos, occupied);
+  }
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef CHESSCLOCK_H
+#define CHESSCLOCK_H
+
+#include <stdint.h>
+#include <chrono>
+#include <string>
+
+#include "piece.h"
+#include "timemanager.h"
+
+/**
+ * @brief ChessClock class for the clocks of both colors of a game, in milliseconds
+ *
+ * Only the clock of the color to move runs. After a move the increment is added to
+ * the clock of the color that moved and the clock of the other color is started.
+ * A clock set up with no time is disabled and never runs out.
+ */
+class ChessClock
+{
+public:
+    ChessClock();
+
+    /**
+     * @brief sets up both clocks with the same time, the clocks are stopped
+     *
+     * @param time starting time of each color, 0 to play without a clock
+     * @param increment time added after every move
+     */
+    void set(int64_t const time, int64_t const increment);
+
+    /**
+     * @brief sets the clocks back to their starting time, the clocks are stopped
+     */
+    void reset();
+
+    bool isEnabled() const;
+
+    /**
+     * @brief starts the clock of a color, the other clock is stopped
+     */
+    void start(Piece::Color const color);
+
+    void stop();
+
+    /**
+     * @brief adds the increment to the clock of the color that moved and starts the other clock
+     */
+    void switchTurn();
+
+    /**
+     * @brief getter for the remaining time of a color, including the time running now
+     */
+    int64_t getRemaining(Piece::Color const color) const;
+
+    bool isOutOfTime(Piece::Color const color) const;
+
+    /**
+     * @brief getter for the clocks as passed to the players
+     */
+    TimeControl getTimeControl() const;
+
+    /**
+     * @brief formats a time as minutes and seconds, with tenths of a second below ten seconds
+     */
+    static std::string timeToString(int64_t const time);
+
+private:
+    int64_t startingTime;
+    int64_t increment;
+    int64_t remaining[2];
+
+    bool isRunning;
+    Piece::Color turn;
+    std::chrono::steady_clock::time_point turnStart;
+};
+
+#endif
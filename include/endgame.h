@@ -0,0 +1,91 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "score.h"
+#include "piece.h"
+
+#define DEFAULT_MATERIAL_HASH_SIZE_KB 64
+
+/* scale factors, the evaluation is multiplied by the factor over SCALE_FACTOR_NORMAL */
+#define SCALE_FACTOR_NORMAL 64
+#define SCALE_FACTOR_DRAW 0
+
+/* score of an endgame that is won with correct play, well below the mate scores */
+#define SCORE_KNOWN_WIN 10000
+
+class Game;
+
+/**
+ * @brief namespace for the endgames that the generic evaluation misjudges
+ *
+ * An evaluation function replaces the evaluation of a material signature, a scaling
+ * function scales it down when the side that is ahead cannot make progress. Both get
+ * the strong side, the side with the extra material, and evaluation functions return
+ * their score from its point of view.
+ */
+namespace Endgames
+{
+  typedef Score (*EvaluationFunction)(Game &game, Piece::Color const strongSide);
+  typedef int (*ScalingFunction)(Game &game, Piece::Color const strongSide);
+
+  /**
+   * @brief material key of a signature such as "KBNK", the white pieces come first,
+   *          each side starts with its king
+   */
+  uint64_t materialKeyOf(std::string const &signature);
+};
+
+/**
+ * @brief struct for the endgame functions that apply to a material key
+ *
+ * key: material key of the entry, only valid if isValid is set
+ * evaluation: specialized evaluation, nullptr if the generic evaluation is used
+ * strongSide: side the evaluation function is called for
+ * scaling: scaling function for when each color is ahead, indexed by color
+ *          (see Piece::getColorIndex), nullptr if the evaluation is not scaled
+ */
+struct MaterialEntry
+{
+  uint64_t key;
+  bool isValid;
+  Endgames::EvaluationFunction evaluation;
+  Piece::Color strongSide;
+  Endgames::ScalingFunction scaling[2];
+};
+
+/**
+ * @brief Material hash table caching which endgame functions apply to a material key
+ *
+ * The material changes far less often than the position, so the registry of endgames
+ * is only consulted on a miss. Like the pawn hash table, every search thread has a
+ * table of its own.
+ */
+class MaterialHashTable
+{
+public:
+  MaterialHashTable(size_t const sizeKB = DEFAULT_MATERIAL_HASH_SIZE_KB);
+
+  /**
+   * @brief resizes the table, which also clears it
+   *
+   * @param sizeKB size of the table in kilobytes
+   */
+  void resize(size_t const sizeKB);
+
+  void clear();
+
+  /**
+   * @brief looks up the endgame functions of the material of a game, the entry is
+   *          filled in from the registry if it does not hold the material yet
+   */
+  MaterialEntry const &probe(Game &game);
+
+private:
+  std::vector<MaterialEntry> entries;
+};
+
+#endif
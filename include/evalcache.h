@@ -0,0 +1,53 @@
+#ifndef EVALCACHE_H
+#define EVALCACHE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+#include "score.h"
+
+#define DEFAULT_EVAL_CACHE_SIZE_MB 4
+
+/**
+ * @brief Evaluation cache shared by all search threads
+ *
+ * The cache is a direct-mapped array of slots indexed by the Zobrist key.
+ * Each slot is a single relaxed atomic holding the upper 48 bits of the key
+ * and the 16 bit score, so a slot can never be read half written and
+ * no locks are needed.
+ */
+class EvalCache
+{
+public:
+  EvalCache(size_t const sizeMB = DEFAULT_EVAL_CACHE_SIZE_MB);
+
+  /**
+   * @brief resizes the cache, which also clears it
+   *
+   * @param sizeMB size of the cache in megabytes
+   */
+  void resize(size_t const sizeMB);
+
+  void clear();
+
+  /**
+   * @brief looks up the evaluation of a position
+   *
+   * @param key Zobrist key of the position
+   * @param score score that is filled in if the position is found
+   * @return true if the position is found, otherwise false
+   */
+  bool probe(uint64_t const key, Score &score) const;
+
+  /**
+   * @brief stores the evaluation of a position, replacing whatever was in its slot
+   */
+  void store(uint64_t const key, Score const score);
+
+private:
+  std::unique_ptr<std::atomic<uint64_t>[]> slots;
+  size_t numOfSlots;
+};
+
+#endif
@@ -0,0 +1,245 @@
+#ifndef EVALUATIONWEIGHTS_H
+#define EVALUATIONWEIGHTS_H
+
+#include <string>
+#include <vector>
+
+#include "score.h"
+#include "piece.h"
+#include "direction.h"
+
+#define DEFAULT_PARAMETER_FILE "eval.params"
+#define MAX_TRACE_ENTRIES 512
+
+/**
+ * @brief weights of the evaluation terms besides the material and placement tables,
+ *          with a middlegame and an endgame weight each
+ *
+ * passedPawn is indexed by the rank of the pawn as seen from its own side, from 0 to 7.
+ * The pawn shield counts the pawns on the files of the king and next to it, one or two
+ * ranks in front of the king, and the files without own pawns among those files.
+ * The mobility tables are indexed by the number of attacked positions that are neither
+ * occupied by own pieces nor attacked by enemy pawns, up to the most a piece can attack.
+ */
+struct EvaluationWeights
+{
+  TaperedScore doubledPawn = makeTaperedScore(-20, -40);
+  TaperedScore isolatedPawn = makeTaperedScore(-15, -20);
+  TaperedScore backwardPawn = makeTaperedScore(-10, -15);
+  TaperedScore passedPawn[BOARD_LENGTH] = {
+      makeTaperedScore(0, 0), makeTaperedScore(5, 10), makeTaperedScore(5, 15), makeTaperedScore(10, 25),
+      makeTaperedScore(20, 45), makeTaperedScore(35, 70), makeTaperedScore(60, 110), makeTaperedScore(0, 0)};
+  TaperedScore shieldPawn = makeTaperedScore(15, 0);
+  TaperedScore shieldPawnAdvanced = makeTaperedScore(8, 0);
+  TaperedScore kingSemiOpenFile = makeTaperedScore(-20, 0);
+  TaperedScore rookOpenFile = makeTaperedScore(20, 10);
+  TaperedScore rookSemiOpenFile = makeTaperedScore(10, 5);
+  TaperedScore knightMobility[9] = {
+      makeTaperedScore(-30, -40), makeTaperedScore(-20, -28), makeTaperedScore(-5, -15), makeTaperedScore(0, -8),
+      makeTaperedScore(5, 2), makeTaperedScore(10, 6), makeTaperedScore(15, 9), makeTaperedScore(18, 10),
+      makeTaperedScore(20, 12)};
+  TaperedScore bishopMobility[14] = {
+      makeTaperedScore(-25, -30), makeTaperedScore(-10, -10), makeTaperedScore(8, -3), makeTaperedScore(13, 6),
+      makeTaperedScore(18, 11), makeTaperedScore(24, 18), makeTaperedScore(27, 24), makeTaperedScore(30, 26),
+      makeTaperedScore(32, 30), makeTaperedScore(35, 33), makeTaperedScore(38, 35), makeTaperedScore(40, 37),
+      makeTaperedScore(42, 39), makeTaperedScore(45, 40)};
+  TaperedScore rookMobility[15] = {
+      makeTaperedScore(-30, -38), makeTaperedScore(-12, -8), makeTaperedScore(-5, 5), makeTaperedScore(-3, 10),
+      makeTaperedScore(0, 16), makeTaperedScore(4, 20), makeTaperedScore(6, 24), makeTaperedScore(9, 28),
+      makeTaperedScore(12, 30), makeTaperedScore(13, 32), makeTaperedScore(14, 35), makeTaperedScore(15, 36),
+      makeTaperedScore(18, 38), makeTaperedScore(20, 39), makeTaperedScore(22, 40)};
+  TaperedScore queenMobility[28] = {
+      makeTaperedScore(-15, -20), makeTaperedScore(-8, -10), makeTaperedScore(-2, -5), makeTaperedScore(-2, 0),
+      makeTaperedScore(2, 5), makeTaperedScore(7, 10), makeTaperedScore(9, 15), makeTaperedScore(12, 18),
+      makeTaperedScore(14, 20), makeTaperedScore(16, 22), makeTaperedScore(18, 24), makeTaperedScore(20, 26),
+      makeTaperedScore(21, 28), makeTaperedScore(22, 30), makeTaperedScore(23, 31), makeTaperedScore(24, 32),
+      makeTaperedScore(25, 33), makeTaperedScore(26, 34), makeTaperedScore(27, 35), makeTaperedScore(28, 36),
+      makeTaperedScore(29, 37), makeTaperedScore(30, 38), makeTaperedScore(31, 39), makeTaperedScore(32, 40),
+      makeTaperedScore(33, 41), makeTaperedScore(34, 42), makeTaperedScore(35, 43), makeTaperedScore(36, 44)};
+};
+
+/**
+ * @brief tunable parameter of the evaluation, either a pair of middlegame and endgame
+ *          values in separate tables (the piece-square tables) or a tapered score
+ *          (the evaluation weights)
+ */
+struct EvalParameter
+{
+  std::string name;
+  Score *middlegame = nullptr;
+  Score *endgame = nullptr;
+  TaperedScore *tapered = nullptr;
+
+  Score getMiddlegame() const
+  {
+    return tapered ? getMiddlegameScore(*tapered) : *middlegame;
+  }
+
+  Score getEndgame() const
+  {
+    return tapered ? getEndgameScore(*tapered) : *endgame;
+  }
+
+  void set(Score const middlegameValue, Score const endgameValue)
+  {
+    if (tapered)
+    {
+      *tapered = makeTaperedScore(middlegameValue, endgameValue);
+      return;
+    }
+    *middlegame = middlegameValue;
+    *endgame = endgameValue;
+  }
+
+  /**
+   * @brief address that identifies the parameter in an evaluation trace
+   */
+  void const *getAddress() const
+  {
+    return tapered ? static_cast<void const *>(tapered) : static_cast<void const *>(middlegame);
+  }
+};
+
+/**
+ * @brief namespace for reading and writing the evaluation parameters
+ *
+ * A parameter file has one parameter per line, its name followed by the middlegame
+ * and the endgame value. Empty lines and lines starting with '#' are skipped.
+ */
+namespace EvalParameters
+{
+  /**
+   * @brief lists all tunable parameters, the piece values and piece-square tables
+   *          of PieceSquareTable followed by the given weights
+   */
+  std::vector<EvalParameter> getParameters(EvaluationWeights &weights);
+
+  /**
+   * @brief loads a parameter file into the piece-square tables and the given weights,
+   *          parameters missing from the file keep their value
+   *
+   * @return true if the file is read, otherwise false and nothing is changed
+   */
+  bool load(std::string const &path, EvaluationWeights &weights);
+
+  /**
+   * @brief loads a parameter file into the piece-square tables and the weights new
+   *          engines start with, main calls it once before the first game is created
+   *          since games keep the sums of the tables they were created with
+   *
+   * @return true if the file is read, otherwise false and the defaults are kept
+   */
+  bool loadStartupParameters(std::string const &path);
+
+  /**
+   * @brief getter for the weights new engines start with, the defaults of
+   *          EvaluationWeights unless a parameter file was loaded at startup
+   */
+  EvaluationWeights const &getStartupWeights();
+
+  /**
+   * @brief writes the piece-square tables and the given weights to a parameter file
+   *
+   * @return true if the file is written, otherwise false
+   */
+  bool save(std::string const &path, EvaluationWeights &weights);
+};
+
+/**
+ * @brief Enum for the terms of the evaluation, used to group the entries of a trace
+ */
+enum EvalTerm
+{
+  TERM_MATERIAL,
+  TERM_PLACEMENT,
+  TERM_MOBILITY,
+  TERM_PAWNS,
+  TERM_KING_SHIELD,
+  TERM_ROOKS,
+  NUM_OF_EVAL_TERMS
+};
+
+/**
+ * @brief trace that records nothing, the evaluation is instantiated with it
+ *          for the search so tracing costs nothing there
+ */
+struct NoTrace
+{
+  static constexpr bool isEnabled = false;
+
+  void add(EvalTerm, Piece::Color, TaperedScore const &, int) {}
+
+  void add(EvalTerm, Piece::Color, Score const &, Score const &, int) {}
+};
+
+/**
+ * @brief trace that records every weight the evaluation uses, how often and for which color
+ *
+ * The evaluation from white's point of view is the sum of the weights times their count,
+ * negated for black. The entries are kept in a fixed array so tracing does not allocate.
+ */
+struct EvalTrace
+{
+  static constexpr bool isEnabled = true;
+
+  /**
+   * parameter: address of the weight, see EvalParameter::getAddress
+   * weight: value of the weight when it was used
+   */
+  struct Entry
+  {
+    EvalTerm term;
+    Piece::Color color;
+    void const *parameter;
+    TaperedScore weight;
+    int count;
+  };
+
+  Entry entries[MAX_TRACE_ENTRIES];
+  int numOfEntries = 0;
+
+  void add(EvalTerm const term, Piece::Color const color, TaperedScore const &weight, int const count)
+  {
+    if (count != 0 && numOfEntries < MAX_TRACE_ENTRIES)
+    {
+      entries[numOfEntries++] = {term, color, &weight, weight, count};
+    }
+  }
+
+  void add(EvalTerm const term, Piece::Color const color, Score const &middlegameWeight, Score const &endgameWeight, int const count)
+  {
+    if (count != 0 && numOfEntries < MAX_TRACE_ENTRIES)
+    {
+      entries[numOfEntries++] = {term, color, &middlegameWeight, makeTaperedScore(middlegameWeight, endgameWeight), count};
+    }
+  }
+
+  void clear()
+  {
+    numOfEntries = 0;
+  }
+
+  /**
+   * @brief sum of the weights of a term for a color, from the point of view of that color
+   */
+  TaperedScore getTermScore(EvalTerm const term, Piece::Color const color) const
+  {
+    TaperedScore score = 0;
+    for (int i = 0; i < numOfEntries; i++)
+    {
+      if (entries[i].term == term && entries[i].color == color)
+      {
+        score += entries[i].weight * entries[i].count;
+      }
+    }
+    return score;
+  }
+
+  /**
+   * @brief table of the middlegame and endgame score of every term for both colors,
+   *          with the totals tapered by the given phase
+   */
+  std::string toString(int const phase) const;
+};
+
+#endif
@@ -9,6 +9,10 @@
 #include "position.h"
 #include "direction.h"
 #include "logger.h"
+#include "zobrist.h"
+#include "bitboard.h"
+#include "piecesquaretable.h"
+#include "nnue.h"
 
 #define STANDARD_OPENING_FEN "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq -"
 
@@ -44,6 +48,12 @@ public:
      */
     Game(Game const &game);
 
+    /**
+     * @brief copy assignment, copies the same as the copy constructor
+     *
+     * @param game game to copy
+     */
+    Game &operator=(Game const &game);
     ~Game() = default;
 
     /**
@@ -88,6 +98,94 @@ public:
      */
     Piece::Type getPieceAtPos(Position const pos);
 
+    /**
+     * @brief getter for the Zobrist key of the game, which is updated
+     *          incrementally on every move
+     */
+    uint64_t getZobristKey();
+
+    /**
+     * @brief getter for the Zobrist key of only the pawns, kept up to date on every move
+     */
+    uint64_t getPawnKey();
+
+    /**
+     * @brief getter for the material key of the game, which only depends on the number
+     *          of pieces of each type, kept up to date on every move
+     */
+    uint64_t getMaterialKey();
+
+    /**
+     * @brief getter for the bitboard of all positions of a colored piece
+     */
+    Bitboard getPieceBitboard(Piece::Type const piece);
+
+    /**
+     * @brief getter for the bitboard of all positions occupied by a color
+     */
+    Bitboard getColorBitboard(Piece::Color const color);
+
+    Bitboard getOccupiedBitboard();
+
+    /**
+     * @brief getter for the material balance, kept up to date on every move
+     *
+     * @return sum of the material values of the white pieces minus those of the black pieces
+     */
+    TaperedScore getMaterialScore();
+
+    /**
+     * @brief getter for the piece-square balance, kept up to date on every move
+     *
+     * @return sum of the placement bonuses of the white pieces minus those of the black pieces
+     */
+    TaperedScore getPlacementScore();
+
+    /**
+     * @brief recomputes the material and piece-square balances from the board, for
+     *          when the piece values or piece-square tables have changed
+     */
+    void refreshTableScores();
+
+    /**
+     * @brief getter for the game phase, kept up to date on every move
+     *
+     * @return PHASE_MAX with the non-pawn material of the starting position, down to 0 with none
+     */
+    int getPhase();
+
+    /**
+     * @brief getter for the first layer sums of the network evaluation, kept up to date
+     *          on every move while a network is loaded and recomputed here if they are not
+     */
+    NNUE::Accumulator const &getAccumulator();
+
+    /**
+     * @brief gets the pieces of both colors that attack a position
+     *
+     * @param pos position to get the attackers of
+     * @param occupied occupied positions, sliders can see through positions left out of it
+     * @return bitboard of the positions of the attackers
+     */
+    Bitboard getAttackersToPos(Position const pos, Bitboard const occupied);
+
+    /**
+     * @brief checks if a move captures a piece, en passant included
+     */
+    bool isCapture(Move const &move);
+
+    /**
+     * @brief static exchange evaluation, the material balance of the sequence of
+     *          captures on the destination of a move when both sides always recapture
+     *          with their least valuable attacker and may stop capturing at any point
+     *
+     * Sliders behind an attacker that has captured (x-rays) join the exchange.
+     *
+     * @param move move that starts the exchange
+     * @return material gained by the player making the move, negative if it loses material
+     */
+    int staticExchangeEvaluation(Move const &move);
+
     /**
      * @brief gets all pieces of a given color
      *
@@ -122,6 +220,12 @@ public:
      */
     void makeMove(Move const move);
 
+    /**
+     * @brief FEN-notation of the game without the move clocks: the board, turn,
+     *          castling and en passant, the fields initGameFromFENString reads
+     */
+    std::string getFEN();
+
     /**
      * @brief prints the current game of the board to stdout for debugging
      */
@@ -150,6 +254,28 @@ private:
      */
     void initGame();
 
+    /**
+     * @brief puts a piece on an empty position and updates the Zobrist key,
+     *          bitboards and evaluation sums
+     */
+    void putPiece(Position const pos, Piece::Type const piece);
+
+    /**
+     * @brief removes the piece at a position, if any, and updates the Zobrist key,
+     *          bitboards and evaluation sums
+     */
+    void removePiece(Position const pos);
+
+    /**
+     * @brief Zobrist key of the castling rights and en passant position
+     */
+    uint64_t getStateKey();
+
+    /**
+     * @brief computes the Zobrist key of the game from scratch
+     */
+    uint64_t computeZobristKey();
+
     /* Chess game data */
     Piece::Type board[BOARD_SIZE];
     Piece::Color turn;
@@ -161,8 +287,18 @@ private:
     Position whiteKingPos;
     Position blackKingPos;
 
+    uint64_t zobristKey;
+    uint64_t pawnKey;
+    uint64_t materialKey;
+    Bitboard pieceBitboards[NUM_OF_PIECE_TYPES];
+    Bitboard colorBitboards[2];
+    TaperedScore materialScore;
+    TaperedScore placementScore;
+    int phase;
+    NNUE::Accumulator accumulator;
+
     int moveCounter;
     Result result;
 };
 
-#endif
\ No newline at end of file
+#endif
\ No newline at end of file
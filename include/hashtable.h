@@ -0,0 +1,23 @@
+#ifndef HASHTABLE_H
+#define HASHTABLE_H
+
+#include <stddef.h>
+
+/**
+ * @brief namespace for what the hash tables of the engine have in common
+ */
+namespace HashTables
+{
+  /**
+   * @brief largest power of two that is at most n, and 1 for 0
+   *
+   * The tables round their number of entries down to it so the index of a key can be
+   * masked out of the key instead of taken modulo the size.
+   */
+  static inline size_t floorPowerOfTwo(size_t const n)
+  {
+    return n <= 1 ? 1 : size_t(1) << (63 - __builtin_clzll(n));
+  }
+};
+
+#endif
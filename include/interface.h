@@ -5,13 +5,17 @@
 #include <SDL2/SDL_image.h>
 
 #include <stdint.h>
+#include <atomic>
+#include <future>
 #include <vector>
 
 #include "game.h"
+#include "chessclock.h"
 #include "player.h"
 #include "playerhuman.h"
 #include "playerenginerandom.h"
 #include "playerengineminimax.h"
+#include "playerenginemcts.h"
 #include "testsuite.h"
 
 #define MIN_SCREEN_WIDTH 500
@@ -67,8 +71,19 @@ public:
 
     void initiate();
 
+    /**
+     * @brief checks if the game is over and otherwise starts computing the move of
+     *          an engine player to move on a worker thread, so rendering never waits on it
+     */
     void handlePlayerTurn();
 
+    /**
+     * @brief makes the move computed by the worker thread if it is done
+     *
+     * @return true if a move was made, otherwise false
+     */
+    bool applyEngineMove();
+
     void eventHandler(SDL_Event event);
 
     void render();
@@ -98,14 +113,37 @@ private:
     bool running;
     bool gameOver;
 
+    // clocks of the game, disabled unless a time control is set in the menu
+    ChessClock clock;
+    std::string windowTitle;
+
+    // move of the engine player being computed, valid while the worker thread runs
+    std::future<Move> engineMove;
+    std::atomic<bool> stopEngine;
+
     Piece::Type dragPiece;
     int dragPieceTextureMouseX;
     int dragPieceTextureMouseY;
     Position dragPiecePos;
     std::vector<Move> dragPieceLegalMoves;
 
+    /**
+     * @brief stops the worker thread of the engine player and throws its move away,
+     *          and stops the players pondering, returns once the searches have noticed the stop
+     */
+    void cancelEngineMove();
+
+    void resetGame();
+
+    void resign();
+
     void menuGamemode(Piece::Color const color);
 
+    /**
+     * @brief asks for the time control of the game, the clocks start with the game
+     */
+    void menuClock();
+
     void menuFEN();
 
     bool menu();
@@ -131,6 +169,11 @@ private:
 
     void renderState();
 
+    /**
+     * @brief shows the remaining time of both colors if the game is played on a clock
+     */
+    void renderClock();
+
     void resizeWindow(int const height, int const width);
 
     void pickupDragPiece(int const mouseX, int const mouseY);
@@ -0,0 +1,122 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <stdint.h>
+#include <string>
+
+#include "piece.h"
+#include "direction.h"
+#include "score.h"
+
+/* network layout, 768 inputs (12 pieces on 64 positions) seen from both sides */
+#define NNUE_INPUTS (12 * BOARD_SIZE)
+#define NNUE_HIDDEN 256
+#define NNUE_LAYER2 32
+
+/* quantization, the clipped activations are in [0, NNUE_ACTIVATION_MAX] */
+#define NNUE_ACTIVATION_MAX 127
+#define NNUE_LAYER2_SHIFT 6
+#define NNUE_OUTPUT_DIVISOR 16
+
+#define NNUE_FILE_MAGIC 0x45554E4EU /* "NNUE" */
+#define NNUE_FILE_VERSION 1
+#define DEFAULT_NNUE_FILE "nnue.bin"
+
+/**
+ * @brief namespace for the efficiently updatable neural network evaluation
+ *
+ * The first layer maps the pieces on the board to a hidden layer of int16 sums,
+ * once from white's side and once from black's side with the board mirrored and
+ * the colors swapped. Since a move only changes a few pieces, the Game keeps these
+ * sums (the accumulator) up to date on every move instead of recomputing them.
+ * The two halves, the side to move first, go through a clipped ReLU into an int8
+ * layer and a single output, which run as AVX2 kernels when the processor has AVX2.
+ *
+ * The network is shared by all engines. A search holds a UsageLock while it runs, and
+ * the network cannot be loaded or unloaded while any search holds one.
+ *
+ * The network file starts with the magic, the version and the three layer sizes
+ * as uint32, followed by the little-endian parameters in this order:
+ * feature weights int16[NNUE_INPUTS][NNUE_HIDDEN], feature biases int16[NNUE_HIDDEN],
+ * layer 2 weights int8[NNUE_LAYER2][2 * NNUE_HIDDEN], layer 2 biases int32[NNUE_LAYER2],
+ * output weights int8[NNUE_LAYER2] and the output bias int32.
+ */
+namespace NNUE
+{
+  /**
+   * @brief first layer sums of a position, from white's side and from black's side
+   *
+   * generation: generation of the network the sums were computed with, 0 if they were never computed
+   */
+  struct Accumulator
+  {
+    alignas(32) int16_t values[2][NNUE_HIDDEN];
+    int generation = 0;
+  };
+
+  /**
+   * @brief keeps the network from being loaded or unloaded while it exists,
+   *          a search holds one from start to end
+   */
+  class UsageLock
+  {
+  public:
+    UsageLock();
+
+    ~UsageLock();
+
+    UsageLock(UsageLock const &) = delete;
+
+    UsageLock &operator=(UsageLock const &) = delete;
+  };
+
+  /**
+   * @brief loads a network from a file, the current network is kept if it fails
+   *          or if a search is running
+   *
+   * @param path path of the network file
+   * @return true if the network is loaded, otherwise false
+   */
+  bool load(std::string const &path);
+
+  /**
+   * @brief unloads the network, the engines fall back on their own evaluation
+   *
+   * @return true if the network is unloaded, false if a search is running
+   */
+  bool unload();
+
+  bool isLoaded();
+
+  /**
+   * @brief checks if an accumulator was computed with the loaded network,
+   *          accumulators of games from before the last load have to be refreshed
+   */
+  bool isUpToDate(Accumulator const &accumulator);
+
+  /**
+   * @brief recomputes an accumulator from the pieces on a board
+   */
+  void refreshAccumulator(Accumulator &accumulator, Piece::Type const board[BOARD_SIZE]);
+
+  /**
+   * @brief adds a piece to an accumulator that is up to date with the loaded network
+   */
+  void addPiece(Accumulator &accumulator, Piece::Type const piece, int const pos);
+
+  /**
+   * @brief removes a piece from an accumulator that is up to date with the loaded network
+   */
+  void removePiece(Accumulator &accumulator, Piece::Type const piece, int const pos);
+
+  /**
+   * @brief evaluates a position from its up to date accumulator
+   *
+   * @param accumulator accumulator of the position
+   * @param turn color of the player to move
+   * @return score from the point of view of the player to move
+   */
+  Score evaluate(Accumulator const &accumulator, Piece::Color const turn);
+};
+
+#endif
@@ -0,0 +1,133 @@
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "move.h"
+
+#define DEFAULT_BOOK_FILE "book.bin"
+
+/* size of an entry in a Polyglot file */
+#define BOOK_ENTRY_SIZE 16
+
+class Game;
+
+/**
+ * @brief struct for an entry of a Polyglot book, stored big-endian in the file
+ *
+ * key: key of the position (see OpeningBook::getKey)
+ * move: move in the Polyglot encoding (see OpeningBook::encodeMove)
+ * weight: how good or how often played the move is, relative to the other moves of the position
+ * learn: learning data, not used
+ */
+struct BookEntry
+{
+  uint64_t key;
+  uint16_t move;
+  uint16_t weight;
+  uint32_t learn;
+};
+
+/**
+ * @brief struct for a legal move of a game found in a book
+ */
+struct BookMove
+{
+  Move move;
+  uint16_t weight;
+};
+
+/**
+ * @brief how a move is picked from the moves a book has for a position
+ *
+ * WEIGHTED_RANDOM: at random, in proportion to the weights, so games vary
+ * BEST: the move with the highest weight
+ */
+enum class BookSelection
+{
+  WEIGHTED_RANDOM,
+  BEST
+};
+
+/**
+ * @brief OpeningBook class for reading opening books in the Polyglot format
+ *
+ * The file is mapped into memory read-only and the entries, sorted by key, are found
+ * by binary search, so opening a book costs no reading and a lookup only touches
+ * the pages it needs.
+ *
+ * Positions are hashed with the published Polyglot keys (see Polyglot::keys), so books
+ * made by other tools and by the book builder can be read alike.
+ */
+class OpeningBook
+{
+public:
+  OpeningBook();
+
+  ~OpeningBook();
+
+  OpeningBook(OpeningBook const &) = delete;
+
+  OpeningBook &operator=(OpeningBook const &) = delete;
+
+  /**
+   * @brief maps a book file, a book that was open is closed first
+   *
+   * @param path path of the book file
+   * @return true if the book is opened, otherwise false and no book is open
+   */
+  bool open(std::string const &path);
+
+  void close();
+
+  bool isOpen() const;
+
+  size_t getNumOfEntries() const;
+
+  /**
+   * @brief finds the legal moves the book has for a game, highest weight first
+   */
+  std::vector<BookMove> getMoves(Game &game) const;
+
+  /**
+   * @brief picks a move from the book for a game
+   *
+   * @param game game to find a move for
+   * @param selection how the move is picked
+   * @param move move that is filled in if the book has one
+   * @return true if the book has a move for the game, otherwise false
+   */
+  bool probe(Game &game, BookSelection const selection, Move &move);
+
+  /**
+   * @brief key of a game as used in books, the Polyglot key of the game
+   */
+  static uint64_t getKey(Game &game);
+
+  /**
+   * @brief encodes a move in 16 bits: the to file and row, the from file and row in
+   *          3 bits each and the promotion piece, castling is encoded as the king
+   *          capturing its own rook
+   */
+  static uint16_t encodeMove(Move const &move);
+
+  /**
+   * @brief decodes a move of a book for a game
+   *
+   * @return true if the move is legal in the game, otherwise false
+   */
+  static bool decodeMove(Game &game, uint16_t const bookMove, Move &move);
+
+private:
+  unsigned char const *data;
+  size_t mappedSize;
+  size_t numOfEntries;
+  std::mt19937_64 random;
+
+  BookEntry readEntry(size_t const index) const;
+};
+
+#endif
@@ -0,0 +1,67 @@
+#ifndef PAWNHASHTABLE_H
+#define PAWNHASHTABLE_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "score.h"
+#include "bitboard.h"
+
+#define DEFAULT_PAWN_HASH_SIZE_KB 1024
+
+/**
+ * @brief struct for the cached evaluation of a pawn structure,
+ *          the arrays are indexed by color (see Piece::getColorIndex)
+ *
+ * key: pawn key of the structure, only valid if isValid is set
+ * score: doubled, isolated, backward and passed pawns from white's point of view
+ * pawnAttacks: positions attacked by the pawns
+ * semiOpenColumns: bit i is set if column i has no pawns of the color
+ * kingPos, kingShield: score of the pawn shield of the king of each color, from the
+ *          point of view of that color, cached for the king position it was computed for
+ */
+struct PawnEntry
+{
+  uint64_t key;
+  bool isValid;
+  TaperedScore score;
+  Bitboard pawnAttacks[2];
+  uint8_t semiOpenColumns[2];
+  int kingPos[2];
+  TaperedScore kingShield[2];
+};
+
+/**
+ * @brief Pawn hash table caching the evaluation of pawn structures
+ *
+ * The pawn structure rarely changes between the nodes of a search, so most
+ * lookups hit. The table is direct-mapped and is not shared, every search
+ * thread has a table of its own.
+ */
+class PawnHashTable
+{
+public:
+  PawnHashTable(size_t const sizeKB = DEFAULT_PAWN_HASH_SIZE_KB);
+
+  /**
+   * @brief resizes the table, which also clears it
+   *
+   * @param sizeKB size of the table in kilobytes
+   */
+  void resize(size_t const sizeKB);
+
+  void clear();
+
+  /**
+   * @brief getter for the entry a pawn key maps to
+   *
+   * @param pawnKey pawn key of the structure
+   * @return the entry, which holds the structure if it is valid and its key equals pawnKey
+   */
+  PawnEntry &getEntry(uint64_t const pawnKey);
+
+private:
+  std::vector<PawnEntry> entries;
+};
+
+#endif
@@ -159,6 +159,57 @@ namespace Piece
     return static_cast<Piece::Type>(static_cast<uint8_t>(piece) & 0b00111111);
   };
 
+  /**
+   * @brief getter for the index of a colored piece, used to index tables per piece
+   *
+   * @param piece colored piece to get the index of
+   * @return 0-5 for the white pawn to king, 6-11 for the black pawn to king
+   */
+  static inline int getPieceIndex(Piece::Type const piece)
+  {
+    return __builtin_ctz(getPieceTypeWithoutColor(piece)) + (getColorOfPiece(piece) == Color::BLACK ? 6 : 0);
+  };
+
+  /**
+   * @brief getter for the index of a color, 0 for white and 1 for black
+   */
+  static inline int getColorIndex(Color const color)
+  {
+    return color == Color::WHITE ? 0 : 1;
+  };
+
+  static inline Color getOppositeColor(Color const color)
+  {
+    return color == Color::WHITE ? Color::BLACK : Color::WHITE;
+  };
+
+  /**
+   * @brief getter for the material value of a piece, used to judge exchanges
+   *
+   * @param piece piece to get the value of, with or without color
+   * @return value of the piece, the king is worth more than all other pieces together
+   */
+  static inline int getPieceValue(Piece::Type const piece)
+  {
+    switch (getPieceTypeWithoutColor(piece))
+    {
+    case PAWN:
+      return 100;
+    case KNIGHT:
+      return 300;
+    case BISHOP:
+      return 300;
+    case ROOK:
+      return 500;
+    case QUEEN:
+      return 900;
+    case KING:
+      return 10000;
+    default:
+      return 0;
+    }
+  };
+
   static inline std::string colorToString(Color const color)
   {
     switch (color)
@@ -0,0 +1,78 @@
+#ifndef PIECESQUARETABLE_H
+#define PIECESQUARETABLE_H
+
+#include "piece.h"
+#include "direction.h"
+#include "score.h"
+#include "zobrist.h"
+
+#define NUM_OF_PIECE_KINDS 6
+
+/**
+ * @brief namespace for the material values and piece-square tables of the evaluation
+ *
+ * The Game keeps the sum of these values over all its pieces up to date on every
+ * move, so the evaluation can read the material and placement scores without
+ * looking at the board. Values are in centipawns from white's point of view,
+ * black pieces count negatively.
+ *
+ * Every value has a middlegame and an endgame weight, the signed tables hold both
+ * packed in a tapered score. The phase weights measure how far the game is from
+ * the endgame by the non-pawn material left.
+ */
+namespace PieceSquareTable
+{
+  /**
+   * @brief value of each kind of piece, indexed from pawn to king
+   */
+  extern Score middlegamePieceValues[NUM_OF_PIECE_KINDS];
+  extern Score endgamePieceValues[NUM_OF_PIECE_KINDS];
+
+  /**
+   * @brief bonus of each kind of piece per position, indexed from pawn to king,
+   *          seen from white with a8 at index 0 so the tables read like a board
+   */
+  extern Score middlegamePlacementBonuses[NUM_OF_PIECE_KINDS][BOARD_SIZE];
+  extern Score endgamePlacementBonuses[NUM_OF_PIECE_KINDS][BOARD_SIZE];
+
+  /**
+   * @brief contribution of each kind of piece to the game phase, indexed from pawn to king,
+   *          the pieces of the starting position add up to PHASE_MAX
+   */
+  extern int phaseWeights[NUM_OF_PIECE_KINDS];
+
+  /**
+   * @brief signed material value per colored piece, derived from the piece values
+   */
+  extern TaperedScore material[NUM_OF_PIECE_TYPES];
+
+  /**
+   * @brief signed placement bonus per colored piece and position, derived from
+   *          the placement bonuses with the positions mirrored for black
+   */
+  extern TaperedScore placement[NUM_OF_PIECE_TYPES][BOARD_SIZE];
+
+  /**
+   * @brief computes the signed tables, main calls it before the first game is created
+   *          and it is called again after the piece values or placement bonuses
+   *          changed, games created before keep their old sums
+   */
+  void init();
+
+  static inline TaperedScore getMaterial(Piece::Type const piece)
+  {
+    return material[Piece::getPieceIndex(piece)];
+  }
+
+  static inline TaperedScore getPlacement(Piece::Type const piece, int const pos)
+  {
+    return placement[Piece::getPieceIndex(piece)][pos];
+  }
+
+  static inline int getPhaseWeight(Piece::Type const piece)
+  {
+    return phaseWeights[Piece::getPieceIndex(piece) % NUM_OF_PIECE_KINDS];
+  }
+};
+
+#endif
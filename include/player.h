@@ -1,8 +1,11 @@
 #ifndef PLAYER_H
 #define PLAYER_H
 
+#include <atomic>
+
 #include "move.h"
 #include "game.h"
+#include "timemanager.h"
 class Player
 {
 public:
@@ -11,6 +14,33 @@ public:
   virtual Move getMove(Game game) = 0;
 
   virtual bool isHuman() const { return false; };
+
+  /**
+   * @brief sets a flag another thread can set to make getMove return early with the
+   *          best move found so far, players that answer instantly ignore it
+   */
+  void setStopFlag(std::atomic<bool> const *stop) { stopFlag = stop; };
+
+  /**
+   * @brief sets the clocks for the next getMove, players that do not manage time ignore them
+   */
+  void setTimeControl(TimeControl const &control) { timeControl = control; };
+
+  /**
+   * @brief starts thinking on the opponent's time, players that do not ponder ignore it
+   *
+   * @param game game after the move of the player, with the opponent to move
+   */
+  virtual void startPondering(Game) {};
+
+  /**
+   * @brief stops thinking on the opponent's time and waits until it has stopped
+   */
+  virtual void stopPondering() {};
+
+protected:
+  std::atomic<bool> const *stopFlag = nullptr;
+  TimeControl timeControl;
 };
 
 #endif
\ No newline at end of file
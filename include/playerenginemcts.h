@@ -0,0 +1,188 @@
+#ifndef PLAYERENGINEMCTS_H
+#define PLAYERENGINEMCTS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "player.h"
+#include "playerengineminimax.h"
+
+/* simulations per move when the game is played without clocks */
+#define MCTS_DEFAULT_SIMULATIONS 20000
+
+/* memory of the node pool, a search stops early when it runs out */
+#define MCTS_DEFAULT_POOL_SIZE_MB 64
+
+/* weight of the prior and the visits against the value in the PUCT formula */
+#define MCTS_EXPLORATION 1.5
+
+/* scores in centipawns are mapped to values in [-1, 1] by tanh(score / MCTS_VALUE_SCALE) */
+#define MCTS_VALUE_SCALE 400.0
+
+/* static exchange evaluation in centipawns that makes a move e times as likely in the priors */
+#define MCTS_PRIOR_SCALE 200.0
+
+/* the value sums are kept as fixed-point integers so they can be added atomically */
+#define MCTS_VALUE_FIXED_POINT (1 << 16)
+
+/**
+ * @brief node of the search tree, for the position after its move
+ *
+ * move: move from the position of the parent that leads to the node
+ * prior: probability of the move in the PUCT formula, from its static exchange evaluation
+ * visits: simulations that passed through the node and have been backed up
+ * virtualLosses: simulations that are passing through the node and have not been
+ *          backed up yet, counted as losses so other threads select other nodes
+ * valueSum: sum of the values of the simulations from the point of view of the
+ *          player who made the move, in MCTS_VALUE_FIXED_POINT
+ * firstChild, numOfChildren: children in the node pool, they are allocated together
+ * terminalValue: value of an expanded node without children for the player to move,
+ *          -1 if it is checkmated and 0 for a draw
+ * state: whether the children have been generated, see MCTSNode::State
+ */
+struct MCTSNode
+{
+  enum State : uint8_t
+  {
+    UNEXPANDED,
+    EXPANDING,
+    EXPANDED
+  };
+
+  Move move;
+  float prior = 0;
+  std::atomic<uint32_t> visits{0};
+  std::atomic<uint32_t> virtualLosses{0};
+  std::atomic<int64_t> valueSum{0};
+  uint32_t firstChild = 0;
+  uint32_t numOfChildren = 0;
+  float terminalValue = 0;
+  std::atomic<uint8_t> state{UNEXPANDED};
+};
+
+/**
+ * @brief MCTSNodePool class, an arena the nodes of a search are allocated from
+ *
+ * Allocating is a single atomic addition, so the threads never wait for each other,
+ * and the whole tree is freed at once by resetting the pool before the next search.
+ */
+class MCTSNodePool
+{
+public:
+  MCTSNodePool(size_t const sizeMB = MCTS_DEFAULT_POOL_SIZE_MB);
+
+  /**
+   * @brief allocates consecutive nodes reset to their initial state
+   *
+   * @return index of the first node, or getCapacity() if the pool is full
+   */
+  uint32_t allocate(uint32_t const count);
+
+  /**
+   * @brief frees all nodes, only while no thread is using the pool
+   */
+  void reset();
+
+  MCTSNode &operator[](uint32_t const index);
+
+  uint32_t getCapacity() const;
+
+  uint32_t getNumOfUsed() const;
+
+private:
+  std::unique_ptr<MCTSNode[]> nodes;
+  uint32_t capacity;
+  std::atomic<uint32_t> numOfUsed;
+};
+
+/**
+ * @brief PlayerEngineMCTS class, a player that searches with Monte Carlo tree search
+ *
+ * Every simulation walks down the tree by the PUCT formula, expands the leaf it ends in
+ * and backs up the value of the leaf, which is the quiescence search (or the static
+ * evaluation) of the minimax engine mapped to [-1, 1] rather than a random playout.
+ * The move played is the most visited one.
+ *
+ * The threads search one shared tree. Visits and value sums are atomic, and a thread
+ * adds a virtual loss to the nodes it passes through until its simulation is backed up,
+ * so the other threads are steered to other parts of the tree. A node is expanded by
+ * the thread that claims it, a thread that reaches a node being expanded only evaluates it.
+ */
+class PlayerEngineMCTS : public Player
+{
+public:
+  PlayerEngineMCTS();
+
+  PlayerEngineMCTS(int numSimulations);
+
+  PlayerEngineMCTS(int numSimulations, int numThreads);
+
+  Move getMove(Game game) override;
+
+  /**
+   * @brief sets the number of threads searching the tree in parallel
+   */
+  void setNumThreads(int const numThreads);
+
+  /**
+   * @brief chooses between the quiescence search and the static evaluation for the leaves
+   */
+  void setQuiescenceLeaves(bool const isQuiescence);
+
+  /**
+   * @brief getter for the number of simulations of the last search, summed over all threads
+   */
+  uint64_t getSimulations() const;
+
+private:
+  int numSimulations;
+  int numThreads;
+  bool isQuiescence;
+
+  /* scores the leaves, its hash tables and evaluation cache are shared by all threads */
+  PlayerEngineMiniMax evaluator;
+  MCTSNodePool pool;
+
+  /* one per thread */
+  std::vector<PawnHashTable> pawnHashTables;
+  std::vector<MaterialHashTable> materialHashTables;
+
+  /* state of the running search */
+  std::atomic<bool> stopSearch;
+  std::atomic<uint64_t> simulations;
+
+  /**
+   * @brief runs simulations on the tree until the search is stopped
+   *
+   * @param moveTime time of the move in milliseconds, 0 to stop after numSimulations
+   */
+  void searchTree(SearchThread &thread, Game const &root, int64_t const moveTime);
+
+  /**
+   * @brief walks from the root to a leaf, scores it and backs up its value
+   *
+   * @return false if the pool is full and the leaf could not be expanded, otherwise true
+   */
+  bool simulate(SearchThread &thread, Game const &root);
+
+  /**
+   * @brief child of a node with the highest PUCT score, counting virtual losses
+   */
+  MCTSNode &selectChild(MCTSNode &node);
+
+  /**
+   * @brief generates the children of a node and their priors
+   *
+   * @return false if the pool is full, otherwise true
+   */
+  bool expand(MCTSNode &node, Game &game, std::vector<Move> const &moves);
+
+  /**
+   * @brief value of a leaf in [-1, 1] from the point of view of the player to move
+   */
+  double evaluateLeaf(SearchThread &thread, Game &game);
+};
+
+#endif
@@ -1,10 +1,182 @@
 #ifndef PLAYERENGINEMINIMAX_H
 #define PLAYERENGINEMINIMAX_H
 
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+
 #include "player.h"
+#include "score.h"
+#include "transpositiontable.h"
+#include "pawnhashtable.h"
+#include "evalcache.h"
+#include "evaluationweights.h"
+#include "endgame.h"
+#include "bitbase.h"
+#include "tablebase.h"
+#include "timemanager.h"
+#include "openingbook.h"
 
 #define DEFAULT_MAX_DEPTH 4
 
+/* hash tables for the threads getQuietPosition runs on, which only see small searches */
+#define QUIET_POSITION_PAWN_HASH_SIZE_KB 16
+#define QUIET_POSITION_MATERIAL_HASH_SIZE_KB 4
+
+/* aspiration windows */
+#define ASPIRATION_MIN_DEPTH 3
+#define ASPIRATION_WINDOW 25
+
+/* late move reductions */
+#define LMR_MIN_DEPTH 3
+#define LMR_MIN_MOVE_INDEX 3
+
+/* the limits of a search are checked every LIMIT_CHECK_INTERVAL nodes of a thread, a power of two */
+#define LIMIT_CHECK_INTERVAL 1024
+
+/* lazy evaluation, the terms left out are assumed to be worth less than the margin */
+#define LAZY_EVAL_MARGIN 350
+
+/* shallow depth pruning, the margins are indexed by the remaining depth */
+#define PRUNING_MAX_DEPTH 3
+
+/**
+ * @brief margins of the pruning at the last plies before the horizon
+ *
+ * reverseFutility: a node is cut if the static evaluation minus the margin is at least beta
+ * futility: quiet moves are skipped if the static evaluation plus the margin is at most alpha
+ * razoring: a node is dropped into quiescence if the static evaluation plus the margin is at most alpha
+ */
+struct PruningMargins
+{
+  Score reverseFutility[PRUNING_MAX_DEPTH + 1] = {0, 120, 240, 360};
+  Score futility[PRUNING_MAX_DEPTH + 1] = {0, 150, 250, 350};
+  Score razoring[PRUNING_MAX_DEPTH + 1] = {0, 300, 500, 700};
+};
+
+/**
+ * @brief counters of a search, summed over all search threads
+ */
+struct SearchStatistics
+{
+  uint64_t nodes = 0;
+  uint64_t reverseFutilityPrunes = 0;
+  uint64_t futilityPrunes = 0;
+  uint64_t razoringPrunes = 0;
+  uint64_t pawnHashProbes = 0;
+  uint64_t pawnHashHits = 0;
+  uint64_t evalCacheProbes = 0;
+  uint64_t evalCacheHits = 0;
+  uint64_t lazyEvalProbes = 0;
+  uint64_t lazyEvalExits = 0;
+  uint64_t tablebaseHits = 0;
+
+  SearchStatistics &operator+=(SearchStatistics const &other)
+  {
+    nodes += other.nodes;
+    reverseFutilityPrunes += other.reverseFutilityPrunes;
+    futilityPrunes += other.futilityPrunes;
+    razoringPrunes += other.razoringPrunes;
+    pawnHashProbes += other.pawnHashProbes;
+    pawnHashHits += other.pawnHashHits;
+    evalCacheProbes += other.evalCacheProbes;
+    evalCacheHits += other.evalCacheHits;
+    lazyEvalProbes += other.lazyEvalProbes;
+    lazyEvalExits += other.lazyEvalExits;
+    tablebaseHits += other.tablebaseHits;
+    return *this;
+  }
+};
+
+/**
+ * @brief struct for a line found by the search
+ *
+ * score: score of the line from the point of view of the player to move at the root
+ * depth: depth of the iteration that found the line
+ * pv: principal variation, the moves both players are expected to play
+ */
+struct SearchLine
+{
+  Score score = 0;
+  int depth = 0;
+  std::vector<Move> pv;
+};
+
+/**
+ * @brief struct for the limits of a search, a limit of 0 is no limit
+ *
+ * depth: deepest iteration to search, 0 for the depth the engine was created with
+ * moveTime: time to search in milliseconds, the hard limit of a search on a clock
+ * softTime: time the search aims to use, the time manager decides when to stop starting iterations
+ * nodes: nodes to search, summed over all threads
+ * stop: flag another thread can set to stop the search, may be nullptr
+ * ponder: flag that is set while the search thinks on the opponent's time, may be nullptr,
+ *          the time and node limits only apply once it is cleared by a ponder hit
+ *          and the time is counted from then on
+ *
+ * The search always completes its first iteration, so it has a move to play.
+ */
+struct SearchLimits
+{
+  int depth = 0;
+  int64_t moveTime = 0;
+  int64_t softTime = 0;
+  uint64_t nodes = 0;
+  std::atomic<bool> const *stop = nullptr;
+  std::atomic<bool> const *ponder = nullptr;
+};
+
+/**
+ * @brief function called with the best line of every iteration the main thread completes,
+ *          with the nodes of all threads and the elapsed time in milliseconds
+ */
+typedef std::function<void(SearchLine const &line, uint64_t nodes, int64_t elapsed)> SearchInfoCallback;
+
+/**
+ * @brief state of one search thread, the main thread has id 0
+ *          and the helper threads have ids 1 and up
+ */
+struct SearchThread
+{
+  int id = 0;
+  SearchStatistics statistics;
+
+  /* nodes of the thread, published every LIMIT_CHECK_INTERVAL nodes for the node limit */
+  std::atomic<uint64_t> publishedNodes{0};
+
+  /* pawn hash table of the thread, owned by the engine so it is kept between searches */
+  PawnHashTable *pawnHashTable = nullptr;
+  MaterialHashTable *materialHashTable = nullptr;
+
+  /* number of best root moves to find lines for, only the main thread searches more than one */
+  int numLines = 1;
+
+  /* lines of the last completed iteration, best first */
+  std::vector<SearchLine> lines;
+  int completedDepth = 0;
+
+  /* root moves that already have a line in the running iteration */
+  std::vector<Move> excludedRootMoves;
+
+  /* triangular table, row ply holds the principal variation from ply onwards */
+  Move pvTable[MAX_PLY + 1][MAX_PLY + 1];
+  int pvLength[MAX_PLY + 1];
+};
+
+/**
+ * @brief move with the data used to order and prune it
+ */
+struct ScoredMove
+{
+  Move move;
+  int orderScore;
+  bool isCapture;
+
+  /* static exchange evaluation of captures and promotions, 0 for quiet moves */
+  int see;
+};
+
 class PlayerEngineMiniMax : public Player
 {
 public:
@@ -12,24 +184,358 @@ public:
 
   PlayerEngineMiniMax(int maxDepth);
 
+  PlayerEngineMiniMax(int maxDepth, int numThreads);
+
+  ~PlayerEngineMiniMax() override;
+
+  /**
+   * @brief searches the best move, if the engine pondered on the move the opponent
+   *          played (ponder hit) the ponder search is continued as the search for the
+   *          move, otherwise (ponder miss) it is stopped and the move is searched with
+   *          the transposition table it filled
+   *
+   * With a time control the search is limited by the time manager instead of the
+   * depth the engine was created with. A move from the opening book is played
+   * without searching.
+   */
   Move getMove(Game game) override;
 
+  /**
+   * @brief searches the expected reply of the opponent, the second move of the last
+   *          principal variation, on a background thread until the next getMove
+   */
+  void startPondering(Game game) override;
+
+  void stopPondering() override;
+
+  /**
+   * @brief searches the best lines of a game in one search (multi-PV), the root moves
+   *          of the lines already found are excluded when searching the next line
+   *
+   * @param game game to analyse
+   * @param numLines number of best root moves to find lines for
+   * @return the lines sorted from best to worst, fewer if there are fewer legal moves
+   */
+  std::vector<SearchLine> analyse(Game game, int const numLines);
+
+  /**
+   * @brief searches a game within limits, for front ends that decide how long to think
+   *
+   * @param game game to search
+   * @param limits limits of the search
+   * @return the best line of the last completed iteration
+   */
+  SearchLine searchWithLimits(Game game, SearchLimits const &limits);
+
+  /**
+   * @brief sets the function that is called with the best line of every completed iteration
+   */
+  void setInfoCallback(SearchInfoCallback const &callback);
+
+  /**
+   * @brief clears the transposition table, the evaluation cache and the hash tables of the threads
+   */
+  void clearHashTables();
+
+  /**
+   * @brief getter for the fill rate of the transposition table in permille
+   */
+  int getHashFull();
+
+  /**
+   * @brief sets the number of threads searching in parallel, the main thread included
+   */
+  void setNumThreads(int const numThreads);
+
+  /**
+   * @brief sets the size of the transposition table, which also clears it
+   */
+  void setHashSize(size_t const sizeMB);
+
+  /**
+   * @brief sets the size of the evaluation cache, which also clears it
+   */
+  void setEvalCacheSize(size_t const sizeMB);
+
+  /**
+   * @brief loads the network for the neural network evaluation, which then replaces
+   *          the hand-crafted evaluation for all engines
+   *
+   * @param path path of the network file
+   * @return true if the network is loaded, otherwise false and the evaluation is unchanged
+   */
+  bool loadNetwork(std::string const &path);
+
+  /**
+   * @brief opens the opening book the engine plays from before it searches
+   *
+   * @param path path of a book in the Polyglot format
+   * @return true if the book is opened, otherwise false and the engine has no book
+   */
+  bool loadBook(std::string const &path);
+
+  void setBookSelection(BookSelection const selection);
+
+  /**
+   * @brief picks a move for a game from the opening book
+   *
+   * @return true if the book has a move for the game, otherwise false
+   */
+  bool probeBook(Game game, Move &move);
+
+  EvaluationWeights &getEvaluationWeights();
+
+  /**
+   * @brief evaluates a game with the hand-crafted evaluation and records the parameters it uses
+   *
+   * @param thread thread the evaluation runs on, callers that trace many games keep one
+   * @param game game to evaluate
+   * @param trace trace the parameters are recorded in, cleared first
+   * @return score from white's point of view
+   */
+  Score traceEvaluation(SearchThread &thread, Game game, EvalTrace &trace);
+
+  /**
+   * @brief breakdown table of the hand-crafted evaluation of a game by term and color,
+   *          for debugging the evaluation and the tuning
+   */
+  std::string getEvaluationBreakdown(Game game);
+
+  /**
+   * @brief plays out the principal variation of the quiescence search of a game, so
+   *          the position left has no winning captures for the player to move
+   *
+   * @param thread thread the search runs on, with a pawn and a material hash table,
+   *          callers that search many games keep one per worker
+   */
+  Game getQuietPosition(SearchThread &thread, Game game);
+
+  /**
+   * @brief scores a game for players that search their own trees with the evaluation
+   *          of the engine, such as the Monte Carlo tree search
+   *
+   * @param thread state of the calling thread, with its own pawn and material hash tables
+   * @param game game to score
+   * @param isQuiescence true to resolve the captures with the quiescence search first,
+   *          otherwise the static evaluation is used
+   * @return score from the point of view of the player to move
+   */
+  Score scoreLeaf(SearchThread &thread, Game &game, bool const isQuiescence);
+
+  /**
+   * @brief sets the margins of the futility pruning, reverse futility pruning and razoring
+   */
+  void setPruningMargins(PruningMargins const &margins);
+
+  /**
+   * @brief getter for the number of nodes searched by all threads in the last search
+   */
+  uint64_t getNodes();
+
+  /**
+   * @brief getter for the counters of the last search, summed over all threads
+   */
+  SearchStatistics getStatistics();
+
 private:
   int maxDepth;
+  int numThreads;
+
+  /* shared by all search threads */
+  TranspositionTable transpositionTable;
+  EvalCache evalCache;
+  std::atomic<bool> stopSearch;
+
+  /* one per search thread */
+  std::vector<PawnHashTable> pawnHashTables;
+  std::vector<MaterialHashTable> materialHashTables;
+
+  OpeningBook book;
+  BookSelection bookSelection = BookSelection::WEIGHTED_RANDOM;
+
+  PruningMargins pruningMargins;
+  EvaluationWeights evaluationWeights;
+  SearchStatistics statistics;
+
+  /* state of the running search, set before the threads start */
+  SearchLimits limits;
+  std::chrono::steady_clock::time_point searchStart;
+  /* start of the move time, moved forward while pondering */
+  std::chrono::steady_clock::time_point limitStart;
+  std::vector<SearchThread> *searchThreads = nullptr;
+  SearchInfoCallback infoCallback;
+
+  /* root moves that keep the best tablebase value, empty if the root is not in the tablebases */
+  std::vector<Move> tablebaseRootMoves;
+
+  /* pondering, the expected reply is the second move of the principal variation of the last move */
+  Move ponderMove;
+  bool hasPonderMove = false;
+  uint64_t ponderKey = 0;
+  std::atomic<bool> isPondering;
+  std::atomic<bool> stopPonder;
+  std::future<std::vector<SearchLine>> ponderResult;
+
+  /**
+   * @brief evaluates the game from white's point of view, the terms are summed as
+   *          tapered scores and interpolated by the game phase
+   *
+   * Evaluations are looked up in and stored to the evaluation cache. Known endgames are
+   * evaluated by their specialized function from the material hash table, otherwise a
+   * loaded network evaluates the game instead of the hand-crafted terms. The result is
+   * scaled down in endgames the side that is ahead cannot win.
+   *
+   * The hand-crafted evaluation first sums only the incremental material and placement
+   * terms. If they are more than LAZY_EVAL_MARGIN outside the window, the other terms
+   * cannot bring the score back into it and that sum is returned as a bound instead,
+   * which is not cached.
+   *
+   * @param alpha lower bound of the window from white's point of view
+   * @param beta upper bound of the window from white's point of view
+   */
+  Score evaluateGame(SearchThread &thread, Game &game, Score const alpha = -SCORE_INFINITE, Score const beta = SCORE_INFINITE);
+
+  /**
+   * @brief sums the hand-crafted terms and interpolates them by the game phase
+   *
+   * The terms are templates on the trace, NoTrace compiles the trace calls away for
+   * the search, EvalTrace records how often each parameter is used for the tuner.
+   */
+  template <typename Trace>
+  Score evaluateHandCrafted(SearchThread &thread, Game &game, Trace &trace);
 
-  int evaluateGame(Game game);
+  /**
+   * @brief evaluates the mobility of the knights, bishops, rooks and queens from the
+   *          positions they attack, without generating their moves
+   */
+  template <typename Trace>
+  TaperedScore evaluatePieceMobility(Game &game, Trace &trace);
 
-  int evaluatePieceMobility(Game game);
+  template <typename Trace>
+  TaperedScore evaluatePiecePlacement(Game &game, Trace &trace);
 
-  int evaluatePiecePlacement(Game game);
+  /**
+   * @brief evaluates the pawn structure, the pawn shields of the kings and the rooks
+   *          on open files, the parts that only depend on the pawns come from the
+   *          pawn hash table of the thread
+   */
+  template <typename Trace>
+  TaperedScore evaluatePawnStructure(SearchThread &thread, Game &game, Trace &trace);
 
-  int evaluatePawnStructure(Game game);
+  /**
+   * @brief fills in a pawn hash table entry for the pawn structure of a game
+   */
+  template <typename Trace>
+  void evaluatePawnEntry(Game &game, PawnEntry &entry, Trace &trace);
 
-  int evaluatePieceValue(Game game);
+  /**
+   * @brief evaluates the pawn shield in front of a king from the point of view of its color
+   */
+  template <typename Trace>
+  TaperedScore evaluateKingShield(Game &game, PawnEntry const &entry, Piece::Color const color, int const kingPos, Trace &trace);
+
+  template <typename Trace>
+  TaperedScore evaluatePieceValue(Game &game, Trace &trace);
+
+  /**
+   * @brief evaluates the game from the point of view of the player to move, the
+   *          window is from that point of view as well (see evaluateGame)
+   */
+  Score evaluateForTurn(SearchThread &thread, Game &game, Score const alpha = -SCORE_INFINITE, Score const beta = SCORE_INFINITE);
 
   std::vector<Move> getAllLegalMoves(Game game);
 
-  std::pair<Move, int> miniMax(Game game, int depth, int alpha, int beta, bool isMaximizingPlayer);
+  /**
+   * @brief sets the time limits of a search for a color from the time control of the
+   *          player, a clock replaces the depth limit
+   */
+  void applyTimeControl(Piece::Color const color, SearchLimits &limits);
+
+  /**
+   * @brief runs the main thread and the helper threads on a game
+   *
+   * @param game game to search
+   * @param numLines number of lines the main thread finds
+   * @param limits limits of the search
+   * @return the lines of the last iteration completed by the main thread
+   */
+  std::vector<SearchLine> search(Game &game, int const numLines, SearchLimits const &limits = SearchLimits());
+
+  /**
+   * @brief stops the search if the main thread has run into one of the limits,
+   *          called every LIMIT_CHECK_INTERVAL nodes by every thread
+   */
+  void checkLimits(SearchThread &thread);
+
+  /**
+   * @brief finds the root moves that keep the value of a position in the tablebases
+   *          and get closest to mate, or stay farthest from it when losing
+   *
+   * @param game game at the root
+   * @return the best root moves, empty if the tablebases do not cover all root moves
+   */
+  std::vector<Move> probeRootTablebases(Game &game);
+
+  /**
+   * @brief orders the moves so the most promising ones are searched first:
+   *          the given first move, captures that do not lose material by static
+   *          exchange evaluation (best first), quiet moves, and losing captures last
+   *
+   * @param game game the moves are made in
+   * @param moves moves to order
+   * @param firstMove move to search first, e.g. the move from the transposition table
+   * @return the ordered moves with their static exchange evaluation
+   */
+  std::vector<ScoredMove> orderMoves(Game &game, std::vector<Move> const &moves, Move const &firstMove);
+
+  /**
+   * @brief searches the iterations of the iterative deepening loop, each iteration
+   *          starts with an aspiration window around the score of the previous one
+   *          and widens it when the search fails outside of it
+   *
+   * Helper threads start at a staggered depth, so that together with the shared
+   * transposition table the threads search different parts of the tree (Lazy SMP).
+   *
+   * Within an iteration the lines are searched one after the other, each
+   * excluding the root moves of the lines before it.
+   *
+   * @param thread state of the thread that searches
+   * @param game game to search
+   */
+  void iterativeDeepening(SearchThread &thread, Game &game);
+
+  /**
+   * @brief negamax principal variation search with alpha-beta pruning
+   *
+   * The first move of a node is searched with the full window, the other moves
+   * with a null window around alpha and are only re-searched if they beat alpha.
+   * Positions in the tablebases are scored by their distance to mate without a search.
+   *
+   * @param thread state of the thread that searches
+   * @param game game to search
+   * @param depth remaining depth in plies
+   * @param ply distance from the root in plies
+   * @param alpha lower bound of the window
+   * @param beta upper bound of the window
+   * @return score from the point of view of the player to move
+   */
+  Score negaMax(SearchThread &thread, Game &game, int depth, int ply, Score alpha, Score beta);
+
+  /**
+   * @brief quiescence search, only searches captures and promotions (or all
+   *          moves when in check) until the position is quiet, so the leaves are
+   *          not evaluated in the middle of an exchange
+   *
+   * Captures that lose material by static exchange evaluation are not searched.
+   *
+   * @param thread state of the thread that searches
+   * @param game game to search
+   * @param ply distance from the root in plies
+   * @param alpha lower bound of the window
+   * @param beta upper bound of the window
+   * @return score from the point of view of the player to move
+   */
+  Score quiescence(SearchThread &thread, Game &game, int ply, Score alpha, Score beta);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -1,38 +1,96 @@
 #ifndef PLAYERENGINERANDOM_H
 #define PLAYERENGINERANDOM_H
 
+#include <stdint.h>
 #include <random>
 
 #include "player.h"
 
-class PlayerEngineRandom : public Player
+/**
+ * @brief xoshiro256** generator, a few shifts and multiplications per number with a
+ *          period long enough for any number of games
+ *
+ * The state is filled from the seed by splitmix64, so any seed, zero included, gives a
+ * well mixed state and the same seed always gives the same numbers.
+ */
+class RandomGenerator
 {
 public:
-  Move getMove(Game game) override
+  RandomGenerator(uint64_t seed)
   {
-    logIt(LogLevel::INFO) << "Player Engine Random is calculating a random move";
-    std::vector<Move> allLegalMoves;
-    for (int i = 0; i < BOARD_SIZE; i++)
+    for (auto &word : state)
     {
-      std::vector<Move> legalMoves = game.getLegalMovesForPos(i);
-      if(legalMoves.size() > 0) {
-        allLegalMoves.insert(allLegalMoves.end(), legalMoves.begin(), legalMoves.end());
-      }
+      word = Zobrist::nextRandom(seed);
     }
+  }
+
+  uint64_t next()
+  {
+    uint64_t const result = rotateLeft(state[1] * 5, 7) * 9;
+    uint64_t const t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotateLeft(state[3], 45);
+    return result;
+  }
 
-    if (allLegalMoves.size() == 0)
+  /**
+   * @brief number in [0, bound) by a multiplication instead of a division, the bias
+   *          is below bound / 2^32, far too small to matter for a few hundred moves
+   */
+  uint32_t nextBelow(uint32_t const bound)
+  {
+    return static_cast<uint32_t>(((next() >> 32) * bound) >> 32);
+  }
+
+private:
+  uint64_t state[4];
+
+  static inline uint64_t rotateLeft(uint64_t const x, int const k)
+  {
+    return (x << k) | (x >> (64 - k));
+  }
+};
+
+/**
+ * @brief PlayerEngineRandom class, a player that plays a uniformly random legal move
+ *
+ * The generator lives as long as the player, so a player made with a seed plays the
+ * same moves in the same positions every time it is used.
+ */
+class PlayerEngineRandom : public Player
+{
+public:
+  PlayerEngineRandom() : PlayerEngineRandom(std::random_device()()) {}
+
+  PlayerEngineRandom(uint64_t const seed) : random(seed) {}
+
+  Move getMove(Game game) override
+  {
+    logIt(LogLevel::INFO) << "Player Engine Random is calculating a random move";
+    std::vector<Move> const legalMoves = game.getAllLegalMoves();
+    if (legalMoves.empty())
     {
       logIt(LogLevel::ERROR) << "Engine has no legal moves to make";
       throw std::runtime_error("Engine has no legal moves to make");
     }
+    return pickMove(legalMoves);
+  }
 
-    // Random number generator
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, allLegalMoves.size() - 1);
-
-    return allLegalMoves[dis(gen)];
+  /**
+   * @brief picks one of the legal moves of a position, for callers that have generated
+   *          them already, there has to be at least one
+   */
+  Move const &pickMove(std::vector<Move> const &legalMoves)
+  {
+    return legalMoves[random.nextBelow(legalMoves.size())];
   }
+
+private:
+  RandomGenerator random;
 };
 
-#endif
\ No newline at end of file
+#endif
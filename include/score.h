@@ -0,0 +1,102 @@
+#ifndef SCORE_H
+#define SCORE_H
+
+#include <stdint.h>
+#include <iostream>
+
+/* search */
+#define MAX_PLY 128
+
+/* scores */
+#define SCORE_DRAW 0
+#define SCORE_MATE 32000
+#define SCORE_INFINITE 32001
+#define SCORE_MATE_IN_MAX_PLY (SCORE_MATE - MAX_PLY)
+
+/* game phase, from PHASE_MAX with all pieces on the board down to 0 with only kings and pawns */
+#define PHASE_MAX 24
+
+/**
+ * @brief score of a position from the point of view of the player to move
+ *
+ * Scores are bounded to [-SCORE_INFINITE, SCORE_INFINITE], so unlike INT_MIN/INT_MAX
+ * they can always be negated. Scores beyond SCORE_MATE_IN_MAX_PLY encode a forced mate.
+ */
+typedef int32_t Score;
+
+/**
+ * @brief score for giving mate at a given ply from the root
+ */
+static inline Score mateIn(int const ply)
+{
+  return SCORE_MATE - ply;
+}
+
+/**
+ * @brief score for being mated at a given ply from the root
+ */
+static inline Score matedIn(int const ply)
+{
+  return -SCORE_MATE + ply;
+}
+
+static inline bool isMateScore(Score const score)
+{
+  return score >= SCORE_MATE_IN_MAX_PLY || score <= -SCORE_MATE_IN_MAX_PLY;
+}
+
+/**
+ * @brief prints a score, mate scores are printed as the number of moves until mate
+ */
+static inline std::string scoreToString(Score const score)
+{
+  if (score >= SCORE_MATE_IN_MAX_PLY)
+  {
+    return "mate in " + std::to_string((SCORE_MATE - score + 1) / 2);
+  }
+  if (score <= -SCORE_MATE_IN_MAX_PLY)
+  {
+    return "mated in " + std::to_string((SCORE_MATE + score) / 2);
+  }
+  return std::to_string(score);
+}
+
+/**
+ * @brief pair of a middlegame and an endgame score packed in one integer,
+ *          the endgame score in the upper 16 bits and the middlegame score in the lower 16 bits
+ *
+ * Tapered scores can be added, subtracted and negated like plain integers as long as
+ * both halves stay within 16 bits, so the evaluation terms are summed once for both stages.
+ */
+typedef int32_t TaperedScore;
+
+static inline TaperedScore makeTaperedScore(int const middlegame, int const endgame)
+{
+  return static_cast<TaperedScore>(static_cast<uint32_t>(endgame) << 16) + middlegame;
+}
+
+static inline Score getMiddlegameScore(TaperedScore const score)
+{
+  return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score)));
+}
+
+static inline Score getEndgameScore(TaperedScore const score)
+{
+  /* The middlegame half borrows from the endgame half when it is negative, rounding gives it back */
+  return static_cast<int16_t>(static_cast<uint16_t>(static_cast<uint32_t>(score + 0x8000) >> 16));
+}
+
+/**
+ * @brief interpolates a tapered score between its endgame and middlegame score
+ *
+ * @param score tapered score to interpolate
+ * @param phase game phase, PHASE_MAX gives the middlegame score and 0 the endgame score
+ * @return the interpolated score
+ */
+static inline Score taperScore(TaperedScore const score, int const phase)
+{
+  Score const endgame = getEndgameScore(score);
+  return endgame + (getMiddlegameScore(score) - endgame) * phase / PHASE_MAX;
+}
+
+#endif
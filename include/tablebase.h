@@ -0,0 +1,161 @@
+#ifndef TABLEBASE_H
+#define TABLEBASE_H
+
+#include <stdint.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "bitbase.h"
+
+#define TABLEBASE_FILE_MAGIC 0x42544D44U /* "DMTB" */
+#define TABLEBASE_FILE_VERSION 1
+#define TABLEBASE_FILE_EXTENSION ".dtm"
+
+/* positions per compressed block, a probe decodes the whole block it falls in */
+#define TABLEBASE_BLOCK_SIZE 8192
+
+/* decoded blocks kept by the cache shared by all tablebases */
+#define TABLEBASE_CACHE_BLOCKS 256
+
+/* blocks every thread keeps at hand without locking the shared cache, a power of two */
+#define TABLEBASE_THREAD_CACHE_BLOCKS 64
+
+/* the Huffman codes are limited in length so a code fits the decoding tables */
+#define TABLEBASE_MAX_CODE_LENGTH 15
+#define TABLEBASE_NUM_OF_SYMBOLS 256
+
+/**
+ * @brief Tablebase class for the compressed distance to mate tables of the endgames
+ *          against a lone king, with the same signatures and indexing as a Bitbase
+ *
+ * A position takes a byte: 0 if it is a draw or illegal, otherwise its distance to
+ * mate in plies plus one. Most positions of a table share a few values, so the bytes
+ * are compressed with a canonical Huffman code over the whole table, in blocks that
+ * each start on a byte so any block can be decoded on its own.
+ *
+ * The file starts with the magic, the version, the number of positions, the block size,
+ * the number of blocks and the longest distance to mate as uint32, followed by the
+ * code lengths of the 256 byte values, the offsets of the blocks as uint64 relative to
+ * the end of the offsets with one more for the end of the last block, and the blocks.
+ *
+ * The file is mapped into memory read-only. Probes decode a block at a time and keep
+ * the decoded blocks in a small LRU cache, so positions close in the index, as the
+ * positions of a search mostly are, are looked up without decoding. Every thread also
+ * remembers the blocks it used last, so most probes do not lock the shared cache.
+ */
+class Tablebase
+{
+public:
+  /**
+   * @brief tablebase of a signature with the strong side first and the lone king
+   *          last, it has to be opened before it can be probed
+   */
+  Tablebase(std::string const &signature);
+
+  ~Tablebase();
+
+  Tablebase(Tablebase const &) = delete;
+
+  Tablebase &operator=(Tablebase const &) = delete;
+
+  std::string const &getSignature() const;
+
+  /**
+   * @brief number of pieces of the tablebase, kings included
+   */
+  int getNumOfPieces() const;
+
+  /**
+   * @brief compresses the distances to mate of a generated bitbase into a file
+   */
+  static bool write(std::string const &path, Bitbase const &bitbase);
+
+  /**
+   * @brief maps a file into memory, the tablebase is closed if it fails
+   */
+  bool open(std::string const &path);
+
+  void close();
+
+  bool isOpen() const;
+
+  /**
+   * @brief looks up the value and the distance to mate of the position of a game
+   *
+   * @param distanceToMate plies until mate of a won or lost position, 0 for a draw
+   * @return true if the tablebase covers the material of the game, otherwise false
+   */
+  bool probe(Game &game, BitbaseValue &value, int &distanceToMate) const;
+
+private:
+  /* unique id of the tablebase in the keys of the block cache */
+  uint64_t id;
+
+  /* the indexing of the positions, the bitbase itself is never generated or loaded */
+  Bitbase layout;
+  int numOfPieces;
+
+  unsigned char const *data;
+  size_t mappedSize;
+  size_t numOfPositions;
+  size_t blockSize;
+  size_t numOfBlocks;
+  unsigned char const *blocks;
+
+  /* canonical Huffman decoding: the first code and the index of its symbol for every length */
+  int firstCode[TABLEBASE_MAX_CODE_LENGTH + 1];
+  int firstSymbol[TABLEBASE_MAX_CODE_LENGTH + 1];
+  int numOfCodes[TABLEBASE_MAX_CODE_LENGTH + 1];
+  uint8_t symbols[TABLEBASE_NUM_OF_SYMBOLS];
+
+  uint64_t getBlockOffset(size_t const block) const;
+
+  std::shared_ptr<std::vector<uint8_t> const> decodeBlock(size_t const block) const;
+
+  /**
+   * @brief decoded block from the shared cache, decoded and added if it is not there
+   */
+  std::shared_ptr<std::vector<uint8_t> const> getBlock(size_t const block) const;
+
+  /**
+   * @brief value byte of a position, decoded blocks come from the cache of the thread
+   */
+  uint8_t getByte(size_t const index) const;
+};
+
+/**
+ * @brief namespace for the tablebases used by the engines, loaded once and shared
+ */
+namespace Tablebases
+{
+  /**
+   * @brief path of the file of a tablebase in a directory
+   */
+  std::string getPath(std::string const &directory, std::string const &signature);
+
+  /**
+   * @brief opens all tablebase files in a directory, named by their signatures,
+   *          tablebases that were loaded before are replaced
+   *
+   * @return true if at least one tablebase is loaded, otherwise false
+   */
+  bool load(std::string const &directory);
+
+  bool isLoaded();
+
+  /**
+   * @brief most pieces of a loaded tablebase, kings included, 0 without tablebases
+   */
+  int getMaxPieces();
+
+  /**
+   * @brief looks up the value and the distance to mate of the position of a game
+   *          in the loaded tablebases
+   *
+   * @return true if a loaded tablebase covers the material of the game, otherwise false
+   */
+  bool probe(Game &game, BitbaseValue &value, int &distanceToMate);
+};
+
+#endif
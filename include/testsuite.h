@@ -2,6 +2,8 @@
 #define TEST_SUITE_H
 
 #include <iostream>
+#include <string>
+#include <unordered_map>
 
 #include "game.h"
 
@@ -10,7 +12,47 @@ class TestSuite
 public:
   void menu();
 
+  /**
+   * @brief runs the regression tests of the engine and prints the checks that fail
+   *
+   * @return true if every check passes, otherwise false
+   */
+  bool runRegressionTests();
+
 private:
+  int numOfChecks = 0;
+  int numOfFailedChecks = 0;
+
+  /**
+   * @brief counts a check of the regression tests and prints its description if it fails
+   */
+  void check(bool const isPassed, std::string const &description);
+
+  /**
+   * @brief generated bitbases against a search of one ply and the longest known mates
+   */
+  void testBitbases();
+
+  /**
+   * @brief tablebase files written from a bitbase and probed back, from several threads
+   */
+  void testTablebases();
+
+  /**
+   * @brief Polyglot keys of the example positions of the format, from FEN and from the moves
+   */
+  void testPolyglotKeys();
+
+  /**
+   * @brief Texel extraction of a few lines, the gradient against the slope of the error and a few descent steps
+   */
+  void testTexelTuning();
+
+  /**
+   * @brief perft counts of the standard test positions and static exchanges with known outcomes
+   */
+  void testMoveGeneration();
+
   void testPossiblePositions(Game game, int currentDepth, int totalDepth, std::unordered_map<int, int> &gameCounts, std::unordered_map<int, int> &checkmateCounts);
 };
 
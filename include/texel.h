@@ -0,0 +1,112 @@
+#ifndef TEXEL_H
+#define TEXEL_H
+
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "evaluationweights.h"
+#include "playerengineminimax.h"
+
+/* Adam gradient descent */
+#define TEXEL_LEARNING_RATE 1.0
+#define TEXEL_BETA1 0.9
+#define TEXEL_BETA2 0.999
+#define TEXEL_EPSILON 1e-8
+
+/**
+ * @brief how often a parameter is used in a position, white minus black
+ */
+struct Coefficient
+{
+  uint16_t index;
+  int16_t value;
+};
+
+/**
+ * @brief a quiet position with the result of its game, its coefficients are
+ *          coefficients[begin, begin + count) of the chunk it belongs to
+ *
+ * result: 1 for a white win, 0.5 for a draw and 0 for a black win
+ */
+struct TuningPosition
+{
+  double result;
+  int phase;
+  uint32_t begin;
+  uint16_t count;
+};
+
+/**
+ * @brief positions of one thread, kept in flat arrays so an epoch does not allocate
+ */
+struct Chunk
+{
+  std::vector<TuningPosition> positions;
+  std::vector<Coefficient> coefficients;
+  std::vector<double> gradient;
+  double error = 0;
+  int numOfMismatches = 0;
+};
+
+/**
+ * @brief Adam gradient descent on the parameter values, the moments live as long as the optimizer
+ */
+class AdamOptimizer
+{
+public:
+  AdamOptimizer(size_t const numOfValues);
+
+  /**
+   * @brief moves every value against its gradient, by a step that adapts to the gradients seen so far
+   */
+  void step(std::vector<double> &values, std::vector<double> const &gradient);
+
+private:
+  int numOfSteps;
+  std::vector<double> momentum;
+  std::vector<double> velocity;
+};
+
+/**
+ * @brief namespace for the Texel tuning of the hand-crafted evaluation parameters,
+ *          the tuner splits the positions into chunks and runs the functions on a chunk per thread
+ */
+namespace Texel
+{
+  /**
+   * @brief values of the parameters as middlegame and endgame value after each other,
+   *          and the index of every parameter by the address of its weight
+   */
+  std::vector<double> indexParameters(std::vector<EvalParameter> const &parameters, std::unordered_map<void const *, int> &indices);
+
+  /**
+   * @brief parses the lines of a part of a text, each a FEN and the result of its game,
+   *          each position is replaced by the leaf of its quiescence search and traced into coefficients
+   */
+  void extractPositions(PlayerEngineMiniMax &engine, std::string const &text, size_t begin, size_t const end,
+                        std::unordered_map<void const *, int> const &indices, std::vector<double> const &parameters, Chunk &chunk);
+
+  /**
+   * @brief evaluation of a position from its coefficients, white's point of view
+   */
+  double evaluate(TuningPosition const &position, Coefficient const *coefficients, std::vector<double> const &parameters);
+
+  /**
+   * @brief expected result of a position with an evaluation, for a scaling constant K
+   */
+  double sigmoid(double const K, double const eval);
+
+  /**
+   * @brief sum of the squared differences between the results and their predictions
+   */
+  void computeError(Chunk &chunk, std::vector<double> const &parameters, double const K);
+
+  /**
+   * @brief gradient of the error of the chunk, the constant factors of the derivative are left out
+   */
+  void computeGradient(Chunk &chunk, std::vector<double> const &parameters, double const K);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef TIMEMANAGER_H
+#define TIMEMANAGER_H
+
+#include <stdint.h>
+
+#include "move.h"
+#include "piece.h"
+#include "score.h"
+
+/* allocation of the remaining time, in milliseconds */
+#define TIME_DEFAULT_MOVES_TO_GO 30
+#define TIME_MOVE_OVERHEAD 50
+#define TIME_HARD_LIMIT_FACTOR 4
+#define TIME_MAX_USAGE_PERCENT 50
+
+/* an iteration takes longer than all iterations before it, so none is started past this share of the soft limit */
+#define TIME_NEW_ITERATION_PERCENT 50
+
+/* scaling of the soft limit by the stability of the search */
+#define TIME_STABLE_ITERATIONS 3
+#define TIME_STABLE_PERCENT 60
+#define TIME_BEST_MOVE_CHANGE_PERCENT 50
+#define TIME_SCORE_DROP 30
+#define TIME_SCORE_DROP_PERCENT 150
+
+/**
+ * @brief struct for the clocks of a game as seen by a player, in milliseconds
+ *
+ * time: remaining time of each color, indexed by color (see Piece::getColorIndex),
+ *          0 if the color plays without a clock
+ * increment: time added to the clock of each color after its move
+ * movesToGo: moves until the next time control, 0 if the rest of the game is played
+ *          on the remaining time
+ */
+struct TimeControl
+{
+  int64_t time[2] = {0, 0};
+  int64_t increment[2] = {0, 0};
+  int movesToGo = 0;
+};
+
+/**
+ * @brief struct for the time a search may use for a move, in milliseconds
+ *
+ * soft: time the search aims to use, scaled by the stability of the search
+ * hard: time after which the search is stopped in the middle of an iteration
+ */
+struct TimeBudget
+{
+  int64_t soft = 0;
+  int64_t hard = 0;
+};
+
+/**
+ * @brief TimeManager class that decides how long a search on a clock thinks
+ *
+ * The budget of a move is a share of the remaining time plus most of the increment.
+ * The soft limit is then scaled after every iteration: a best move that has been
+ * stable for several iterations stops the search early, a best move that keeps
+ * changing or a score that drops makes it think longer, up to the hard limit.
+ */
+class TimeManager
+{
+public:
+  /**
+   * @brief allocates the time for the move of a color from its clock
+   *
+   * @param control clocks of the game
+   * @param color color to move
+   * @return the soft and hard limit of the move
+   */
+  static TimeBudget allocate(TimeControl const &control, Piece::Color const color);
+
+  /**
+   * @brief records the best move and score of a completed iteration
+   */
+  void update(Move const &bestMove, Score const score);
+
+  /**
+   * @brief checks if a new iteration should be started, from the soft limit scaled by
+   *          the stability of the best move and the score so far
+   *
+   * @param softTime soft limit of the move
+   * @param elapsed time used for the move so far
+   */
+  bool shouldStartIteration(int64_t const softTime, int64_t const elapsed) const;
+
+private:
+  Move bestMove;
+  bool hasBestMove = false;
+  Score score = 0;
+  Score scoreDrop = 0;
+
+  /* iterations the best move has not changed */
+  int stableIterations = 0;
+
+  /* percentage added for the best move changes, halved every iteration so older changes count less */
+  int instability = 0;
+};
+
+#endif
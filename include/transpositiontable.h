@@ -0,0 +1,99 @@
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+
+#include "move.h"
+#include "score.h"
+
+#define DEFAULT_HASH_SIZE_MB 16
+
+/**
+ * @brief Enum for the kind of bound a stored score is
+ *
+ * UPPER: the search failed low, the real score is at most the stored score
+ * LOWER: the search failed high, the real score is at least the stored score
+ * EXACT: the stored score is the real score
+ */
+enum Bound
+{
+  BOUND_NONE,
+  BOUND_UPPER,
+  BOUND_LOWER,
+  BOUND_EXACT
+};
+
+/**
+ * @brief struct for a decoded entry of the transposition table
+ */
+struct TTEntry
+{
+  Move move;
+  Score score;
+  int depth;
+  Bound bound;
+};
+
+/**
+ * @brief Transposition table shared by all search threads
+ *
+ * The table is a direct-mapped array of slots indexed by the Zobrist key.
+ * Each slot stores the data and the key XOR the data as two relaxed atomics,
+ * so a slot torn by two threads writing at the same time no longer matches
+ * its key and is ignored, without needing any locks.
+ */
+class TranspositionTable
+{
+public:
+  TranspositionTable(size_t const sizeMB = DEFAULT_HASH_SIZE_MB);
+
+  /**
+   * @brief resizes the table, which also clears it
+   *
+   * @param sizeMB size of the table in megabytes
+   */
+  void resize(size_t const sizeMB);
+
+  void clear();
+
+  /**
+   * @brief looks up the entry of a position
+   *
+   * @param key Zobrist key of the position
+   * @param ply distance from the root, used to adjust mate scores
+   * @param entry entry that is filled in if the position is found
+   * @return true if the position is found, otherwise false
+   */
+  bool probe(uint64_t const key, int const ply, TTEntry &entry) const;
+
+  /**
+   * @brief stores the result of a search of a position
+   *
+   * @param key Zobrist key of the position
+   * @param ply distance from the root, used to adjust mate scores
+   */
+  void store(uint64_t const key, int const ply, Move const &move, Score const score, int const depth, Bound const bound);
+
+  /**
+   * @brief gives how full the table is in permille, from a sample of the slots
+   */
+  int getHashFull() const;
+
+private:
+  struct Slot
+  {
+    std::atomic<uint64_t> keyXorData;
+    std::atomic<uint64_t> data;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  size_t numOfSlots;
+
+  static uint64_t packEntry(Move const &move, Score const score, int const depth, Bound const bound);
+
+  static TTEntry unpackEntry(uint64_t const data);
+};
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef UCI_H
+#define UCI_H
+
+#include <atomic>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "game.h"
+#include "playerengineminimax.h"
+
+#define UCI_ENGINE_NAME "Chess Game"
+#define UCI_ENGINE_AUTHOR "James Montyn"
+
+#define UCI_MAX_HASH_SIZE_MB 4096
+#define UCI_MAX_THREADS 256
+
+/**
+ * @brief UCI class for playing the engine through the Universal Chess Interface protocol
+ *
+ * Commands are read from stdin and answered on stdout, the log goes to stderr.
+ * Searches run on a thread of their own, so the input is still read during a search
+ * and a stop command ends it within LIMIT_CHECK_INTERVAL nodes. A ponder search
+ * becomes the normal search on ponderhit, its time limits only start then.
+ */
+class UCI
+{
+public:
+    UCI();
+
+    ~UCI();
+
+    /**
+     * @brief reads and handles commands until quit or the end of the input
+     */
+    void run();
+
+    /**
+     * @brief gives a move in UCI notation, such as e2e4 or e7e8q
+     */
+    static std::string moveToString(Move const &move);
+
+private:
+    PlayerEngineMiniMax engine;
+    Game game;
+
+    std::thread searchThread;
+    std::atomic<bool> stopSearch;
+    /* set by go ponder until ponderhit, the search thinks on the opponent's time */
+    std::atomic<bool> isPondering;
+    bool ownBook;
+    std::mutex outputMutex;
+
+    /**
+     * @brief writes a line to stdout, lines of the search thread and the input thread are not mixed
+     */
+    void send(std::string const &line);
+
+    void handleUCI();
+
+    void handleSetOption(std::istringstream &command);
+
+    /**
+     * @brief sets up the game from "startpos" or "fen <fen>", followed by "moves <moves>"
+     */
+    void handlePosition(std::istringstream &command);
+
+    /**
+     * @brief starts a search with the limits of the go command on the search thread
+     */
+    void handleGo(std::istringstream &command);
+
+    /**
+     * @brief stops the running search and waits for it to print its best move
+     */
+    void stopAndWait();
+
+    /**
+     * @brief finds the legal move of the game with a given UCI notation
+     *
+     * @return true if the move is legal, otherwise false
+     */
+    bool parseMove(std::string const &notation, Move &move);
+
+    void sendInfo(SearchLine const &line, uint64_t const nodes, int64_t const elapsed);
+};
+
+#endif
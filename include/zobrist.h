@@ -0,0 +1,98 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+
+#include "piece.h"
+#include "direction.h"
+
+#define NUM_OF_PIECE_TYPES 12
+
+/* most pieces of one type a game can have, the 8 pawns promoted to knights plus the 2 knights */
+#define MAX_PIECES_OF_A_TYPE 10
+
+/**
+ * @brief namespace for the Zobrist keys used to hash a game
+ *
+ * The key of a game is the XOR of the keys of every piece on its square,
+ * the castling rights, the file of the en passant square and the turn.
+ * The keys are generated at compile time so they are the same in every run.
+ *
+ * The material key of a game only depends on how many pieces of each type are
+ * on the board, it is the XOR of the keys of the first count pieces of every type.
+ */
+namespace Zobrist
+{
+  struct Keys
+  {
+    uint64_t piece[NUM_OF_PIECE_TYPES][BOARD_SIZE];
+    uint64_t castling[4];
+    uint64_t enPassant[BOARD_LENGTH];
+    uint64_t turn;
+    uint64_t material[NUM_OF_PIECE_TYPES][MAX_PIECES_OF_A_TYPE];
+  };
+
+  /**
+   * @brief splitmix64 step, a small generator that is usable at compile time
+   */
+  constexpr uint64_t nextRandom(uint64_t &state)
+  {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  constexpr Keys generateKeys()
+  {
+    Keys keys = {};
+    uint64_t state = 0x43686573734B6579ULL;
+    for (int piece = 0; piece < NUM_OF_PIECE_TYPES; piece++)
+    {
+      for (int pos = 0; pos < BOARD_SIZE; pos++)
+      {
+        keys.piece[piece][pos] = nextRandom(state);
+      }
+    }
+    for (int i = 0; i < 4; i++)
+    {
+      keys.castling[i] = nextRandom(state);
+    }
+    for (int i = 0; i < BOARD_LENGTH; i++)
+    {
+      keys.enPassant[i] = nextRandom(state);
+    }
+    keys.turn = nextRandom(state);
+    for (int piece = 0; piece < NUM_OF_PIECE_TYPES; piece++)
+    {
+      for (int i = 0; i < MAX_PIECES_OF_A_TYPE; i++)
+      {
+        keys.material[piece][i] = nextRandom(state);
+      }
+    }
+    return keys;
+  }
+
+  inline constexpr Keys keys = generateKeys();
+
+  /**
+   * @brief getter for the key of a piece on a position
+   */
+  static inline uint64_t pieceKey(Piece::Type const piece, int const pos)
+  {
+    return keys.piece[Piece::getPieceIndex(piece)][pos];
+  }
+
+  /**
+   * @brief getter for the material key of the piece with a given index among the pieces of its type
+   *
+   * @param piece colored piece
+   * @param index 0 for the first piece of the type, 1 for the second and so on
+   */
+  static inline uint64_t materialKey(Piece::Type const piece, int const index)
+  {
+    return keys.material[Piece::getPieceIndex(piece)][index];
+  }
+};
+
+#endif
@@ -0,0 +1,865 @@
+#include "../include/bitbase.h"
+#include "../include/endgame.h"
+#include "../include/game.h"
+#include "../include/logger.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <thread>
+#include <utility>
+
+namespace
+{
+  /* states of the positions during the generation, a won position holds the iteration it was found in */
+  constexpr uint8_t STATE_UNKNOWN = 0;
+  constexpr uint8_t STATE_MAX_ITERATION = 253;
+  constexpr uint8_t STATE_DRAW = 254;
+  constexpr uint8_t STATE_ILLEGAL = 255;
+
+  /* positions a thread takes from the shared counter at a time */
+  constexpr size_t CHUNK_SIZE = 4096;
+
+  /* pieces a pawn can promote to, by the letters of the signatures and by type */
+  constexpr char promotionChars[BITBASE_NUM_OF_PROMOTIONS] = {'Q', 'R', 'B', 'N'};
+  constexpr Piece::Type promotionPieces[BITBASE_NUM_OF_PROMOTIONS] = {Piece::Type::QUEEN, Piece::Type::ROOK, Piece::Type::BISHOP, Piece::Type::KNIGHT};
+
+  constexpr int NUM_OF_TRIANGLE_POSITIONS = 10;
+  constexpr int NUM_OF_PAWN_POSITIONS = 24;
+
+  /* positions of the triangle a1-d1-d4 a king without pawns is moved into */
+  constexpr int trianglePositions[NUM_OF_TRIANGLE_POSITIONS] = {0, 1, 2, 3, 9, 10, 11, 18, 19, 27};
+
+  /**
+   * @brief finds the bitbase and the index of the position of a game
+   *
+   * @return the bitbase of the material of the game, nullptr if there is none
+   */
+  Bitbase const *findBitbase(std::vector<Bitbase const *> const &bitbases, Game &game, size_t &index)
+  {
+    for (auto const bitbase : bitbases)
+    {
+      if (bitbase->getIndex(game, index))
+      {
+        return bitbase;
+      }
+    }
+    return nullptr;
+  }
+
+  inline int row(int const pos)
+  {
+    return pos / BOARD_LENGTH;
+  }
+
+  inline int column(int const pos)
+  {
+    return pos % BOARD_LENGTH;
+  }
+
+  inline int mirrorColumn(int const pos)
+  {
+    return pos ^ (BOARD_LENGTH - 1);
+  }
+
+  inline int mirrorRow(int const pos)
+  {
+    return pos ^ (BOARD_SIZE - BOARD_LENGTH);
+  }
+
+  inline int flipDiagonal(int const pos)
+  {
+    return column(pos) * BOARD_LENGTH + row(pos);
+  }
+
+  /* index of every position in trianglePositions, -1 outside of the triangle */
+  constexpr auto triangleIndices = []()
+  {
+    std::array<int, BOARD_SIZE> indices{};
+    for (int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+      indices[pos] = -1;
+    }
+    for (int i = 0; i < NUM_OF_TRIANGLE_POSITIONS; i++)
+    {
+      indices[trianglePositions[i]] = i;
+    }
+    return indices;
+  }();
+
+  /**
+   * @brief index of a pawn on the rows 2 to 7 of the files a to d
+   */
+  inline int pawnIndex(int const pos)
+  {
+    return (row(pos) - 1) * (BOARD_LENGTH / 2) + column(pos);
+  }
+
+  inline int pawnPosition(int const index)
+  {
+    return (index / (BOARD_LENGTH / 2) + 1) * BOARD_LENGTH + index % (BOARD_LENGTH / 2);
+  }
+
+  void transform(BitbasePosition &position, int const numOfPieces, int (*function)(int))
+  {
+    position.strongKing = function(position.strongKing);
+    position.weakKing = function(position.weakKing);
+    for (int i = 0; i < numOfPieces; i++)
+    {
+      position.pieces[i] = function(position.pieces[i]);
+    }
+  }
+
+  /**
+   * @brief positions attacked by a white piece
+   */
+  Bitboard attacksOf(Piece::Type const type, int const pos, Bitboard const occupied)
+  {
+    switch (type)
+    {
+    case Piece::Type::PAWN:
+      return Bitboards::pawnAttacks(Piece::Color::WHITE, pos);
+    case Piece::Type::KNIGHT:
+      return Bitboards::knightAttacks(pos);
+    case Piece::Type::BISHOP:
+      return Bitboards::bishopAttacks(pos, occupied);
+    case Piece::Type::ROOK:
+      return Bitboards::rookAttacks(pos, occupied);
+    case Piece::Type::QUEEN:
+      return Bitboards::queenAttacks(pos, occupied);
+    default:
+      return Bitboards::kingAttacks(pos);
+    }
+  }
+
+  Piece::Type pieceOfChar(char const character)
+  {
+    switch (character)
+    {
+    case 'P':
+      return Piece::Type::PAWN;
+    case 'N':
+      return Piece::Type::KNIGHT;
+    case 'B':
+      return Piece::Type::BISHOP;
+    case 'R':
+      return Piece::Type::ROOK;
+    case 'Q':
+      return Piece::Type::QUEEN;
+    default:
+      return Piece::Type::BLANK;
+    }
+  }
+
+  std::vector<std::unique_ptr<Bitbase>> bitbases;
+};
+
+Bitbase::Bitbase(std::string const &signature) : signature(signature),
+                                                 numOfPieces(0),
+                                                 pawnSlot(-1)
+{
+  /* The pieces between the two kings belong to the strong side */
+  for (size_t i = 1; i + 1 < signature.size() && numOfPieces < BITBASE_MAX_PIECES; i++)
+  {
+    pieces[numOfPieces] = pieceOfChar(signature[i]);
+    if (pieces[numOfPieces] == Piece::Type::PAWN && pawnSlot < 0)
+    {
+      pawnSlot = numOfPieces;
+    }
+    captureSubtables[numOfPieces] = nullptr;
+    numOfPieces++;
+  }
+  std::fill(promotionSubtables, promotionSubtables + BITBASE_NUM_OF_PROMOTIONS, nullptr);
+
+  numOfPositions = 2 * (pawnSlot < 0 ? NUM_OF_TRIANGLE_POSITIONS : BOARD_SIZE) * BOARD_SIZE;
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    numOfPositions *= i == pawnSlot ? NUM_OF_PAWN_POSITIONS : BOARD_SIZE;
+  }
+
+  materialKeys[Piece::getColorIndex(Piece::Color::WHITE)] = Endgames::materialKeyOf(signature);
+  materialKeys[Piece::getColorIndex(Piece::Color::BLACK)] = Endgames::materialKeyOf("K" + signature.substr(0, signature.size() - 1));
+}
+
+std::string const &Bitbase::getSignature() const
+{
+  return signature;
+}
+
+size_t Bitbase::getNumOfPositions() const
+{
+  return numOfPositions;
+}
+
+bool Bitbase::isReady() const
+{
+  return !bits.empty();
+}
+
+size_t Bitbase::indexOf(BitbasePosition const &position) const
+{
+  BitbasePosition canonical = position;
+  if (pawnSlot >= 0)
+  {
+    if (column(canonical.pieces[pawnSlot]) >= BOARD_LENGTH / 2)
+    {
+      transform(canonical, numOfPieces, mirrorColumn);
+    }
+  }
+  else
+  {
+    if (column(canonical.strongKing) >= BOARD_LENGTH / 2)
+    {
+      transform(canonical, numOfPieces, mirrorColumn);
+    }
+    if (row(canonical.strongKing) >= BOARD_LENGTH / 2)
+    {
+      transform(canonical, numOfPieces, mirrorRow);
+    }
+    if (row(canonical.strongKing) > column(canonical.strongKing))
+    {
+      transform(canonical, numOfPieces, flipDiagonal);
+    }
+  }
+
+  size_t index = canonical.isStrongToMove ? 0 : 1;
+  index = pawnSlot < 0 ? index * NUM_OF_TRIANGLE_POSITIONS + triangleIndices[canonical.strongKing] : index * BOARD_SIZE + canonical.strongKing;
+  index = index * BOARD_SIZE + canonical.weakKing;
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    index = i == pawnSlot ? index * NUM_OF_PAWN_POSITIONS + pawnIndex(canonical.pieces[i]) : index * BOARD_SIZE + canonical.pieces[i];
+  }
+  return index;
+}
+
+BitbasePosition Bitbase::positionOf(size_t index) const
+{
+  BitbasePosition position;
+  for (int i = numOfPieces - 1; i >= 0; i--)
+  {
+    if (i == pawnSlot)
+    {
+      position.pieces[i] = pawnPosition(index % NUM_OF_PAWN_POSITIONS);
+      index /= NUM_OF_PAWN_POSITIONS;
+    }
+    else
+    {
+      position.pieces[i] = index % (BOARD_SIZE);
+      index /= (BOARD_SIZE);
+    }
+  }
+  position.weakKing = index % (BOARD_SIZE);
+  index /= (BOARD_SIZE);
+  if (pawnSlot < 0)
+  {
+    position.strongKing = trianglePositions[index % NUM_OF_TRIANGLE_POSITIONS];
+    index /= NUM_OF_TRIANGLE_POSITIONS;
+  }
+  else
+  {
+    position.strongKing = index % (BOARD_SIZE);
+    index /= (BOARD_SIZE);
+  }
+  position.isStrongToMove = index == 0;
+  return position;
+}
+
+bool Bitbase::isLegal(BitbasePosition const &position) const
+{
+  Bitboard occupied = Bitboards::positionToBitboard(position.strongKing) | Bitboards::positionToBitboard(position.weakKing);
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    occupied |= Bitboards::positionToBitboard(position.pieces[i]);
+  }
+  if (Bitboards::popCount(occupied) != numOfPieces + 2 || (Bitboards::kingAttacks(position.strongKing) & Bitboards::positionToBitboard(position.weakKing)))
+  {
+    return false;
+  }
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    if (pieces[i] == Piece::Type::PAWN && (row(position.pieces[i]) == 0 || row(position.pieces[i]) == BOARD_LENGTH - 1))
+    {
+      return false;
+    }
+  }
+
+  /* The side that just moved cannot have left its king in check */
+  if (position.isStrongToMove)
+  {
+    for (int i = 0; i < numOfPieces; i++)
+    {
+      if (attacksOf(pieces[i], position.pieces[i], occupied) & Bitboards::positionToBitboard(position.weakKing))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool Bitbase::isWonBefore(BitbasePosition const &position, int const iteration) const
+{
+  size_t const index = indexOf(position);
+  if (states.empty())
+  {
+    return isWon(index);
+  }
+  /* Draws and illegal positions have states above every iteration */
+  return states[index] != STATE_UNKNOWN && states[index] < iteration;
+}
+
+BitbasePosition Bitbase::positionIn(Bitbase const &other, BitbasePosition const &position, Piece::Type const types[BITBASE_MAX_PIECES]) const
+{
+  /* Every piece of the other bitbase takes the position of a piece of the same type that is left */
+  BitbasePosition otherPosition = position;
+  bool isUsed[BITBASE_MAX_PIECES] = {};
+  for (int j = 0; j < other.numOfPieces; j++)
+  {
+    for (int i = 0; i < numOfPieces; i++)
+    {
+      if (!isUsed[i] && types[i] == other.pieces[j])
+      {
+        isUsed[i] = true;
+        otherPosition.pieces[j] = position.pieces[i];
+        break;
+      }
+    }
+  }
+  return otherPosition;
+}
+
+uint8_t Bitbase::classify(size_t const index, int const iteration) const
+{
+  BitbasePosition const position = positionOf(index);
+  if (iteration == 1 && !isLegal(position))
+  {
+    return STATE_ILLEGAL;
+  }
+
+  Bitboard pieceBitboard = 0;
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    pieceBitboard |= Bitboards::positionToBitboard(position.pieces[i]);
+  }
+  Bitboard const occupied = pieceBitboard | Bitboards::positionToBitboard(position.strongKing) | Bitboards::positionToBitboard(position.weakKing);
+
+  /* Only positions found in earlier iterations count, so the order the threads work in does not matter */
+  if (position.isStrongToMove)
+  {
+    BitbasePosition child = position;
+    child.isStrongToMove = false;
+
+    Bitboard kingMoves = Bitboards::kingAttacks(position.strongKing) & ~pieceBitboard & ~Bitboards::kingAttacks(position.weakKing);
+    while (kingMoves)
+    {
+      child.strongKing = Bitboards::popLsb(kingMoves);
+      if (isWonBefore(child, iteration))
+      {
+        return iteration;
+      }
+    }
+    child.strongKing = position.strongKing;
+
+    for (int i = 0; i < numOfPieces; i++)
+    {
+      Bitboard moves;
+      if (pieces[i] == Piece::Type::PAWN)
+      {
+        int const push = position.pieces[i] + BOARD_LENGTH;
+        moves = (occupied & Bitboards::positionToBitboard(push)) ? 0 : Bitboards::positionToBitboard(push);
+        if (moves && row(position.pieces[i]) == 1 && !(occupied & Bitboards::positionToBitboard(push + BOARD_LENGTH)))
+        {
+          moves |= Bitboards::positionToBitboard(push + BOARD_LENGTH);
+        }
+      }
+      else
+      {
+        moves = attacksOf(pieces[i], position.pieces[i], occupied) & ~occupied;
+      }
+
+      while (moves)
+      {
+        child.pieces[i] = Bitboards::popLsb(moves);
+        if (pieces[i] != Piece::Type::PAWN || row(child.pieces[i]) != BOARD_LENGTH - 1)
+        {
+          if (isWonBefore(child, iteration))
+          {
+            return iteration;
+          }
+          continue;
+        }
+
+        Piece::Type types[BITBASE_MAX_PIECES];
+        std::copy(pieces, pieces + numOfPieces, types);
+        for (int promotion = 0; promotion < BITBASE_NUM_OF_PROMOTIONS; promotion++)
+        {
+          Bitbase const *const subtable = promotionSubtables[promotion];
+          types[i] = promotionPieces[promotion];
+          if (subtable && subtable->isWonBefore(positionIn(*subtable, child, types), iteration))
+          {
+            return iteration;
+          }
+        }
+      }
+      child.pieces[i] = position.pieces[i];
+    }
+    return STATE_UNKNOWN;
+  }
+
+  /* The lone king is to move, it loses if all of its moves lead to won positions */
+  bool isCheck = false;
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    isCheck |= (attacksOf(pieces[i], position.pieces[i], occupied) & Bitboards::positionToBitboard(position.weakKing)) != 0;
+  }
+
+  BitbasePosition child = position;
+  child.isStrongToMove = true;
+  bool hasMove = false;
+  bool isAllWonBefore = true;
+  Bitboard kingMoves = Bitboards::kingAttacks(position.weakKing) & ~Bitboards::kingAttacks(position.strongKing);
+  while (kingMoves)
+  {
+    int const to = Bitboards::popLsb(kingMoves);
+    /* Sliders see through the position the king leaves */
+    Bitboard const occupiedAfter = (occupied & ~Bitboards::positionToBitboard(position.weakKing)) | Bitboards::positionToBitboard(to);
+    bool isAttacked = false;
+    int captured = -1;
+    for (int i = 0; i < numOfPieces; i++)
+    {
+      if (position.pieces[i] == to)
+      {
+        captured = i;
+      }
+      else if (attacksOf(pieces[i], position.pieces[i], occupiedAfter) & Bitboards::positionToBitboard(to))
+      {
+        isAttacked = true;
+      }
+    }
+    if (isAttacked)
+    {
+      continue;
+    }
+    hasMove = true;
+    child.weakKing = to;
+    if (captured < 0)
+    {
+      isAllWonBefore = isAllWonBefore && isWonBefore(child, iteration);
+      continue;
+    }
+
+    /* The subtable of a capture is complete, so a capture it does not win is a draw for good */
+    Bitbase const *const subtable = captureSubtables[captured];
+    Piece::Type types[BITBASE_MAX_PIECES];
+    std::copy(pieces, pieces + numOfPieces, types);
+    types[captured] = Piece::Type::BLANK;
+    if (!subtable || !subtable->isWonBefore(positionIn(*subtable, child, types), STATE_DRAW))
+    {
+      return STATE_DRAW;
+    }
+    isAllWonBefore = isAllWonBefore && subtable->isWonBefore(positionIn(*subtable, child, types), iteration);
+  }
+
+  if (!hasMove)
+  {
+    return isCheck ? iteration : STATE_DRAW;
+  }
+  return isAllWonBefore ? iteration : STATE_UNKNOWN;
+}
+
+void Bitbase::generate(int const numThreads, std::vector<Bitbase const *> const &subtables)
+{
+  /* Captures and promotions go on in the bitbases of the material they lead to */
+  int lastSubtableState = 0;
+  auto const findSubtable = [&](std::string const &subtableSignature) -> Bitbase const *
+  {
+    uint64_t const materialKey = Endgames::materialKeyOf(subtableSignature);
+    for (auto const subtable : subtables)
+    {
+      if (subtable->isReady() && subtable->hasMaterialKey(materialKey))
+      {
+        for (auto const state : subtable->states)
+        {
+          if (state <= STATE_MAX_ITERATION)
+          {
+            lastSubtableState = std::max<int>(lastSubtableState, state);
+          }
+        }
+        return subtable;
+      }
+    }
+    logIt(LogLevel::WARNING) << "No bitbase for " << subtableSignature << ", " << signature << " takes it as a draw";
+    return nullptr;
+  };
+  std::vector<std::string> const subtableSignatures = getSubtableSignatures();
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    captureSubtables[i] = findSubtable(subtableSignatures[i]);
+  }
+  for (int promotion = 0; promotion < BITBASE_NUM_OF_PROMOTIONS && pawnSlot >= 0; promotion++)
+  {
+    promotionSubtables[promotion] = findSubtable(subtableSignatures[numOfPieces + promotion]);
+  }
+
+  states.assign(numOfPositions, STATE_UNKNOWN);
+  for (int iteration = 1; iteration <= STATE_MAX_ITERATION; iteration++)
+  {
+    std::atomic<size_t> nextChunk(0);
+    std::vector<std::vector<std::pair<size_t, uint8_t>>> updates(std::max(1, numThreads));
+    std::vector<std::thread> threads;
+    for (auto &threadUpdates : updates)
+    {
+      threads.emplace_back([&, iteration]()
+                           {
+        size_t begin;
+        while ((begin = nextChunk.fetch_add(CHUNK_SIZE)) < numOfPositions)
+        {
+          size_t const end = std::min(begin + CHUNK_SIZE, numOfPositions);
+          for (size_t index = begin; index < end; index++)
+          {
+            if (states[index] == STATE_UNKNOWN)
+            {
+              uint8_t const state = classify(index, iteration);
+              if (state != STATE_UNKNOWN)
+              {
+                threadUpdates.emplace_back(index, state);
+              }
+            }
+          }
+        } });
+    }
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+
+    /* The states are only written between iterations, so the threads never see a half-done one */
+    size_t numOfUpdates = 0;
+    for (auto const &threadUpdates : updates)
+    {
+      for (auto const &update : threadUpdates)
+      {
+        states[update.first] = update.second;
+      }
+      numOfUpdates += threadUpdates.size();
+    }
+    logIt(LogLevel::DEBUG) << signature << " iteration " << iteration << ": " << numOfUpdates << " positions resolved";
+    /* A win of a subtable can still make a position won after an iteration without new ones */
+    if (numOfUpdates == 0 && iteration > lastSubtableState)
+    {
+      break;
+    }
+  }
+
+  /* Positions still unknown can be held forever by the lone king */
+  bits.assign((numOfPositions + 63) / 64, 0);
+  for (size_t index = 0; index < numOfPositions; index++)
+  {
+    if (states[index] != STATE_UNKNOWN && states[index] <= STATE_MAX_ITERATION)
+    {
+      bits[index / 64] |= 1ULL << (index % 64);
+    }
+  }
+}
+
+bool Bitbase::save(std::string const &path) const
+{
+  std::ofstream file(path, std::ios::binary);
+  uint32_t const header[3] = {BITBASE_FILE_MAGIC, BITBASE_FILE_VERSION, static_cast<uint32_t>(numOfPositions)};
+  file.write(reinterpret_cast<char const *>(header), sizeof(header));
+  file.write(reinterpret_cast<char const *>(bits.data()), bits.size() * sizeof(uint64_t));
+  if (!file)
+  {
+    logIt(LogLevel::ERROR) << "Could not write bitbase " << path;
+    return false;
+  }
+  return true;
+}
+
+bool Bitbase::load(std::string const &path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    logIt(LogLevel::DEBUG) << "No bitbase file " << path << " found";
+    return false;
+  }
+
+  uint32_t header[3];
+  file.read(reinterpret_cast<char *>(header), sizeof(header));
+  if (!file || header[0] != BITBASE_FILE_MAGIC || header[1] != BITBASE_FILE_VERSION || header[2] != numOfPositions)
+  {
+    logIt(LogLevel::WARNING) << "Bitbase file " << path << " has an unsupported header";
+    return false;
+  }
+
+  std::vector<uint64_t> loaded((numOfPositions + 63) / 64);
+  file.read(reinterpret_cast<char *>(loaded.data()), loaded.size() * sizeof(uint64_t));
+  if (!file)
+  {
+    logIt(LogLevel::WARNING) << "Bitbase file " << path << " is truncated";
+    return false;
+  }
+
+  bits = std::move(loaded);
+  states.clear();
+  return true;
+}
+
+bool Bitbase::hasMaterialKey(uint64_t const materialKey) const
+{
+  return materialKey == materialKeys[0] || materialKey == materialKeys[1];
+}
+
+bool Bitbase::getIndex(Game &game, size_t &index) const
+{
+  uint64_t const materialKey = game.getMaterialKey();
+  if (!hasMaterialKey(materialKey))
+  {
+    return false;
+  }
+
+  /* Seen from a black strong side, the rows are flipped so its pawns walk up */
+  Piece::Color const strongSide = materialKey == materialKeys[Piece::getColorIndex(Piece::Color::WHITE)] ? Piece::Color::WHITE : Piece::Color::BLACK;
+  auto const relative = [strongSide](int const pos)
+  {
+    return strongSide == Piece::Color::WHITE ? pos : mirrorRow(pos);
+  };
+
+  BitbasePosition position;
+  position.strongKing = relative(Bitboards::lsb(game.getPieceBitboard(static_cast<Piece::Type>(strongSide | Piece::Type::KING))));
+  position.weakKing = relative(Bitboards::lsb(game.getPieceBitboard(static_cast<Piece::Type>(Piece::getOppositeColor(strongSide) | Piece::Type::KING))));
+  Bitboard taken = 0;
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    int const pos = Bitboards::lsb(game.getPieceBitboard(static_cast<Piece::Type>(strongSide | pieces[i])) & ~taken);
+    taken |= Bitboards::positionToBitboard(pos);
+    position.pieces[i] = relative(pos);
+  }
+  position.isStrongToMove = game.getTurn() == strongSide;
+  index = indexOf(position);
+  return true;
+}
+
+bool Bitbase::isWon(size_t const index) const
+{
+  return (bits[index / 64] >> (index % 64)) & 1;
+}
+
+int Bitbase::getDistanceToMate(size_t const index) const
+{
+  if (states.empty() || states[index] == STATE_UNKNOWN || states[index] > STATE_MAX_ITERATION)
+  {
+    return -1;
+  }
+  /* The mates are found in the first iteration */
+  return states[index] - 1;
+}
+
+std::vector<std::string> Bitbase::getSubtableSignatures() const
+{
+  /* The captures come in the order of the pieces, then the promotions of the first pawn */
+  std::vector<std::string> subtableSignatures;
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    subtableSignatures.push_back(signature.substr(0, i + 1) + signature.substr(i + 2));
+  }
+  for (int promotion = 0; promotion < BITBASE_NUM_OF_PROMOTIONS && pawnSlot >= 0; promotion++)
+  {
+    std::string promotedSignature = signature;
+    promotedSignature[pawnSlot + 1] = promotionChars[promotion];
+    subtableSignatures.push_back(promotedSignature);
+  }
+  return subtableSignatures;
+}
+
+std::string Bitbase::getFEN(size_t const index) const
+{
+  BitbasePosition const position = positionOf(index);
+  if (!isLegal(position))
+  {
+    return "";
+  }
+
+  char board[BOARD_SIZE];
+  std::fill(board, board + BOARD_SIZE, ' ');
+  board[position.strongKing] = 'K';
+  board[position.weakKing] = 'k';
+  for (int i = 0; i < numOfPieces; i++)
+  {
+    board[position.pieces[i]] = Piece::pieceToChar(static_cast<Piece::Type>(Piece::Color::WHITE | pieces[i]));
+  }
+
+  std::string FEN;
+  for (int boardRow = BOARD_LENGTH - 1; boardRow >= 0; boardRow--)
+  {
+    int empty = 0;
+    for (int boardColumn = 0; boardColumn < BOARD_LENGTH; boardColumn++)
+    {
+      char const piece = board[boardRow * BOARD_LENGTH + boardColumn];
+      if (piece == ' ')
+      {
+        empty++;
+        continue;
+      }
+      if (empty > 0)
+      {
+        FEN += std::to_string(empty);
+        empty = 0;
+      }
+      FEN += piece;
+    }
+    if (empty > 0)
+    {
+      FEN += std::to_string(empty);
+    }
+    if (boardRow > 0)
+    {
+      FEN += '/';
+    }
+  }
+  return FEN + (position.isStrongToMove ? " w - -" : " b - -");
+}
+
+bool Bitbase::probe(Game &game, BitbaseValue &value) const
+{
+  size_t index;
+  if (!isReady() || !getIndex(game, index))
+  {
+    return false;
+  }
+  /* The positions with the strong side to move make up the first half of the index */
+  bool const isStrongToMove = index < numOfPositions / 2;
+  value = !isWon(index) ? BitbaseValue::DRAW : (isStrongToMove ? BitbaseValue::WIN : BitbaseValue::LOSS);
+  return true;
+}
+
+bool Bitbase::verifyPosition(size_t const index, std::vector<Bitbase const *> const &bitbases) const
+{
+  std::string const FEN = getFEN(index);
+  if (FEN.empty())
+  {
+    return true;
+  }
+
+  Game game(FEN);
+  bool const isStrongToMove = game.getTurn() == Piece::Color::WHITE;
+  std::vector<Move> const moves = game.getAllLegalMoves();
+
+  /* The strong side goes for the closest mate, the lone king for the farthest */
+  bool isPositionWon;
+  int distanceToMate = -1;
+  if (moves.empty())
+  {
+    isPositionWon = !isStrongToMove && game.isKingInCheck(Piece::Color::BLACK);
+    distanceToMate = isPositionWon ? 0 : -1;
+  }
+  else
+  {
+    bool isAnyWon = false;
+    bool isAllWon = true;
+    int closest = std::numeric_limits<int>::max();
+    int farthest = 0;
+    for (auto const &move : moves)
+    {
+      Game child(game);
+      child.makeMove(move);
+      size_t childIndex;
+      Bitbase const *const childBitbase = findBitbase(bitbases, child, childIndex);
+      if (childBitbase && childBitbase->isWon(childIndex))
+      {
+        isAnyWon = true;
+        closest = std::min(closest, childBitbase->getDistanceToMate(childIndex));
+        farthest = std::max(farthest, childBitbase->getDistanceToMate(childIndex));
+      }
+      else
+      {
+        isAllWon = false;
+      }
+    }
+    isPositionWon = isStrongToMove ? isAnyWon : isAllWon;
+    distanceToMate = isPositionWon ? 1 + (isStrongToMove ? closest : farthest) : -1;
+  }
+
+  if (isPositionWon != isWon(index) || distanceToMate != getDistanceToMate(index))
+  {
+    logIt(LogLevel::ERROR) << signature << " position " << FEN << " has distance to mate " << getDistanceToMate(index)
+                           << " in the bitbase but " << distanceToMate << " by search";
+    return false;
+  }
+  return true;
+}
+
+namespace Bitbases
+{
+  std::vector<std::string> const &getSignatures()
+  {
+    static std::vector<std::string> const signatures = {"KQK", "KRK", "KPK", "KBNK"};
+    return signatures;
+  }
+
+  bool isValidSignature(std::string const &signature)
+  {
+    return signature.size() >= 2 && signature.size() <= BITBASE_MAX_PIECES + 2 && signature.front() == 'K' && signature.back() == 'K' &&
+           signature.find_first_not_of("QRBNP", 1) == signature.size() - 1;
+  }
+
+  std::string getPath(std::string const &directory, std::string const &signature)
+  {
+    return directory + "/" + signature + BITBASE_FILE_EXTENSION;
+  }
+
+  bool load(std::string const &directory)
+  {
+    std::vector<std::unique_ptr<Bitbase>> loaded;
+    for (auto const &signature : getSignatures())
+    {
+      auto bitbase = std::make_unique<Bitbase>(signature);
+      if (bitbase->load(getPath(directory, signature)))
+      {
+        loaded.push_back(std::move(bitbase));
+      }
+    }
+    if (loaded.empty())
+    {
+      logIt(LogLevel::INFO) << "No bitbases found in " << directory;
+      return false;
+    }
+
+    logIt(LogLevel::INFO) << "Loaded " << loaded.size() << " bitbases from " << directory;
+    bitbases = std::move(loaded);
+    return true;
+  }
+
+  bool isLoaded()
+  {
+    return !bitbases.empty();
+  }
+
+  bool isAvailable(uint64_t const materialKey)
+  {
+    for (auto const &bitbase : bitbases)
+    {
+      if (bitbase->hasMaterialKey(materialKey))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  bool probe(Game &game, BitbaseValue &value)
+  {
+    for (auto const &bitbase : bitbases)
+    {
+      if (bitbase->probe(game, value))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+};
@@ -0,0 +1,102 @@
+#include "../include/chessclock.h"
+
+#include <algorithm>
+#include <cstdio>
+
+ChessClock::ChessClock() : startingTime(0),
+                           increment(0),
+                           remaining{0, 0},
+                           isRunning(false),
+                           turn(Piece::Color::WHITE)
+{
+}
+
+void ChessClock::set(int64_t const time, int64_t const increment)
+{
+    startingTime = std::max<int64_t>(0, time);
+    this->increment = std::max<int64_t>(0, increment);
+    reset();
+}
+
+void ChessClock::reset()
+{
+    remaining[0] = startingTime;
+    remaining[1] = startingTime;
+    isRunning = false;
+    turn = Piece::Color::WHITE;
+}
+
+bool ChessClock::isEnabled() const
+{
+    return startingTime > 0;
+}
+
+void ChessClock::start(Piece::Color const color)
+{
+    stop();
+    turn = color;
+    turnStart = std::chrono::steady_clock::now();
+    isRunning = true;
+}
+
+void ChessClock::stop()
+{
+    if (!isRunning)
+    {
+        return;
+    }
+    remaining[Piece::getColorIndex(turn)] = getRemaining(turn);
+    isRunning = false;
+}
+
+void ChessClock::switchTurn()
+{
+    stop();
+    remaining[Piece::getColorIndex(turn)] += increment;
+    start(Piece::getOppositeColor(turn));
+}
+
+int64_t ChessClock::getRemaining(Piece::Color const color) const
+{
+    int64_t time = remaining[Piece::getColorIndex(color)];
+    if (isRunning && color == turn)
+    {
+        time -= std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - turnStart).count();
+    }
+    return std::max<int64_t>(0, time);
+}
+
+bool ChessClock::isOutOfTime(Piece::Color const color) const
+{
+    return isEnabled() && getRemaining(color) == 0;
+}
+
+TimeControl ChessClock::getTimeControl() const
+{
+    TimeControl control;
+    if (!isEnabled())
+    {
+        return control;
+    }
+    for (Piece::Color const color : {Piece::Color::WHITE, Piece::Color::BLACK})
+    {
+        /* Out of time is checked before a player is asked to move, so it gets at least a moment */
+        control.time[Piece::getColorIndex(color)] = std::max<int64_t>(1, getRemaining(color));
+        control.increment[Piece::getColorIndex(color)] = increment;
+    }
+    return control;
+}
+
+std::string ChessClock::timeToString(int64_t const time)
+{
+    char buffer[32];
+    if (time < 10000)
+    {
+        std::snprintf(buffer, sizeof(buffer), "%lld.%lld", static_cast<long long>(time / 1000), static_cast<long long>(time % 1000 / 100));
+    }
+    else
+    {
+        std::snprintf(buffer, sizeof(buffer), "%lld:%02lld", static_cast<long long>(time / 60000), static_cast<long long>(time / 1000 % 60));
+    }
+    return buffer;
+}
@@ -0,0 +1,319 @@
+#include "../include/endgame.h"
+#include "../include/bitbase.h"
+#include "../include/game.h"
+#include "../include/hashtable.h"
+#include "../include/piecesquaretable.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace Endgames
+{
+  namespace
+  {
+    /**
+     * needsBitbase: the evaluation only applies if a bitbase for the material is loaded
+     */
+    struct RegistryEntry
+    {
+      EvaluationFunction evaluation;
+      Piece::Color strongSide;
+      bool needsBitbase;
+    };
+
+    inline int row(int const pos)
+    {
+      return pos / BOARD_LENGTH;
+    }
+
+    inline int column(int const pos)
+    {
+      return pos % BOARD_LENGTH;
+    }
+
+    inline int distance(int const pos1, int const pos2)
+    {
+      return std::max(std::abs(row(pos1) - row(pos2)), std::abs(column(pos1) - column(pos2)));
+    }
+
+    inline bool isDarkSquare(int const pos)
+    {
+      return (row(pos) + column(pos)) % 2 == 0;
+    }
+
+    /**
+     * @brief position as seen by a color, black sees the board with the rows flipped
+     */
+    inline int relativePos(Piece::Color const color, int const pos)
+    {
+      return color == Piece::Color::WHITE ? pos : pos ^ (BOARD_SIZE - BOARD_LENGTH);
+    }
+
+    inline int piecePos(Game &game, Piece::Color const color, Piece::Type const type)
+    {
+      return Bitboards::lsb(game.getPieceBitboard(static_cast<Piece::Type>(color | type)));
+    }
+
+    inline int countPieces(Game &game, Piece::Color const color, Piece::Type const type)
+    {
+      return Bitboards::popCount(game.getPieceBitboard(static_cast<Piece::Type>(color | type)));
+    }
+
+    /**
+     * @brief checks if a loaded bitbase holds the position of a game for a draw
+     */
+    inline bool isBitbaseDraw(Game &game)
+    {
+      BitbaseValue value;
+      return Bitbases::probe(game, value) && value == BitbaseValue::DRAW;
+    }
+
+    /**
+     * @brief draws that no side can win by force, such as KNK and KBK
+     */
+    Score evaluateDraw(Game &, Piece::Color const)
+    {
+      return SCORE_DRAW;
+    }
+
+    /**
+     * @brief KQK and KRK, the lone king is driven to the edge and the kings are brought together
+     */
+    Score evaluateKXK(Game &game, Piece::Color const strongSide)
+    {
+      /* The few draws, a stalemate or a piece left hanging next to the lone king, are only known to the bitbase */
+      if (isBitbaseDraw(game))
+      {
+        return SCORE_DRAW;
+      }
+
+      int const strongKing = piecePos(game, strongSide, Piece::Type::KING);
+      int const weakKing = piecePos(game, Piece::getOppositeColor(strongSide), Piece::Type::KING);
+      int const edgeDistance = std::min({row(weakKing), BOARD_LENGTH - 1 - row(weakKing), column(weakKing), BOARD_LENGTH - 1 - column(weakKing)});
+      Score const material = getEndgameScore(game.getMaterialScore());
+
+      return SCORE_KNOWN_WIN + (strongSide == Piece::Color::WHITE ? material : -material) +
+             40 * (3 - edgeDistance) + 10 * (BOARD_LENGTH - 1 - distance(strongKing, weakKing));
+    }
+
+    /**
+     * @brief KBNK, mate can only be forced in a corner of the color of the bishop
+     */
+    Score evaluateKBNK(Game &game, Piece::Color const strongSide)
+    {
+      if (isBitbaseDraw(game))
+      {
+        return SCORE_DRAW;
+      }
+
+      int const strongKing = piecePos(game, strongSide, Piece::Type::KING);
+      int const weakKing = piecePos(game, Piece::getOppositeColor(strongSide), Piece::Type::KING);
+      int const bishop = piecePos(game, strongSide, Piece::Type::BISHOP);
+
+      /* Flip the columns for a light-squared bishop, so the corners to mate in are a1 and h8 */
+      int const pos = isDarkSquare(bishop) ? weakKing : weakKing ^ (BOARD_LENGTH - 1);
+      int const cornerDistance = std::min(row(pos) + column(pos), 2 * (BOARD_LENGTH - 1) - row(pos) - column(pos));
+
+      return SCORE_KNOWN_WIN + 40 * (2 * (BOARD_LENGTH - 1) - cornerDistance) + 10 * (BOARD_LENGTH - 1 - distance(strongKing, weakKing));
+    }
+
+    /**
+     * @brief KPK from the bitbase, a won pawn is pushed on to promotion and all else is a draw
+     */
+    Score evaluateKPK(Game &game, Piece::Color const strongSide)
+    {
+      if (isBitbaseDraw(game))
+      {
+        return SCORE_DRAW;
+      }
+      int const pawn = relativePos(strongSide, piecePos(game, strongSide, Piece::Type::PAWN));
+      return SCORE_KNOWN_WIN + PieceSquareTable::endgamePieceValues[Piece::getPieceIndex(Piece::Type::PAWN)] + 20 * row(pawn);
+    }
+
+    /**
+     * @brief KRKP, won if the strong king stops the pawn or the weak king is too far from
+     *          it, drawish if the pawn is far advanced and supported by its king
+     */
+    Score evaluateKRKP(Game &game, Piece::Color const strongSide)
+    {
+      Piece::Color const weakSide = Piece::getOppositeColor(strongSide);
+      /* Seen from the strong side, the pawn walks down to row 0 */
+      int const strongKing = relativePos(strongSide, piecePos(game, strongSide, Piece::Type::KING));
+      int const weakKing = relativePos(strongSide, piecePos(game, weakSide, Piece::Type::KING));
+      int const rook = relativePos(strongSide, piecePos(game, strongSide, Piece::Type::ROOK));
+      int const pawn = relativePos(strongSide, piecePos(game, weakSide, Piece::Type::PAWN));
+      int const weakToMove = game.getTurn() == weakSide ? 1 : 0;
+      int const strongToMove = 1 - weakToMove;
+      Score const rookValue = PieceSquareTable::endgamePieceValues[Piece::getPieceIndex(Piece::Type::ROOK)];
+
+      if (column(strongKing) == column(pawn) && row(strongKing) < row(pawn))
+      {
+        return rookValue - distance(strongKing, pawn);
+      }
+      if (distance(weakKing, pawn) >= 3 + weakToMove && distance(weakKing, rook) >= 3)
+      {
+        return rookValue - distance(strongKing, pawn);
+      }
+      if (row(weakKing) <= 2 && distance(weakKing, pawn) == 1 && row(strongKing) >= 3 && distance(strongKing, pawn) > 2 + strongToMove)
+      {
+        return 80 - 8 * distance(strongKing, pawn);
+      }
+      int const stop = pawn - BOARD_LENGTH;
+      return 200 - 8 * (distance(strongKing, stop) - distance(weakKing, stop) - row(pawn));
+    }
+
+    /**
+     * @brief KBPsK, a bishop that does not control the promotion square of rook pawns
+     *          cannot drive the lone king out of the corner
+     */
+    int scaleKBPsK(Game &game, Piece::Color const strongSide)
+    {
+      Bitboard const pawns = game.getPieceBitboard(static_cast<Piece::Type>(strongSide | Piece::Type::PAWN));
+      int const pawnColumn = column(Bitboards::lsb(pawns));
+      if ((pawnColumn != 0 && pawnColumn != BOARD_LENGTH - 1) || (pawns & ~Bitboards::fileBitboard(pawnColumn)))
+      {
+        return SCALE_FACTOR_NORMAL;
+      }
+
+      int const promotion = relativePos(strongSide, (BOARD_LENGTH - 1) * BOARD_LENGTH + pawnColumn);
+      int const bishop = piecePos(game, strongSide, Piece::Type::BISHOP);
+      int const weakKing = piecePos(game, Piece::getOppositeColor(strongSide), Piece::Type::KING);
+      if (isDarkSquare(bishop) != isDarkSquare(promotion) && distance(weakKing, promotion) <= 1)
+      {
+        return SCALE_FACTOR_DRAW;
+      }
+      return SCALE_FACTOR_NORMAL;
+    }
+
+    /**
+     * @brief checks if a color has one bishop, at least one pawn and nothing else besides its king
+     */
+    bool hasOnlyBishopAndPawns(Game &game, Piece::Color const color)
+    {
+      int const numOfPawns = countPieces(game, color, Piece::Type::PAWN);
+      return countPieces(game, color, Piece::Type::BISHOP) == 1 && numOfPawns > 0 &&
+             Bitboards::popCount(game.getColorBitboard(color)) == 2 + numOfPawns;
+    }
+
+    /**
+     * @brief signature with the colors swapped, "KBNK" becomes "KKBN"
+     */
+    std::string mirrorSignature(std::string const &signature)
+    {
+      size_t const secondKing = signature.find('K', 1);
+      return signature.substr(secondKing) + signature.substr(0, secondKing);
+    }
+
+    std::unordered_map<uint64_t, RegistryEntry> const &getRegistry()
+    {
+      static std::unordered_map<uint64_t, RegistryEntry> const registry = []()
+      {
+        std::unordered_map<uint64_t, RegistryEntry> entries;
+        auto const add = [&entries](std::string const &signature, EvaluationFunction const evaluation, bool const needsBitbase = false)
+        {
+          entries[materialKeyOf(signature)] = {evaluation, Piece::Color::WHITE, needsBitbase};
+          entries[materialKeyOf(mirrorSignature(signature))] = {evaluation, Piece::Color::BLACK, needsBitbase};
+        };
+        add("KK", evaluateDraw);
+        add("KNK", evaluateDraw);
+        add("KBK", evaluateDraw);
+        add("KNNK", evaluateDraw);
+        add("KQK", evaluateKXK);
+        add("KRK", evaluateKXK);
+        add("KBNK", evaluateKBNK);
+        add("KRKP", evaluateKRKP);
+        add("KPK", evaluateKPK, true);
+        return entries;
+      }();
+      return registry;
+    }
+  };
+
+  uint64_t materialKeyOf(std::string const &signature)
+  {
+    int counts[NUM_OF_PIECE_TYPES] = {};
+    uint64_t key = 0;
+    Piece::Color color = Piece::Color::WHITE;
+    for (size_t i = 0; i < signature.size(); i++)
+    {
+      if (signature[i] == 'K' && i > 0)
+      {
+        color = Piece::Color::BLACK;
+      }
+      Piece::Type type;
+      switch (signature[i])
+      {
+      case 'P':
+        type = Piece::Type::PAWN;
+        break;
+      case 'N':
+        type = Piece::Type::KNIGHT;
+        break;
+      case 'B':
+        type = Piece::Type::BISHOP;
+        break;
+      case 'R':
+        type = Piece::Type::ROOK;
+        break;
+      case 'Q':
+        type = Piece::Type::QUEEN;
+        break;
+      default:
+        type = Piece::Type::KING;
+        break;
+      }
+      Piece::Type const piece = static_cast<Piece::Type>(color | type);
+      key ^= Zobrist::materialKey(piece, counts[Piece::getPieceIndex(piece)]++);
+    }
+    return key;
+  }
+};
+
+MaterialHashTable::MaterialHashTable(size_t const sizeKB)
+{
+  resize(sizeKB);
+}
+
+void MaterialHashTable::resize(size_t const sizeKB)
+{
+  entries.assign(HashTables::floorPowerOfTwo((sizeKB * 1024) / sizeof(MaterialEntry)), MaterialEntry());
+  clear();
+}
+
+void MaterialHashTable::clear()
+{
+  for (auto &entry : entries)
+  {
+    entry.key = 0;
+    entry.isValid = false;
+  }
+}
+
+MaterialEntry const &MaterialHashTable::probe(Game &game)
+{
+  uint64_t const key = game.getMaterialKey();
+  MaterialEntry &entry = entries[key & (entries.size() - 1)];
+  if (entry.isValid && entry.key == key)
+  {
+    return entry;
+  }
+
+  entry.key = key;
+  entry.isValid = true;
+  entry.evaluation = nullptr;
+  entry.strongSide = Piece::Color::WHITE;
+  auto const found = Endgames::getRegistry().find(key);
+  if (found != Endgames::getRegistry().end() && (!found->second.needsBitbase || Bitbases::isAvailable(key)))
+  {
+    entry.evaluation = found->second.evaluation;
+    entry.strongSide = found->second.strongSide;
+  }
+
+  Piece::Color const colors[2] = {Piece::Color::WHITE, Piece::Color::BLACK};
+  for (int i = 0; i < 2; i++)
+  {
+    bool const isKBPsK = Endgames::hasOnlyBishopAndPawns(game, colors[i]) && Bitboards::popCount(game.getColorBitboard(colors[1 - i])) == 1;
+    entry.scaling[i] = isKBPsK ? Endgames::scaleKBPsK : nullptr;
+  }
+  return entry;
+}
@@ -0,0 +1,41 @@
+#include "../include/evalcache.h"
+#include "../include/hashtable.h"
+
+#define EVAL_CACHE_SCORE_MASK 0xFFFFULL
+
+EvalCache::EvalCache(size_t const sizeMB) : numOfSlots(0)
+{
+  resize(sizeMB);
+}
+
+void EvalCache::resize(size_t const sizeMB)
+{
+  numOfSlots = HashTables::floorPowerOfTwo((sizeMB * 1024 * 1024) / sizeof(std::atomic<uint64_t>));
+  slots = std::make_unique<std::atomic<uint64_t>[]>(numOfSlots);
+  clear();
+}
+
+void EvalCache::clear()
+{
+  for (size_t i = 0; i < numOfSlots; i++)
+  {
+    slots[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+bool EvalCache::probe(uint64_t const key, Score &score) const
+{
+  uint64_t const slot = slots[key & (numOfSlots - 1)].load(std::memory_order_relaxed);
+  if ((slot ^ key) & ~EVAL_CACHE_SCORE_MASK)
+  {
+    return false;
+  }
+  score = static_cast<int16_t>(static_cast<uint16_t>(slot & EVAL_CACHE_SCORE_MASK));
+  return true;
+}
+
+void EvalCache::store(uint64_t const key, Score const score)
+{
+  uint64_t const slot = (key & ~EVAL_CACHE_SCORE_MASK) | static_cast<uint16_t>(static_cast<int16_t>(score));
+  slots[key & (numOfSlots - 1)].store(slot, std::memory_order_relaxed);
+}
@@ -0,0 +1,206 @@
+#include "../include/evaluationweights.h"
+#include "../include/piecesquaretable.h"
+#include "../include/logger.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <unordered_map>
+
+namespace EvalParameters
+{
+  namespace
+  {
+    char const *const kindNames[NUM_OF_PIECE_KINDS] = {"pawn", "knight", "bishop", "rook", "queen", "king"};
+
+    /**
+     * @brief name of a position of a piece-square table, which has a8 at index 0
+     */
+    std::string tablePositionName(int const index)
+    {
+      std::string name;
+      name += static_cast<char>('a' + index % BOARD_LENGTH);
+      name += static_cast<char>('8' - index / BOARD_LENGTH);
+      return name;
+    }
+
+    void addTapered(std::vector<EvalParameter> &parameters, std::string const &name, TaperedScore &weight)
+    {
+      EvalParameter parameter;
+      parameter.name = name;
+      parameter.tapered = &weight;
+      parameters.push_back(parameter);
+    }
+
+    template <int size>
+    void addTaperedTable(std::vector<EvalParameter> &parameters, std::string const &name, TaperedScore (&weights)[size])
+    {
+      for (int i = 0; i < size; i++)
+      {
+        addTapered(parameters, name + "." + std::to_string(i), weights[i]);
+      }
+    }
+
+    EvaluationWeights &startupWeights()
+    {
+      static EvaluationWeights weights;
+      return weights;
+    }
+
+    void addPair(std::vector<EvalParameter> &parameters, std::string const &name, Score &middlegame, Score &endgame)
+    {
+      EvalParameter parameter;
+      parameter.name = name;
+      parameter.middlegame = &middlegame;
+      parameter.endgame = &endgame;
+      parameters.push_back(parameter);
+    }
+  };
+
+  std::vector<EvalParameter> getParameters(EvaluationWeights &weights)
+  {
+    std::vector<EvalParameter> parameters;
+
+    /* The king is always on the board, its value does not change the evaluation */
+    for (int kind = 0; kind < NUM_OF_PIECE_KINDS - 1; kind++)
+    {
+      addPair(parameters, std::string("pieceValue.") + kindNames[kind],
+              PieceSquareTable::middlegamePieceValues[kind], PieceSquareTable::endgamePieceValues[kind]);
+    }
+    for (int kind = 0; kind < NUM_OF_PIECE_KINDS; kind++)
+    {
+      for (int index = 0; index < BOARD_SIZE; index++)
+      {
+        addPair(parameters, std::string("placement.") + kindNames[kind] + "." + tablePositionName(index),
+                PieceSquareTable::middlegamePlacementBonuses[kind][index], PieceSquareTable::endgamePlacementBonuses[kind][index]);
+      }
+    }
+
+    addTapered(parameters, "doubledPawn", weights.doubledPawn);
+    addTapered(parameters, "isolatedPawn", weights.isolatedPawn);
+    addTapered(parameters, "backwardPawn", weights.backwardPawn);
+    addTaperedTable(parameters, "passedPawn", weights.passedPawn);
+    addTapered(parameters, "shieldPawn", weights.shieldPawn);
+    addTapered(parameters, "shieldPawnAdvanced", weights.shieldPawnAdvanced);
+    addTapered(parameters, "kingSemiOpenFile", weights.kingSemiOpenFile);
+    addTapered(parameters, "rookOpenFile", weights.rookOpenFile);
+    addTapered(parameters, "rookSemiOpenFile", weights.rookSemiOpenFile);
+    addTaperedTable(parameters, "knightMobility", weights.knightMobility);
+    addTaperedTable(parameters, "bishopMobility", weights.bishopMobility);
+    addTaperedTable(parameters, "rookMobility", weights.rookMobility);
+    addTaperedTable(parameters, "queenMobility", weights.queenMobility);
+
+    return parameters;
+  }
+
+  bool load(std::string const &path, EvaluationWeights &weights)
+  {
+    std::ifstream file(path);
+    if (!file)
+    {
+      logIt(LogLevel::INFO) << "No parameter file " << path << " found";
+      return false;
+    }
+
+    std::vector<EvalParameter> parameters = getParameters(weights);
+    std::unordered_map<std::string, EvalParameter *> parametersByName;
+    for (auto &parameter : parameters)
+    {
+      parametersByName[parameter.name] = &parameter;
+    }
+
+    /* Read the whole file first, so a bad line leaves all parameters unchanged */
+    std::vector<std::pair<EvalParameter *, std::pair<Score, Score>>> values;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+      lineNumber++;
+      if (line.empty() || line[0] == '#')
+      {
+        continue;
+      }
+      std::istringstream stream(line);
+      std::string name;
+      Score middlegame;
+      Score endgame;
+      if (!(stream >> name >> middlegame >> endgame))
+      {
+        logIt(LogLevel::WARNING) << "Parameter file " << path << " has an invalid line " << lineNumber;
+        return false;
+      }
+      auto const found = parametersByName.find(name);
+      if (found == parametersByName.end())
+      {
+        logIt(LogLevel::WARNING) << "Parameter file " << path << " has an unknown parameter " << name;
+        continue;
+      }
+      values.push_back({found->second, {middlegame, endgame}});
+    }
+
+    for (auto const &value : values)
+    {
+      value.first->set(value.second.first, value.second.second);
+    }
+    PieceSquareTable::init();
+    logIt(LogLevel::INFO) << "Loaded " << values.size() << " evaluation parameters from " << path;
+    return true;
+  }
+
+  bool loadStartupParameters(std::string const &path)
+  {
+    return load(path, startupWeights());
+  }
+
+  EvaluationWeights const &getStartupWeights()
+  {
+    return startupWeights();
+  }
+
+  bool save(std::string const &path, EvaluationWeights &weights)
+  {
+    std::ofstream file(path);
+    if (!file)
+    {
+      logIt(LogLevel::ERROR) << "Could not write parameter file " << path;
+      return false;
+    }
+
+    file << "# name middlegame endgame" << std::endl;
+    for (auto const &parameter : getParameters(weights))
+    {
+      file << parameter.name << " " << parameter.getMiddlegame() << " " << parameter.getEndgame() << std::endl;
+    }
+    return static_cast<bool>(file);
+  }
+};
+
+std::string EvalTrace::toString(int const phase) const
+{
+  static char const *const termNames[NUM_OF_EVAL_TERMS] = {"Material", "Placement", "Mobility", "Pawns", "King shield", "Rooks"};
+
+  std::ostringstream table;
+  table << std::setw(12) << std::left << "Term" << std::right
+        << " |  White mg    eg |  Black mg    eg |  Total mg    eg" << std::endl
+        << std::string(64, '-') << std::endl;
+  TaperedScore sums[2] = {0, 0};
+  for (int term = 0; term < NUM_OF_EVAL_TERMS; term++)
+  {
+    TaperedScore const white = getTermScore(static_cast<EvalTerm>(term), Piece::Color::WHITE);
+    TaperedScore const black = getTermScore(static_cast<EvalTerm>(term), Piece::Color::BLACK);
+    sums[0] += white;
+    sums[1] += black;
+    table << std::setw(12) << std::left << termNames[term] << std::right
+          << " | " << std::setw(9) << getMiddlegameScore(white) << std::setw(6) << getEndgameScore(white)
+          << " | " << std::setw(9) << getMiddlegameScore(black) << std::setw(6) << getEndgameScore(black)
+          << " | " << std::setw(9) << getMiddlegameScore(white - black) << std::setw(6) << getEndgameScore(white - black) << std::endl;
+  }
+  TaperedScore const total = sums[0] - sums[1];
+  table << std::string(64, '-') << std::endl
+        << std::setw(12) << std::left << "Total" << std::right
+        << " | " << std::setw(9) << getMiddlegameScore(sums[0]) << std::setw(6) << getEndgameScore(sums[0])
+        << " | " << std::setw(9) << getMiddlegameScore(sums[1]) << std::setw(6) << getEndgameScore(sums[1])
+        << " | " << std::setw(9) << getMiddlegameScore(total) << std::setw(6) << getEndgameScore(total) << std::endl
+        << "Phase " << phase << "/" << PHASE_MAX << ", tapered score " << taperScore(total, phase) << " (white's point of view)";
+  return table.str();
+}
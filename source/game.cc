@@ -1,11 +1,12 @@
 #include "../include/game.h"
 
+#include <algorithm>
 #include <iostream>
 
 void Game::initGame()
 {
     turn = Piece::Color::WHITE;
-    enPassantPos = 0;
+    enPassantPos = -1;
     whiteCastlingQueenside = true;
     whiteCastlingKingside = true;
     blackCastlingQueenside = true;
@@ -19,6 +20,15 @@ void Game::initGame()
     {
         board[i] = Piece::Type::BLANK;
     }
+    std::fill(pieceBitboards, pieceBitboards + NUM_OF_PIECE_TYPES, 0);
+    std::fill(colorBitboards, colorBitboards + 2, 0);
+    materialScore = 0;
+    placementScore = 0;
+    phase = 0;
+    accumulator.generation = 0;
+    zobristKey = computeZobristKey();
+    pawnKey = 0;
+    materialKey = 0;
 }
 
 Game::Game()
@@ -48,10 +58,57 @@ Game::Game(Game const &game)
       blackCastlingKingside(game.blackCastlingKingside),
       whiteKingPos(game.whiteKingPos),
       blackKingPos(game.blackKingPos),
+      zobristKey(game.zobristKey),
+      pawnKey(game.pawnKey),
+      materialKey(game.materialKey),
+      materialScore(game.materialScore),
+      placementScore(game.placementScore),
+      phase(game.phase),
       moveCounter(game.moveCounter),
       result(game.result)
 {
     std::copy(game.board, game.board + BOARD_SIZE, board);
+    std::copy(game.pieceBitboards, game.pieceBitboards + NUM_OF_PIECE_TYPES, pieceBitboards);
+    std::copy(game.colorBitboards, game.colorBitboards + 2, colorBitboards);
+    /* Only copy the network sums if they are in use, they are the largest part of the game */
+    accumulator.generation = game.accumulator.generation;
+    if (NNUE::isUpToDate(game.accumulator))
+    {
+        accumulator = game.accumulator;
+    }
+}
+
+Game &Game::operator=(Game const &game)
+{
+    if (this == &game)
+    {
+        return *this;
+    }
+    turn = game.turn;
+    enPassantPos = game.enPassantPos;
+    whiteCastlingQueenside = game.whiteCastlingQueenside;
+    whiteCastlingKingside = game.whiteCastlingKingside;
+    blackCastlingQueenside = game.blackCastlingQueenside;
+    blackCastlingKingside = game.blackCastlingKingside;
+    whiteKingPos = game.whiteKingPos;
+    blackKingPos = game.blackKingPos;
+    zobristKey = game.zobristKey;
+    pawnKey = game.pawnKey;
+    materialKey = game.materialKey;
+    materialScore = game.materialScore;
+    placementScore = game.placementScore;
+    phase = game.phase;
+    moveCounter = game.moveCounter;
+    result = game.result;
+    std::copy(game.board, game.board + BOARD_SIZE, board);
+    std::copy(game.pieceBitboards, game.pieceBitboards + NUM_OF_PIECE_TYPES, pieceBitboards);
+    std::copy(game.colorBitboards, game.colorBitboards + 2, colorBitboards);
+    accumulator.generation = game.accumulator.generation;
+    if (NNUE::isUpToDate(game.accumulator))
+    {
+        accumulator = game.accumulator;
+    }
+    return *this;
 }
 
 void Game::passTurn(Position newEnPassantPos = -1)
@@ -66,6 +123,254 @@ void Game::passTurn(Position newEnPassantPos = -1)
         moveCounter++;
     }
     enPassantPos = newEnPassantPos;
+    zobristKey ^= getStateKey() ^ Zobrist::keys.turn;
+}
+
+void Game::putPiece(Position const pos, Piece::Type const piece)
+{
+    board[pos] = piece;
+    zobristKey ^= Zobrist::pieceKey(piece, pos);
+    materialKey ^= Zobrist::materialKey(piece, Bitboards::popCount(pieceBitboards[Piece::getPieceIndex(piece)]));
+    pieceBitboards[Piece::getPieceIndex(piece)] ^= Bitboards::positionToBitboard(pos);
+    colorBitboards[Piece::getColorIndex(Piece::getColorOfPiece(piece))] ^= Bitboards::positionToBitboard(pos);
+    materialScore += PieceSquareTable::getMaterial(piece);
+    placementScore += PieceSquareTable::getPlacement(piece, pos);
+    phase += PieceSquareTable::getPhaseWeight(piece);
+    if (NNUE::isUpToDate(accumulator))
+    {
+        NNUE::addPiece(accumulator, piece, pos);
+    }
+    if (Piece::getPieceTypeWithoutColor(piece) == Piece::Type::PAWN)
+    {
+        pawnKey ^= Zobrist::pieceKey(piece, pos);
+    }
+}
+
+void Game::removePiece(Position const pos)
+{
+    if (board[pos] == Piece::Type::BLANK)
+    {
+        return;
+    }
+    zobristKey ^= Zobrist::pieceKey(board[pos], pos);
+    pieceBitboards[Piece::getPieceIndex(board[pos])] ^= Bitboards::positionToBitboard(pos);
+    colorBitboards[Piece::getColorIndex(Piece::getColorOfPiece(board[pos]))] ^= Bitboards::positionToBitboard(pos);
+    materialKey ^= Zobrist::materialKey(board[pos], Bitboards::popCount(pieceBitboards[Piece::getPieceIndex(board[pos])]));
+    materialScore -= PieceSquareTable::getMaterial(board[pos]);
+    placementScore -= PieceSquareTable::getPlacement(board[pos], pos);
+    phase -= PieceSquareTable::getPhaseWeight(board[pos]);
+    if (NNUE::isUpToDate(accumulator))
+    {
+        NNUE::removePiece(accumulator, board[pos], pos);
+    }
+    if (Piece::getPieceTypeWithoutColor(board[pos]) == Piece::Type::PAWN)
+    {
+        pawnKey ^= Zobrist::pieceKey(board[pos], pos);
+    }
+    board[pos] = Piece::Type::BLANK;
+}
+
+uint64_t Game::getStateKey()
+{
+    uint64_t key = 0;
+    key ^= whiteCastlingKingside ? Zobrist::keys.castling[0] : 0;
+    key ^= whiteCastlingQueenside ? Zobrist::keys.castling[1] : 0;
+    key ^= blackCastlingKingside ? Zobrist::keys.castling[2] : 0;
+    key ^= blackCastlingQueenside ? Zobrist::keys.castling[3] : 0;
+    if (enPassantPos.isValid())
+    {
+        key ^= Zobrist::keys.enPassant[enPassantPos.getColumn() - 1];
+    }
+    return key;
+}
+
+uint64_t Game::computeZobristKey()
+{
+    uint64_t key = getStateKey();
+    for (int i = 0; i < BOARD_SIZE; i++)
+    {
+        if (board[i] != Piece::Type::BLANK)
+        {
+            key ^= Zobrist::pieceKey(board[i], i);
+        }
+    }
+    if (turn == Piece::Color::BLACK)
+    {
+        key ^= Zobrist::keys.turn;
+    }
+    return key;
+}
+
+uint64_t Game::getZobristKey()
+{
+    return zobristKey;
+}
+
+uint64_t Game::getPawnKey()
+{
+    return pawnKey;
+}
+
+uint64_t Game::getMaterialKey()
+{
+    return materialKey;
+}
+
+Bitboard Game::getPieceBitboard(Piece::Type const piece)
+{
+    return pieceBitboards[Piece::getPieceIndex(piece)];
+}
+
+Bitboard Game::getColorBitboard(Piece::Color const color)
+{
+    return colorBitboards[Piece::getColorIndex(color)];
+}
+
+Bitboard Game::getOccupiedBitboard()
+{
+    return colorBitboards[0] | colorBitboards[1];
+}
+
+TaperedScore Game::getMaterialScore()
+{
+    return materialScore;
+}
+
+TaperedScore Game::getPlacementScore()
+{
+    return placementScore;
+}
+
+void Game::refreshTableScores()
+{
+    materialScore = 0;
+    placementScore = 0;
+    for (int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+        if (board[pos] != Piece::Type::BLANK)
+        {
+            materialScore += PieceSquareTable::getMaterial(board[pos]);
+            placementScore += PieceSquareTable::getPlacement(board[pos], pos);
+        }
+    }
+}
+
+NNUE::Accumulator const &Game::getAccumulator()
+{
+    if (!NNUE::isUpToDate(accumulator))
+    {
+        NNUE::refreshAccumulator(accumulator, board);
+    }
+    return accumulator;
+}
+
+int Game::getPhase()
+{
+    /* Promotions can bring more non-pawn material than the starting position */
+    return std::min(phase, PHASE_MAX);
+}
+
+Bitboard Game::getAttackersToPos(Position const pos, Bitboard const occupied)
+{
+    Bitboard const bishopsAndQueens = getPieceBitboard(Piece::Type::WHITE_BISHOP) | getPieceBitboard(Piece::Type::BLACK_BISHOP) |
+                                      getPieceBitboard(Piece::Type::WHITE_QUEEN) | getPieceBitboard(Piece::Type::BLACK_QUEEN);
+    Bitboard const rooksAndQueens = getPieceBitboard(Piece::Type::WHITE_ROOK) | getPieceBitboard(Piece::Type::BLACK_ROOK) |
+                                    getPieceBitboard(Piece::Type::WHITE_QUEEN) | getPieceBitboard(Piece::Type::BLACK_QUEEN);
+
+    return (Bitboards::pawnAttacks(Piece::Color::BLACK, pos) & getPieceBitboard(Piece::Type::WHITE_PAWN)) |
+           (Bitboards::pawnAttacks(Piece::Color::WHITE, pos) & getPieceBitboard(Piece::Type::BLACK_PAWN)) |
+           (Bitboards::knightAttacks(pos) & (getPieceBitboard(Piece::Type::WHITE_KNIGHT) | getPieceBitboard(Piece::Type::BLACK_KNIGHT))) |
+           (Bitboards::kingAttacks(pos) & (getPieceBitboard(Piece::Type::WHITE_KING) | getPieceBitboard(Piece::Type::BLACK_KING))) |
+           (Bitboards::bishopAttacks(pos, occupied) & bishopsAndQueens) |
+           (Bitboards::rookAttacks(pos, occupied) & rooksAndQueens);
+}
+
+bool Game::isCapture(Move const &move)
+{
+    return board[move.to] != Piece::Type::BLANK ||
+           (Piece::getPieceTypeWithoutColor(move.piece) == Piece::Type::PAWN && move.to.getColumn() != move.from.getColumn());
+}
+
+int Game::staticExchangeEvaluation(Move const &move)
+{
+    Piece::Type const pieceTypes[] = {Piece::Type::PAWN, Piece::Type::KNIGHT, Piece::Type::BISHOP, Piece::Type::ROOK, Piece::Type::QUEEN, Piece::Type::KING};
+    Bitboard const bishopsAndQueens = getPieceBitboard(Piece::Type::WHITE_BISHOP) | getPieceBitboard(Piece::Type::BLACK_BISHOP) |
+                                      getPieceBitboard(Piece::Type::WHITE_QUEEN) | getPieceBitboard(Piece::Type::BLACK_QUEEN);
+    Bitboard const rooksAndQueens = getPieceBitboard(Piece::Type::WHITE_ROOK) | getPieceBitboard(Piece::Type::BLACK_ROOK) |
+                                    getPieceBitboard(Piece::Type::WHITE_QUEEN) | getPieceBitboard(Piece::Type::BLACK_QUEEN);
+
+    Bitboard occupied = getOccupiedBitboard();
+    int gain[32];
+    int depth = 0;
+
+    /* First capture */
+    gain[0] = board[move.to] != Piece::Type::BLANK ? Piece::getPieceValue(board[move.to]) : 0;
+    if (board[move.to] == Piece::Type::BLANK && isCapture(move))
+    {
+        /* En passant, the captured pawn is not on the destination */
+        gain[0] = Piece::getPieceValue(Piece::Type::PAWN);
+        occupied ^= Bitboards::positionToBitboard(Position(move.to.getColumn() - 1 + (move.from.getRow() - 1) * BOARD_LENGTH));
+    }
+    Piece::Type attacker = move.piece;
+    if (move.promotionPiece != Piece::Type::BLANK)
+    {
+        gain[0] += Piece::getPieceValue(move.promotionPiece) - Piece::getPieceValue(Piece::Type::PAWN);
+        attacker = move.promotionPiece;
+    }
+
+    Piece::Color color = Piece::getColorOfPiece(move.piece);
+    Bitboard fromBitboard = Bitboards::positionToBitboard(move.from);
+    Bitboard attackers = getAttackersToPos(move.to, occupied);
+    while (true)
+    {
+        depth++;
+        color = Piece::getOppositeColor(color);
+
+        /* Speculative score if the last attacker is captured */
+        gain[depth] = Piece::getPieceValue(attacker) - gain[depth - 1];
+        if (std::max(-gain[depth - 1], gain[depth]) < 0)
+        {
+            break;
+        }
+
+        occupied ^= fromBitboard;
+        attackers &= occupied;
+
+        /* Sliders behind the last attacker can now see the position */
+        attackers |= (Bitboards::bishopAttacks(move.to, occupied) & bishopsAndQueens) |
+                     (Bitboards::rookAttacks(move.to, occupied) & rooksAndQueens);
+        attackers &= occupied;
+
+        Bitboard const ownAttackers = attackers & getColorBitboard(color);
+        if (ownAttackers == 0 || depth >= 31)
+        {
+            break;
+        }
+
+        /* Recapture with the least valuable attacker */
+        for (auto const pieceType : pieceTypes)
+        {
+            Bitboard const pieceAttackers = ownAttackers & getPieceBitboard(static_cast<Piece::Type>(pieceType | color));
+            if (pieceAttackers != 0)
+            {
+                fromBitboard = pieceAttackers & -pieceAttackers;
+                attacker = pieceType;
+                break;
+            }
+        }
+
+        /* The king can only recapture if the position is no longer defended */
+        if (attacker == Piece::Type::KING && (attackers & ~fromBitboard & getColorBitboard(Piece::getOppositeColor(color))) != 0)
+        {
+            break;
+        }
+    }
+
+    while (--depth)
+    {
+        gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+    }
+    return gain[0];
 }
 
 int Game::getMoveCounter()
@@ -95,7 +400,7 @@ bool Game::getCastlingKingSide(Piece::Color const color)
 
 bool Game::getCastlingQueenSide(Piece::Color const color)
 {
-    return color == Piece::Color::BLACK ? whiteCastlingQueenside : blackCastlingQueenside;
+    return color == Piece::Color::WHITE ? whiteCastlingQueenside : blackCastlingQueenside;
 }
 
 Position Game::getKingPosOfPiece(Piece::Color const color)
@@ -120,12 +425,12 @@ Piece::Type Game::getPieceAtPos(Position const pos)
 std::vector<std::pair<Piece::Type, Position>> Game::getAllPiecesForColor(Piece::Color const color)
 {
     std::vector<std::pair<Piece::Type, Position>> pieces;
-    for (int i = 0; i < BOARD_SIZE; i++)
+    Bitboard colorBitboard = getColorBitboard(color);
+    pieces.reserve(Bitboards::popCount(colorBitboard));
+    while (colorBitboard)
     {
-        if (board[i] != Piece::Type::BLANK && Piece::getColorOfPiece(board[i]) == color)
-        {
-            pieces.push_back(std::make_pair(board[i], Position(i)));
-        }
+        int const pos = Bitboards::popLsb(colorBitboard);
+        pieces.push_back(std::make_pair(board[pos], Position(pos)));
     }
     return pieces;
 }
@@ -133,11 +438,10 @@ std::vector<std::pair<Piece::Type, Position>> Game::getAllPiecesForColor(Piece::
 std::vector<Move> Game::getAllLegalMoves()
 {
     std::vector<Move> allLegalMoves;
-    std::vector<std::pair<Piece::Type, Position>> allPieces = getAllPiecesForColor(getTurn());
-
-    for (auto [piece, pos] : allPieces)
+    Bitboard pieces = getColorBitboard(getTurn());
+    while (pieces)
     {
-        std::vector<Move> legalMoves = getLegalMovesForPos(pos);
+        std::vector<Move> const legalMoves = getLegalMovesForPos(Bitboards::popLsb(pieces));
         if (legalMoves.size() > 0)
         {
             allLegalMoves.insert(allLegalMoves.end(), legalMoves.begin(), legalMoves.end());
@@ -149,114 +453,7 @@ std::vector<Move> Game::getAllLegalMoves()
 
 bool Game::isKingInCheck(Piece::Color const color)
 {
-    Position const kingPos = getKingPosOfPiece(color);
-
-    /* Check if king is attacked by a rook */
-    for (auto const cardinal : Direction::Cardinals)
-    {
-        Position prevPos = kingPos;
-        Position tmpPos = kingPos + cardinal;
-        while (tmpPos.isValid() && (prevPos.getRow() == tmpPos.getRow() || prevPos.getColumn() == tmpPos.getColumn()) && getPieceAtPos(tmpPos) == Piece::Type::BLANK)
-        {
-            prevPos = tmpPos;
-            tmpPos += cardinal;
-        }
-
-        if (tmpPos.isValid() && (prevPos.getRow() == tmpPos.getRow() || prevPos.getColumn() == tmpPos.getColumn()))
-        {
-            Piece::Type piece = getPieceAtPos(tmpPos);
-            if (
-                Piece::getColorOfPiece(piece) != color &&
-                (Piece::getPieceTypeWithoutColor(piece) == Piece::Type::QUEEN ||
-                 Piece::getPieceTypeWithoutColor(piece) == Piece::Type::ROOK))
-            {
-                return true;
-            }
-        }
-    }
-
-    /* Check if king is attacked by a bishop */
-    for (auto const diagonal : Direction::Diagonals)
-    {
-        Position prevPos = kingPos;
-        Position tmpPos = kingPos + diagonal;
-        while (tmpPos.isValid() && abs(prevPos.getColumn() - tmpPos.getColumn()) == abs(prevPos.getRow() - tmpPos.getRow()) && getPieceAtPos(tmpPos) == Piece::Type::BLANK)
-        {
-            prevPos = tmpPos;
-            tmpPos += diagonal;
-        }
-
-        if (tmpPos.isValid() && abs(prevPos.getColumn() - tmpPos.getColumn()) == abs(prevPos.getRow() - tmpPos.getRow()))
-        {
-            Piece::Type piece = getPieceAtPos(tmpPos);
-            if (
-                Piece::getColorOfPiece(piece) != color &&
-                (Piece::getPieceTypeWithoutColor(piece) == Piece::Type::QUEEN ||
-                 Piece::getPieceTypeWithoutColor(piece) == Piece::Type::BISHOP))
-            {
-                return true;
-            }
-        }
-    }
-
-    /* Check if king is attacked by a knight */
-    for (auto const knightMove : Direction::KnightMoves)
-    {
-        Position const tmpPos = kingPos + knightMove;
-        if (tmpPos.isValid() &&
-            abs(tmpPos.getColumn() - kingPos.getColumn()) <= 2 &&
-            Piece::getColorOfPiece(getPieceAtPos(tmpPos)) != color &&
-            Piece::getPieceTypeWithoutColor(getPieceAtPos(tmpPos)) == Piece::Type::KNIGHT)
-        {
-            return true;
-        }
-    }
-
-    /* Check if king is attacked by a pawn */
-    if (color == Piece::Color::WHITE)
-    {
-        if ((Position(kingPos + Direction::Diagonal::NORTH_EAST).isValid() && getPieceAtPos(kingPos + Direction::Diagonal::NORTH_EAST) == Piece::Type::BLACK_PAWN) ||
-            (Position(kingPos + Direction::Diagonal::NORTH_WEST).isValid() && getPieceAtPos(kingPos + Direction::Diagonal::NORTH_WEST) == Piece::Type::BLACK_PAWN))
-        {
-            return true;
-        }
-    }
-    else
-    {
-        if ((Position(kingPos + Direction::Diagonal::SOUTH_EAST).isValid() && getPieceAtPos(kingPos + Direction::Diagonal::SOUTH_EAST) == Piece::Type::WHITE_PAWN) ||
-            (Position(kingPos + Direction::Diagonal::SOUTH_WEST).isValid() && getPieceAtPos(kingPos + Direction::Diagonal::SOUTH_WEST) == Piece::Type::WHITE_PAWN))
-        {
-            return true;
-        }
-    }
-
-    /* Check if king is attacked by other king */
-    for (auto const cardinal : Direction::Cardinals)
-    {
-        Position const tmpPos = kingPos + cardinal;
-        if (tmpPos.isValid() &&
-            (tmpPos.getRow() == kingPos.getRow() || tmpPos.getColumn() == kingPos.getColumn()) &&
-            getPieceAtPos(tmpPos) != Piece::Type::BLANK &&
-            Piece::getColorOfPiece(getPieceAtPos(tmpPos)) != color &&
-            Piece::getPieceTypeWithoutColor(getPieceAtPos(tmpPos)) == Piece::Type::KING)
-        {
-            return true;
-        }
-    }
-    for (auto const diagonal : Direction::Diagonals)
-    {
-        Position const tmpPos = kingPos + diagonal;
-        if (tmpPos.isValid() &&
-            abs(tmpPos.getColumn() - kingPos.getColumn()) == abs(tmpPos.getRow() - kingPos.getRow()) &&
-            getPieceAtPos(tmpPos) != Piece::Type::BLANK &&
-            Piece::getColorOfPiece(getPieceAtPos(tmpPos)) != color &&
-            Piece::getPieceTypeWithoutColor(getPieceAtPos(tmpPos)) == Piece::Type::KING)
-        {
-            return true;
-        }
-    }
-
-    return false;
+    return getAttackersToPos(getKingPosOfPiece(color), getOccupiedBitboard()) & getColorBitboard(Piece::getOppositeColor(color));
 }
 
 std::vector<Move> Game::getLegalMovesForPos(Position const pos)
@@ -406,7 +603,7 @@ std::vector<Move> Game::getLegalMovesForPos(Position const pos)
              tmpPos == enPassantPos))
         {
             /* Capture is a promotion */
-            if (tmpPos + Direction::Cardinal::SOUTH >= BOARD_SIZE)
+            if (tmpPos.getRow() == 1)
             {
                 moves.push_back(Move(pos, tmpPos, piece, Piece::Type::BLACK_QUEEN));
                 moves.push_back(Move(pos, tmpPos, piece, Piece::Type::BLACK_ROOK));
@@ -546,10 +743,48 @@ std::vector<Move> Game::getLegalMovesForPos(Position const pos)
         throw std::runtime_error("Invalid piece type");
     }
 
-    /* Check if move leaves own king attacked */
+    /* Check if move leaves own king attacked. A king move is legal if its destination is not
+       attacked once the king has left, castling also needs the square the king passes over.
+       Out of check a move of another piece can only be illegal if it is en passant or the piece
+       shields the king from a slider, only those moves are played on a copy */
+    bool const isKing = Piece::getPieceTypeWithoutColor(piece) == Piece::Type::KING;
+    Bitboard const withoutPiece = getOccupiedBitboard() & ~Bitboards::positionToBitboard(pos);
+    Bitboard const opponentPieces = getColorBitboard(Piece::getOppositeColor(color));
+    bool isSafe = false;
+    if (!isKing && !isKingInCheck(color))
+    {
+        Position const kingPos = getKingPosOfPiece(color);
+        Bitboard const bishopsAndQueens = (getPieceBitboard(Piece::Type::WHITE_BISHOP) | getPieceBitboard(Piece::Type::BLACK_BISHOP) |
+                                           getPieceBitboard(Piece::Type::WHITE_QUEEN) | getPieceBitboard(Piece::Type::BLACK_QUEEN)) &
+                                          opponentPieces;
+        Bitboard const rooksAndQueens = (getPieceBitboard(Piece::Type::WHITE_ROOK) | getPieceBitboard(Piece::Type::BLACK_ROOK) |
+                                         getPieceBitboard(Piece::Type::WHITE_QUEEN) | getPieceBitboard(Piece::Type::BLACK_QUEEN)) &
+                                        opponentPieces;
+        isSafe = !(Bitboards::bishopAttacks(kingPos, withoutPiece) & bishopsAndQueens) &&
+                 !(Bitboards::rookAttacks(kingPos, withoutPiece) & rooksAndQueens);
+    }
+
     std::vector<Move> legalMoves;
-    for (Move const move : moves)
+    legalMoves.reserve(moves.size());
+    for (Move const &move : moves)
     {
+        if (isKing)
+        {
+            bool const isCastling = abs(move.to.getColumn() - move.from.getColumn()) == 2;
+            Position const passedPos = (move.from + move.to) / 2;
+            if (!(getAttackersToPos(move.to, withoutPiece) & opponentPieces) &&
+                !(isCastling && (getAttackersToPos(passedPos, withoutPiece) & opponentPieces)))
+            {
+                legalMoves.push_back(move);
+            }
+            continue;
+        }
+        if (isSafe && !(Piece::getPieceTypeWithoutColor(piece) == Piece::Type::PAWN && move.to == enPassantPos))
+        {
+            legalMoves.push_back(move);
+            continue;
+        }
+
         Game gameCopy = Game(*this);
         gameCopy.makeMove(move);
         if (!gameCopy.isKingInCheck(color))
@@ -564,6 +799,17 @@ std::vector<Move> Game::getLegalMovesForPos(Position const pos)
 void Game::makeMove(Move const move)
 {
     Position newEnPassantPos = -1;
+    zobristKey ^= getStateKey();
+
+    /* A rook that leaves its corner or is captured on it takes the castling right of its side */
+    for (int const pos : {static_cast<int>(move.from), static_cast<int>(move.to)})
+    {
+        whiteCastlingQueenside = whiteCastlingQueenside && pos != 0;
+        whiteCastlingKingside = whiteCastlingKingside && pos != BOARD_LENGTH - 1;
+        blackCastlingQueenside = blackCastlingQueenside && pos != BOARD_SIZE - BOARD_LENGTH;
+        blackCastlingKingside = blackCastlingKingside && pos != BOARD_SIZE - 1;
+    }
+
     switch (move.piece)
     {
     case Piece::Type::WHITE_KING:
@@ -572,14 +818,14 @@ void Game::makeMove(Move const move)
             if (move.to == move.from + 2 * Direction::Cardinal::EAST)
             {
                 /* Castling king side */
-                board[move.to + Direction::Cardinal::EAST] = Piece::Type::BLANK;
-                board[move.to + Direction::Cardinal::WEST] = Piece::Type::WHITE_ROOK;
+                removePiece(move.to + Direction::Cardinal::EAST);
+                putPiece(move.to + Direction::Cardinal::WEST, Piece::Type::WHITE_ROOK);
             }
             else if (move.to == move.from + 2 * Direction::Cardinal::WEST)
             {
                 /* Castling queen side */
-                board[move.to + 2 * Direction::Cardinal::WEST] = Piece::Type::BLANK;
-                board[move.to + Direction::Cardinal::EAST] = Piece::Type::WHITE_ROOK;
+                removePiece(move.to + 2 * Direction::Cardinal::WEST);
+                putPiece(move.to + Direction::Cardinal::EAST, Piece::Type::WHITE_ROOK);
             }
             whiteCastlingKingside = false;
             whiteCastlingQueenside = false;
@@ -592,46 +838,27 @@ void Game::makeMove(Move const move)
             if (move.to == move.from + 2 * Direction::Cardinal::EAST)
             {
                 /* Castling king side */
-                board[move.to + Direction::Cardinal::EAST] = Piece::Type::BLANK;
-                board[move.to + Direction::Cardinal::WEST] = Piece::Type::BLACK_ROOK;
+                removePiece(move.to + Direction::Cardinal::EAST);
+                putPiece(move.to + Direction::Cardinal::WEST, Piece::Type::BLACK_ROOK);
             }
             else if (move.to == move.from - 2)
             {
                 /* Castling queen side */
-                board[move.to + 2 * Direction::Cardinal::WEST] = Piece::Type::BLANK;
-                board[move.to + Direction::Cardinal::EAST] = Piece::Type::BLACK_ROOK;
+                removePiece(move.to + 2 * Direction::Cardinal::WEST);
+                putPiece(move.to + Direction::Cardinal::EAST, Piece::Type::BLACK_ROOK);
             }
             blackCastlingKingside = false;
             blackCastlingQueenside = false;
         }
         blackKingPos = move.to;
         break;
-    case Piece::Type::WHITE_ROOK:
-        if (move.from.getColumn() == 0)
-        {
-            whiteCastlingQueenside = false;
-        }
-        else if (move.from.getColumn() == BOARD_LENGTH)
-        {
-            whiteCastlingKingside = false;
-        }
-        break;
-    case Piece::Type::BLACK_ROOK:
-        if (move.from.getColumn() == 0)
-        {
-            blackCastlingQueenside = false;
-        }
-        else if (move.from.getColumn() == BOARD_LENGTH)
-        {
-            blackCastlingKingside = false;
-        }
-        break;
     case Piece::Type::WHITE_PAWN:
         /* Promotion */
         if (move.to.getRow() == BOARD_LENGTH)
         {
-            board[move.from] = Piece::Type::BLANK;
-            board[move.to] = move.promotionPiece;
+            removePiece(move.from);
+            removePiece(move.to);
+            putPiece(move.to, move.promotionPiece);
             passTurn();
             return;
         }
@@ -639,7 +866,7 @@ void Game::makeMove(Move const move)
         if (move.to == enPassantPos)
         {
             // Capturing the en passant piece
-            board[move.to + Direction::Cardinal::SOUTH] = Piece::Type::BLANK;
+            removePiece(move.to + Direction::Cardinal::SOUTH);
         }
         else if (move.to == move.from + 2 * Direction::Cardinal::NORTH)
         {
@@ -650,8 +877,9 @@ void Game::makeMove(Move const move)
         /* Promotion */
         if (move.to.getRow() == 1)
         {
-            board[move.from] = Piece::Type::BLANK;
-            board[move.to] = move.promotionPiece;
+            removePiece(move.from);
+            removePiece(move.to);
+            putPiece(move.to, move.promotionPiece);
             passTurn();
             return;
         }
@@ -659,7 +887,7 @@ void Game::makeMove(Move const move)
         if (move.to == enPassantPos)
         {
             // Capturing the en passant piece
-            board[move.to + Direction::Cardinal::NORTH] = Piece::Type::BLANK;
+            removePiece(move.to + Direction::Cardinal::NORTH);
         }
         else if (move.to == move.from + 2 * Direction::Cardinal::SOUTH)
         {
@@ -670,8 +898,9 @@ void Game::makeMove(Move const move)
         break;
     }
 
-    board[move.from] = Piece::Type::BLANK;
-    board[move.to] = move.piece;
+    removePiece(move.from);
+    removePiece(move.to);
+    putPiece(move.to, move.piece);
     passTurn(newEnPassantPos);
     return;
 }
@@ -683,7 +912,6 @@ bool Game::isGameOver()
         return true;
     }
 
-    bool isCheck = isKingInCheck(turn);
     if (isKingInCheck(turn))
     {
         std::vector<Move> legalMoves;
@@ -702,7 +930,11 @@ bool Game::isGameOver()
         return true;
     }
 
-    /* Draws */
+    /* Draws, all of them by insufficient material with at most two pieces a side */
+    if (Bitboards::popCount(getOccupiedBitboard()) > 4)
+    {
+        return false;
+    }
     std::vector<std::pair<Piece::Type, Position>> whitePieces = getAllPiecesForColor(Piece::Color::WHITE);
     std::vector<std::pair<Piece::Type, Position>> blackPieces = getAllPiecesForColor(Piece::Color::BLACK);
     if (whitePieces.size() == 1 && blackPieces.size() == 1)
@@ -728,8 +960,8 @@ bool Game::isGameOver()
     }
     else if (whitePieces.size() == 2 && blackPieces.size() == 2)
     {
-        if (((whitePieces[0].first == Piece::Type::WHITE_BISHOP || blackPieces[1].first == Piece::Type::BLACK_BISHOP) ||
-             (whitePieces[0].first == Piece::Type::WHITE_KNIGHT || blackPieces[1].first == Piece::Type::BLACK_KNIGHT)) &&
+        if (((whitePieces[0].first == Piece::Type::WHITE_BISHOP || whitePieces[1].first == Piece::Type::WHITE_BISHOP) ||
+             (whitePieces[0].first == Piece::Type::WHITE_KNIGHT || whitePieces[1].first == Piece::Type::WHITE_KNIGHT)) &&
             ((blackPieces[0].first == Piece::Type::BLACK_BISHOP || blackPieces[1].first == Piece::Type::BLACK_BISHOP) ||
              (blackPieces[0].first == Piece::Type::BLACK_KNIGHT || blackPieces[1].first == Piece::Type::BLACK_KNIGHT)))
         {
@@ -761,41 +993,41 @@ bool Game::initGameFromFENString(std::string FENString)
             pos = row * BOARD_LENGTH - 1;
             break;
         case 'p':
-            board[pos] = Piece::Type::BLACK_PAWN;
+            putPiece(pos, Piece::Type::BLACK_PAWN);
             break;
         case 'P':
-            board[pos] = Piece::Type::WHITE_PAWN;
+            putPiece(pos, Piece::Type::WHITE_PAWN);
             break;
         case 'n':
-            board[pos] = Piece::Type::BLACK_KNIGHT;
+            putPiece(pos, Piece::Type::BLACK_KNIGHT);
             break;
         case 'N':
-            board[pos] = Piece::Type::WHITE_KNIGHT;
+            putPiece(pos, Piece::Type::WHITE_KNIGHT);
             break;
         case 'b':
-            board[pos] = Piece::Type::BLACK_BISHOP;
+            putPiece(pos, Piece::Type::BLACK_BISHOP);
             break;
         case 'B':
-            board[pos] = Piece::Type::WHITE_BISHOP;
+            putPiece(pos, Piece::Type::WHITE_BISHOP);
             break;
         case 'r':
-            board[pos] = Piece::Type::BLACK_ROOK;
+            putPiece(pos, Piece::Type::BLACK_ROOK);
             break;
         case 'R':
-            board[pos] = Piece::Type::WHITE_ROOK;
+            putPiece(pos, Piece::Type::WHITE_ROOK);
             break;
         case 'q':
-            board[pos] = Piece::Type::BLACK_QUEEN;
+            putPiece(pos, Piece::Type::BLACK_QUEEN);
             break;
         case 'Q':
-            board[pos] = Piece::Type::WHITE_QUEEN;
+            putPiece(pos, Piece::Type::WHITE_QUEEN);
             break;
         case 'k':
-            board[pos] = Piece::Type::BLACK_KING;
+            putPiece(pos, Piece::Type::BLACK_KING);
             blackKingPos = pos;
             break;
         case 'K':
-            board[pos] = Piece::Type::WHITE_KING;
+            putPiece(pos, Piece::Type::WHITE_KING);
             whiteKingPos = pos;
             break;
         default:
@@ -841,47 +1073,60 @@ bool Game::initGameFromFENString(std::string FENString)
     i += 2;
     if (i < lengthFENString && FENString[i - 1] == ' ')
     {
-        if (FENString[i] == 'K' || FENString[i] == 'Q' || FENString[i] == 'k' || FENString[i] == 'q')
+        /* initGame allows all castlings, only the ones listed are kept */
+        whiteCastlingKingside = false;
+        whiteCastlingQueenside = false;
+        blackCastlingKingside = false;
+        blackCastlingQueenside = false;
+        if (FENString[i] == '-')
         {
-            if (FENString[i++] == 'K')
-            {
-                whiteCastlingKingside = true;
-            }
-            if (i < lengthFENString && FENString[i++] == 'Q')
-            {
-                whiteCastlingQueenside = true;
-            }
-            if (i < lengthFENString && FENString[i++] == 'k')
-            {
-                blackCastlingKingside = true;
-            }
-            if (i < lengthFENString && FENString[i++] == 'q')
+            i++;
+        }
+        else
+        {
+            for (; i < lengthFENString && FENString[i] != ' '; i++)
             {
-                blackCastlingQueenside = true;
+                switch (FENString[i])
+                {
+                case 'K':
+                    whiteCastlingKingside = true;
+                    break;
+                case 'Q':
+                    whiteCastlingQueenside = true;
+                    break;
+                case 'k':
+                    blackCastlingKingside = true;
+                    break;
+                case 'q':
+                    blackCastlingQueenside = true;
+                    break;
+                default:
+                    return false;
+                }
             }
         }
-        else if (FENString[i++] != '-')
+        if (i >= lengthFENString || FENString[i++] != ' ')
         {
             return false;
         }
-        if (FENString[i++] != ' ')
+
+        if (i >= lengthFENString)
         {
             return false;
         }
-
-        if (FENString[i++] != '-')
+        if (FENString[i] != '-')
         {
-            if (i < lengthFENString - 1)
-                enPassantPos = FENString[i++] - 'a';
-            if (enPassantPos >= BOARD_LENGTH && i >= lengthFENString)
+            if (i + 1 >= lengthFENString)
             {
                 return false;
             }
-            enPassantPos += (FENString[i++] - '0') * BOARD_LENGTH;
-            if (enPassantPos >= BOARD_SIZE)
+            int const column = FENString[i] - 'a';
+            int const row = FENString[i + 1] - '1';
+            if (column < 0 || column >= BOARD_LENGTH || row < 0 || row >= BOARD_LENGTH)
             {
                 return false;
             }
+            enPassantPos = row * BOARD_LENGTH + column;
         }
     }
     else
@@ -889,9 +1134,53 @@ bool Game::initGameFromFENString(std::string FENString)
         return false;
     }
 
+    zobristKey = computeZobristKey();
     return true;
 }
 
+std::string Game::getFEN()
+{
+    std::string FEN;
+    for (int row = BOARD_LENGTH - 1; row >= 0; row--)
+    {
+        int empty = 0;
+        for (int column = 0; column < BOARD_LENGTH; column++)
+        {
+            Piece::Type const piece = board[row * BOARD_LENGTH + column];
+            if (piece == Piece::Type::BLANK)
+            {
+                empty++;
+                continue;
+            }
+            if (empty > 0)
+            {
+                FEN += std::to_string(empty);
+                empty = 0;
+            }
+            FEN += Piece::pieceToChar(piece);
+        }
+        if (empty > 0)
+        {
+            FEN += std::to_string(empty);
+        }
+        if (row > 0)
+        {
+            FEN += '/';
+        }
+    }
+
+    FEN += turn == Piece::Color::WHITE ? " w " : " b ";
+    std::string castling;
+    castling += whiteCastlingKingside ? "K" : "";
+    castling += whiteCastlingQueenside ? "Q" : "";
+    castling += blackCastlingKingside ? "k" : "";
+    castling += blackCastlingQueenside ? "q" : "";
+    FEN += castling.empty() ? "-" : castling;
+    FEN += ' ';
+    FEN += enPassantPos.isValid() ? enPassantPos.toChessNotation() : "-";
+    return FEN;
+}
+
 void Game::printGame()
 {
     std::cout << "--------===== PRINTING STATE =====--------" << std::endl
@@ -954,4 +1243,4 @@ void Game::printGame()
         }
         std::cout << std::endl;
     }
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "../include/interface.h"
 
+#include <cstdio>
+
 Interface::Interface() : window(nullptr),
                          renderer(nullptr),
                          screenWidth(STARTING_SCREEN_WIDTH),
@@ -10,6 +12,7 @@ Interface::Interface() : window(nullptr),
                          running(false),
                          gameOver(false),
                          testSuite(TestSuite()),
+                         stopEngine(false),
                          dragPiece(Piece::Type::BLANK),
                          dragPiecePos(Position(-1)),
                          dragPieceLegalMoves(std::vector<Move>()),
@@ -21,6 +24,9 @@ Interface::Interface() : window(nullptr),
 
 Interface::~Interface()
 {
+    /* The worker thread uses the players, so it has to finish first */
+    cancelEngineMove();
+
     /* Destroy window */
     if (window)
     {
@@ -67,7 +73,7 @@ void Interface::menuGamemode(Piece::Color const color)
         {
             std::cout << ">> Input the player for black" << std::endl;
         }
-        std::cout << ">> \"1\": human player | \"2\": random move engine | \"3\": minimax engine" << std::endl
+        std::cout << ">> \"1\": human player | \"2\": random move engine | \"3\": minimax engine | \"4\": Monte Carlo tree search engine" << std::endl
                   << std::endl;
         getline(std::cin, playerInput);
         std::cout << std::endl;
@@ -84,6 +90,9 @@ void Interface::menuGamemode(Piece::Color const color)
             case '3':
                 color == Piece::Color::WHITE ? playerWhite = std::make_unique<PlayerEngineMiniMax>() : playerBlack = std::make_unique<PlayerEngineMiniMax>();
                 return;
+            case '4':
+                color == Piece::Color::WHITE ? playerWhite = std::make_unique<PlayerEngineMCTS>() : playerBlack = std::make_unique<PlayerEngineMCTS>();
+                return;
             }
         }
         std::cerr << ">> Invalid input, please try again" << std::endl
@@ -91,6 +100,33 @@ void Interface::menuGamemode(Piece::Color const color)
     }
 }
 
+void Interface::menuClock()
+{
+    while (true)
+    {
+        std::string input;
+        std::cout << ">> Input the time control as \"<minutes>+<increment in seconds>\" or \"none\" to play without clocks" << std::endl
+                  << ">> Example of expected input: \"5+3\"" << std::endl
+                  << std::endl;
+        getline(std::cin, input);
+        std::cout << std::endl;
+        if (input == "none")
+        {
+            clock.set(0, 0);
+            return;
+        }
+        double minutes = 0;
+        double seconds = 0;
+        if (std::sscanf(input.c_str(), "%lf+%lf", &minutes, &seconds) == 2 && minutes > 0 && seconds >= 0)
+        {
+            clock.set(static_cast<int64_t>(minutes * 60000), static_cast<int64_t>(seconds * 1000));
+            return;
+        }
+        std::cerr << ">> Invalid input, please try again" << std::endl
+                  << std::endl;
+    }
+}
+
 void Interface::menuFEN()
 {
     // while (true)
@@ -123,6 +159,7 @@ bool Interface::menu()
         std::cout << ">> What would you like to do? (Input a letter)" << std::endl
                   << "\"S\": Start the Chess game" << std::endl
                   << "\"P\": Change the Player types" << std::endl
+                  << "\"K\": Set the Clocks" << std::endl
                   << "\"T\": Open the Test menu" << std::endl
                   << "\"Q\": Quit program"
                   << std::endl
@@ -143,6 +180,10 @@ bool Interface::menu()
                 menuGamemode(Piece::Color::WHITE);
                 menuGamemode(Piece::Color::BLACK);
                 break;
+            case 'K':
+            case 'k':
+                menuClock();
+                break;
             case 'C':
             case 'c':
                 menuFEN();
@@ -235,6 +276,7 @@ void Interface::initiate()
     loadTexturePieces();
 
     running = true;
+    clock.start(game->getTurn());
 }
 
 void Interface::eventHandler(SDL_Event event)
@@ -277,7 +319,18 @@ void Interface::eventHandler(SDL_Event event)
             releaseDragPiece(mouseX, mouseY);
         }
         break;
+    case SDL_KEYDOWN:
+        if (event.key.keysym.sym == SDLK_r)
+        {
+            resetGame();
+        }
+        else if (event.key.keysym.sym == SDLK_x)
+        {
+            resign();
+        }
+        break;
     case SDL_QUIT:
+        cancelEngineMove();
         running = false;
         break;
     default:
@@ -292,6 +345,7 @@ void Interface::render()
 
     renderBoard();
     renderState();
+    renderClock();
 
     if (dragPiece != Piece::Type::BLANK)
     {
@@ -303,6 +357,24 @@ void Interface::render()
     SDL_RenderPresent(renderer);
 }
 
+void Interface::renderClock()
+{
+    if (!clock.isEnabled())
+    {
+        return;
+    }
+
+    /* Without a font library the clocks are shown in the window title, the side to move is marked */
+    bool const isWhiteToMove = game->getTurn() == Piece::Color::WHITE;
+    std::string const title = std::string("Chess | ") + (isWhiteToMove && !gameOver ? "> " : "") + "White " + ChessClock::timeToString(clock.getRemaining(Piece::Color::WHITE)) +
+                              " | " + (!isWhiteToMove && !gameOver ? "> " : "") + "Black " + ChessClock::timeToString(clock.getRemaining(Piece::Color::BLACK));
+    if (title != windowTitle)
+    {
+        windowTitle = title;
+        SDL_SetWindowTitle(window, windowTitle.c_str());
+    }
+}
+
 void Interface::loadTexturePieces()
 {
     std::unordered_map<Piece::Type, char *> PNGLocations;
@@ -367,40 +439,108 @@ void Interface::handlePlayerTurn()
             throw std::invalid_argument("Game over. Game still says it's ongoing. This should not happen.");
         }
         gameOver = true;
+        clock.stop();
+        return;
+    }
+    if (clock.isOutOfTime(game->getTurn()))
+    {
+        logIt(LogLevel::INFO) << "Game over. " << (game->getTurn() == Piece::Color::WHITE ? "White ran out of time, Black wins!" : "Black ran out of time, White wins!");
+        cancelEngineMove();
+        gameOver = true;
+        clock.stop();
         return;
     }
-    if (game->getTurn() == Piece::Color::WHITE)
+    Player *player = game->getTurn() == Piece::Color::WHITE ? playerWhite.get() : playerBlack.get();
+    if (player->isHuman())
     {
-        if (!playerWhite->isHuman())
+        return;
+    }
+    if (engineMove.valid())
+    {
+        /* The time until the move is shown (ENGINE_DELAY) is not on the clock of the engine */
+        if (engineMove.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
         {
-            Move move = playerWhite->getMove(Game(*game));
-            game->makeMove(move);
-            if (move.promotionPiece != Piece::Type::BLANK)
-            {
-                logIt(LogLevel::INFO) << "Player Engine White made move " << move << " with promotion to " << move.promotionPiece;
-            }
-            else
-            {
-                logIt(LogLevel::INFO) << "Player Engine White made move " << move;
-            }
+            clock.stop();
         }
+        return;
+    }
+
+    /* The worker gets a copy of the game, the interface keeps rendering the real one */
+    stopEngine = false;
+    player->setStopFlag(&stopEngine);
+    player->setTimeControl(clock.getTimeControl());
+    engineMove = std::async(std::launch::async, [player, position = Game(*game)]()
+                            { return player->getMove(position); });
+}
+
+bool Interface::applyEngineMove()
+{
+    if (!engineMove.valid() || engineMove.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return false;
+    }
+
+    Move const move = engineMove.get();
+    Player *player = game->getTurn() == Piece::Color::WHITE ? playerWhite.get() : playerBlack.get();
+    std::string const color = game->getTurn() == Piece::Color::WHITE ? "White" : "Black";
+    game->makeMove(move);
+    clock.switchTurn();
+    if (move.promotionPiece != Piece::Type::BLANK)
+    {
+        logIt(LogLevel::INFO) << "Player Engine " << color << " made move " << move << " with promotion to " << move.promotionPiece;
     }
     else
     {
-        if (!playerBlack->isHuman())
+        logIt(LogLevel::INFO) << "Player Engine " << color << " made move " << move;
+    }
+
+    /* Think on the opponent's time until its move is made */
+    player->startPondering(Game(*game));
+    return true;
+}
+
+void Interface::cancelEngineMove()
+{
+    /* A worker thread on a ponder hit still uses the ponder search, so it is stopped first */
+    if (engineMove.valid())
+    {
+        stopEngine = true;
+        engineMove.wait();
+        try
         {
-            Move move = playerBlack->getMove(Game(*game));
-            game->makeMove(move);
-            if (move.promotionPiece != Piece::Type::BLANK)
-            {
-                logIt(LogLevel::INFO) << "Player Engine Black made move " << move << " with promotion to " << move.promotionPiece;
-            }
-            else
-            {
-                logIt(LogLevel::INFO) << "Player Engine Black made move " << move;
-            }
+            engineMove.get();
         }
+        catch (std::exception const &exception)
+        {
+            logIt(LogLevel::WARNING) << "Cancelled engine move failed: " << exception.what();
+        }
+    }
+    playerWhite->stopPondering();
+    playerBlack->stopPondering();
+}
+
+void Interface::resetGame()
+{
+    cancelEngineMove();
+    game = std::make_unique<Game>();
+    gameOver = false;
+    clock.reset();
+    clock.start(game->getTurn());
+    dragPiece = Piece::Type::BLANK;
+    dragPieceLegalMoves.clear();
+    logIt(LogLevel::INFO) << "The game is reset";
+}
+
+void Interface::resign()
+{
+    if (gameOver)
+    {
+        return;
     }
+    cancelEngineMove();
+    gameOver = true;
+    clock.stop();
+    logIt(LogLevel::INFO) << "Game over. " << (game->getTurn() == Piece::Color::WHITE ? "White resigns, Black wins!" : "Black resigns, White wins!");
 }
 
 void Interface::renderBoard()
@@ -566,11 +706,13 @@ void Interface::releaseDragPiece(int const mouseX, int const mouseY)
                 // Promotion
                 const Move promotionMove(legalMove.from, legalMove.to, legalMove.piece, menuPawnPromotion());
                 game->makeMove(promotionMove);
+                clock.switchTurn();
                 logIt(LogLevel::INFO) << "Player Human " << Piece::getColorOfPiece(legalMove.piece) << " made move " << promotionMove << " with promotion to " << promotionMove.promotionPiece;
                 break;
             }
 
             game->makeMove(legalMove);
+            clock.switchTurn();
             logIt(LogLevel::INFO) << "Player Human " << Piece::getColorOfPiece(legalMove.piece) << " made move " << legalMove;
             break;
         }
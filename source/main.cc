@@ -1,12 +1,35 @@
 #include <SDL2/SDL.h>
 
+#include "../include/evaluationweights.h"
 #include "../include/interface.h"
+#include "../include/piecesquaretable.h"
+#include "../include/testsuite.h"
+#include "../include/uci.h"
 
 #define TARGET_FPS 60
 #define ENGINE_DELAY 1000
 
 int main(int argc, char *argv[])
 {
+    /* The tables are needed by every game, so they are computed and tuned before anything else */
+    PieceSquareTable::init();
+    EvalParameters::loadStartupParameters(DEFAULT_PARAMETER_FILE);
+
+    /* UCI mode for chess GUIs and match managers, stdout only carries the protocol */
+    if (argc > 1 && std::string(argv[1]) == "uci")
+    {
+        UCI uci;
+        uci.run();
+        return 0;
+    }
+
+    /* Regression tests without the interface, the exit code tells if they passed */
+    if (argc > 1 && std::string(argv[1]) == "test")
+    {
+        TestSuite testSuite;
+        return testSuite.runRegressionTests() ? 0 : 1;
+    }
+
     std::cout << "---------========== Chess Game ==========----------" << std::endl
               << "  Made By James Montyn at github.com/JamesMontyn " << std::endl
               << "  Programmed in C++, with SDL 2.0                " << std::endl
@@ -25,11 +48,14 @@ int main(int argc, char *argv[])
     {
         frameStart = SDL_GetTicks();
 
-        /* Process engine moves */
-        if (!interface->isGameOver() && frameStart - lastEngineMove >= ENGINE_DELAY)
+        /* Engine moves are computed in the background, they are only shown ENGINE_DELAY apart */
+        if (!interface->isGameOver())
         {
-            lastEngineMove = frameStart;
             interface->handlePlayerTurn();
+            if (frameStart - lastEngineMove >= ENGINE_DELAY && interface->applyEngineMove())
+            {
+                lastEngineMove = frameStart;
+            }
         }
         interface->render();
 
@@ -52,4 +78,4 @@ int main(int argc, char *argv[])
     delete interface;
 
     return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
@@ -0,0 +1,318 @@
+#include "../include/nnue.h"
+#include "../include/logger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+
+/* The AVX2 kernels are built on x86 whatever the flags of the build, the processor decides at runtime */
+#if defined(__x86_64__) || defined(__i386__)
+#define NNUE_HAS_AVX2_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace NNUE
+{
+  namespace
+  {
+    struct Network
+    {
+      alignas(32) int16_t featureWeights[NNUE_INPUTS][NNUE_HIDDEN];
+      alignas(32) int16_t featureBiases[NNUE_HIDDEN];
+      alignas(32) int8_t layer2Weights[NNUE_LAYER2][2 * NNUE_HIDDEN];
+      int32_t layer2Biases[NNUE_LAYER2];
+      alignas(32) int8_t outputWeights[NNUE_LAYER2];
+      int32_t outputBias;
+    };
+
+    std::unique_ptr<Network> network;
+    int generation = 0;
+    bool useAvx2 = false;
+
+    /* Searches hold it shared, so the network is never replaced under a search */
+    std::shared_mutex networkMutex;
+
+    /**
+     * @brief index of the input of a piece on a position as seen from a side,
+     *          black sees the board mirrored with the colors swapped
+     */
+    inline int featureIndex(int const side, Piece::Type const piece, int const pos)
+    {
+      int const pieceIndex = Piece::getPieceIndex(piece);
+      if (side == 0)
+      {
+        return pieceIndex * BOARD_SIZE + pos;
+      }
+      return ((pieceIndex + 6) % 12) * BOARD_SIZE + (pos ^ (BOARD_SIZE - BOARD_LENGTH));
+    }
+
+#if defined(NNUE_HAS_AVX2_KERNELS)
+    /* The AVX2 kernels are compiled for AVX2 on their own and only called if the processor has it,
+       so the rest of the program runs on any x86 processor */
+    __attribute__((target("avx2"))) void addRowAvx2(int16_t *values, int16_t const *row)
+    {
+      for (int i = 0; i < NNUE_HIDDEN; i += 16)
+      {
+        __m256i const sum = _mm256_add_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(values + i)),
+                                             _mm256_loadu_si256(reinterpret_cast<__m256i const *>(row + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), sum);
+      }
+    }
+
+    __attribute__((target("avx2"))) void subtractRowAvx2(int16_t *values, int16_t const *row)
+    {
+      for (int i = 0; i < NNUE_HIDDEN; i += 16)
+      {
+        __m256i const difference = _mm256_sub_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(values + i)),
+                                                    _mm256_loadu_si256(reinterpret_cast<__m256i const *>(row + i)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(values + i), difference);
+      }
+    }
+
+    __attribute__((target("avx2"))) void clipAccumulatorAvx2(int16_t const *values, uint8_t *output)
+    {
+      __m256i const zero = _mm256_setzero_si256();
+      for (int i = 0; i < NNUE_HIDDEN; i += 32)
+      {
+        __m256i const low = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(values + i));
+        __m256i const high = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(values + i + 16));
+        /* Packing saturates at NNUE_ACTIVATION_MAX but interleaves the 128 bit lanes, the permute undoes that */
+        __m256i const packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(low, high), 0b11011000);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(output + i), _mm256_max_epi8(packed, zero));
+      }
+    }
+
+    __attribute__((target("avx2"))) int32_t dotProductAvx2(uint8_t const *input, int8_t const *weights, int const size)
+    {
+      __m256i const ones = _mm256_set1_epi16(1);
+      __m256i sum = _mm256_setzero_si256();
+      for (int i = 0; i < size; i += 32)
+      {
+        /* Pairs of products fit in int16 since the activations are at most NNUE_ACTIVATION_MAX */
+        __m256i const products = _mm256_maddubs_epi16(_mm256_loadu_si256(reinterpret_cast<__m256i const *>(input + i)),
+                                                      _mm256_loadu_si256(reinterpret_cast<__m256i const *>(weights + i)));
+        sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+      }
+      __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+      sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0b01001110));
+      sum128 = _mm_add_epi32(sum128, _mm_shuffle_epi32(sum128, 0b10110001));
+      return _mm_cvtsi128_si32(sum128);
+    }
+#endif
+
+    bool supportsAvx2()
+    {
+#if defined(NNUE_HAS_AVX2_KERNELS)
+      __builtin_cpu_init();
+      return __builtin_cpu_supports("avx2");
+#else
+      return false;
+#endif
+    }
+
+    inline void addRow(int16_t *values, int16_t const *row)
+    {
+#if defined(NNUE_HAS_AVX2_KERNELS)
+      if (useAvx2)
+      {
+        addRowAvx2(values, row);
+        return;
+      }
+#endif
+      for (int i = 0; i < NNUE_HIDDEN; i++)
+      {
+        values[i] += row[i];
+      }
+    }
+
+    inline void subtractRow(int16_t *values, int16_t const *row)
+    {
+#if defined(NNUE_HAS_AVX2_KERNELS)
+      if (useAvx2)
+      {
+        subtractRowAvx2(values, row);
+        return;
+      }
+#endif
+      for (int i = 0; i < NNUE_HIDDEN; i++)
+      {
+        values[i] -= row[i];
+      }
+    }
+
+    /**
+     * @brief clipped ReLU of one half of the accumulator into the int8 input of layer 2
+     */
+    inline void clipAccumulator(int16_t const *values, uint8_t *output)
+    {
+#if defined(NNUE_HAS_AVX2_KERNELS)
+      if (useAvx2)
+      {
+        clipAccumulatorAvx2(values, output);
+        return;
+      }
+#endif
+      for (int i = 0; i < NNUE_HIDDEN; i++)
+      {
+        output[i] = static_cast<uint8_t>(std::clamp<int>(values[i], 0, NNUE_ACTIVATION_MAX));
+      }
+    }
+
+    /**
+     * @brief dot product of clipped activations and int8 weights, size is a multiple of 32
+     */
+    inline int32_t dotProduct(uint8_t const *input, int8_t const *weights, int const size)
+    {
+#if defined(NNUE_HAS_AVX2_KERNELS)
+      if (useAvx2)
+      {
+        return dotProductAvx2(input, weights, size);
+      }
+#endif
+      int32_t sum = 0;
+      for (int i = 0; i < size; i++)
+      {
+        sum += static_cast<int32_t>(input[i]) * weights[i];
+      }
+      return sum;
+    }
+
+    template <typename T>
+    bool readValues(std::ifstream &file, T *values, size_t const count)
+    {
+      file.read(reinterpret_cast<char *>(values), count * sizeof(T));
+      return static_cast<bool>(file);
+    }
+  };
+
+  bool load(std::string const &path)
+  {
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+      logIt(LogLevel::INFO) << "No network file " << path << " found";
+      return false;
+    }
+
+    uint32_t header[5];
+    if (!readValues(file, header, 5) || header[0] != NNUE_FILE_MAGIC || header[1] != NNUE_FILE_VERSION ||
+        header[2] != NNUE_INPUTS || header[3] != NNUE_HIDDEN || header[4] != NNUE_LAYER2)
+    {
+      logIt(LogLevel::WARNING) << "Network file " << path << " has an unsupported header";
+      return false;
+    }
+
+    auto loaded = std::make_unique<Network>();
+    bool const isComplete = readValues(file, &loaded->featureWeights[0][0], NNUE_INPUTS * NNUE_HIDDEN) &&
+                            readValues(file, loaded->featureBiases, NNUE_HIDDEN) &&
+                            readValues(file, &loaded->layer2Weights[0][0], NNUE_LAYER2 * 2 * NNUE_HIDDEN) &&
+                            readValues(file, loaded->layer2Biases, NNUE_LAYER2) &&
+                            readValues(file, loaded->outputWeights, NNUE_LAYER2) &&
+                            readValues(file, &loaded->outputBias, 1);
+    if (!isComplete)
+    {
+      logIt(LogLevel::WARNING) << "Network file " << path << " is truncated";
+      return false;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(networkMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+      logIt(LogLevel::WARNING) << "Network " << path << " is not loaded, the network cannot change during a search";
+      return false;
+    }
+    network = std::move(loaded);
+    generation++;
+    useAvx2 = supportsAvx2();
+    logIt(LogLevel::INFO) << "Loaded network " << path << " with the " << (useAvx2 ? "AVX2" : "scalar") << " kernels";
+    return true;
+  }
+
+  bool unload()
+  {
+    std::unique_lock<std::shared_mutex> lock(networkMutex, std::try_to_lock);
+    if (!lock.owns_lock())
+    {
+      logIt(LogLevel::WARNING) << "The network cannot be unloaded during a search";
+      return false;
+    }
+    network.reset();
+    return true;
+  }
+
+  UsageLock::UsageLock()
+  {
+    networkMutex.lock_shared();
+  }
+
+  UsageLock::~UsageLock()
+  {
+    networkMutex.unlock_shared();
+  }
+
+  bool isLoaded()
+  {
+    return network != nullptr;
+  }
+
+  bool isUpToDate(Accumulator const &accumulator)
+  {
+    return network && accumulator.generation == generation;
+  }
+
+  void refreshAccumulator(Accumulator &accumulator, Piece::Type const board[BOARD_SIZE])
+  {
+    for (int side = 0; side < 2; side++)
+    {
+      std::copy(network->featureBiases, network->featureBiases + NNUE_HIDDEN, accumulator.values[side]);
+    }
+    for (int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+      if (board[pos] != Piece::Type::BLANK)
+      {
+        for (int side = 0; side < 2; side++)
+        {
+          addRow(accumulator.values[side], network->featureWeights[featureIndex(side, board[pos], pos)]);
+        }
+      }
+    }
+    accumulator.generation = generation;
+  }
+
+  void addPiece(Accumulator &accumulator, Piece::Type const piece, int const pos)
+  {
+    for (int side = 0; side < 2; side++)
+    {
+      addRow(accumulator.values[side], network->featureWeights[featureIndex(side, piece, pos)]);
+    }
+  }
+
+  void removePiece(Accumulator &accumulator, Piece::Type const piece, int const pos)
+  {
+    for (int side = 0; side < 2; side++)
+    {
+      subtractRow(accumulator.values[side], network->featureWeights[featureIndex(side, piece, pos)]);
+    }
+  }
+
+  Score evaluate(Accumulator const &accumulator, Piece::Color const turn)
+  {
+    /* The side to move comes first, so the network knows whose turn it is */
+    int const us = Piece::getColorIndex(turn);
+    alignas(32) uint8_t input[2 * NNUE_HIDDEN];
+    clipAccumulator(accumulator.values[us], input);
+    clipAccumulator(accumulator.values[1 - us], input + NNUE_HIDDEN);
+
+    alignas(32) uint8_t hidden[NNUE_LAYER2];
+    for (int i = 0; i < NNUE_LAYER2; i++)
+    {
+      int32_t const sum = network->layer2Biases[i] + dotProduct(input, network->layer2Weights[i], 2 * NNUE_HIDDEN);
+      hidden[i] = static_cast<uint8_t>(std::clamp(sum >> NNUE_LAYER2_SHIFT, 0, NNUE_ACTIVATION_MAX));
+    }
+
+    int32_t const output = network->outputBias + dotProduct(hidden, network->outputWeights, NNUE_LAYER2);
+    return std::clamp(output / NNUE_OUTPUT_DIVISOR, -SCORE_MATE_IN_MAX_PLY + 1, SCORE_MATE_IN_MAX_PLY - 1);
+  }
+};
@@ -0,0 +1,287 @@
+#include "../include/openingbook.h"
+#include "../include/game.h"
+#include "../include/logger.h"
+#include "../include/polyglotkeys.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  inline uint64_t readBigEndian(unsigned char const *bytes, int const numOfBytes)
+  {
+    uint64_t value = 0;
+    for (int i = 0; i < numOfBytes; i++)
+    {
+      value = (value << 8) | bytes[i];
+    }
+    return value;
+  }
+
+  /**
+   * @brief index of a piece in the Polyglot keys, the black piece of a type comes
+   *          before the white one and the types go from pawn to king
+   */
+  inline int polyglotPieceIndex(Piece::Type const piece)
+  {
+    int const type = Piece::getPieceIndex(piece) % 6;
+    return 2 * type + (Piece::getColorOfPiece(piece) == Piece::Color::WHITE ? 1 : 0);
+  }
+
+  uint64_t getPolyglotKey(Game &game)
+  {
+    uint64_t key = 0;
+    for (int index = 0; index < NUM_OF_PIECE_TYPES; index++)
+    {
+      Piece::Type const piece = static_cast<Piece::Type>((index < 6 ? Piece::Color::WHITE : Piece::Color::BLACK) | (1 << (index % 6)));
+      Bitboard pieces = game.getPieceBitboard(piece);
+      while (pieces)
+      {
+        key ^= Polyglot::keys[64 * polyglotPieceIndex(piece) + Bitboards::popLsb(pieces)];
+      }
+    }
+
+    if (game.getCastlingKingSide(Piece::Color::WHITE))
+    {
+      key ^= Polyglot::keys[POLYGLOT_CASTLING_OFFSET];
+    }
+    if (game.getCastlingQueenSide(Piece::Color::WHITE))
+    {
+      key ^= Polyglot::keys[POLYGLOT_CASTLING_OFFSET + 1];
+    }
+    if (game.getCastlingKingSide(Piece::Color::BLACK))
+    {
+      key ^= Polyglot::keys[POLYGLOT_CASTLING_OFFSET + 2];
+    }
+    if (game.getCastlingQueenSide(Piece::Color::BLACK))
+    {
+      key ^= Polyglot::keys[POLYGLOT_CASTLING_OFFSET + 3];
+    }
+
+    /* The en passant file only counts if a pawn of the player to move can capture on it */
+    Position const enPassantPos = game.getEnPassantPos();
+    if (enPassantPos.isValid())
+    {
+      Piece::Color const turn = game.getTurn();
+      Bitboard const pawns = game.getPieceBitboard(static_cast<Piece::Type>(turn | Piece::Type::PAWN));
+      if (Bitboards::pawnAttacks(Piece::getOppositeColor(turn), enPassantPos) & pawns)
+      {
+        key ^= Polyglot::keys[POLYGLOT_EN_PASSANT_OFFSET + enPassantPos % BOARD_LENGTH];
+      }
+    }
+
+    if (game.getTurn() == Piece::Color::WHITE)
+    {
+      key ^= Polyglot::keys[POLYGLOT_TURN_OFFSET];
+    }
+    return key;
+  }
+};
+
+OpeningBook::OpeningBook() : data(nullptr),
+                             mappedSize(0),
+                             numOfEntries(0),
+                             random(std::random_device()())
+{
+}
+
+OpeningBook::~OpeningBook()
+{
+  close();
+}
+
+bool OpeningBook::open(std::string const &path)
+{
+  close();
+
+  int const file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    logIt(LogLevel::DEBUG) << "No opening book at " << path;
+    return false;
+  }
+  struct stat fileStat;
+  if (fstat(file, &fileStat) != 0 || fileStat.st_size < BOOK_ENTRY_SIZE || fileStat.st_size % BOOK_ENTRY_SIZE != 0)
+  {
+    logIt(LogLevel::WARNING) << "Opening book " << path << " is not a Polyglot book";
+    ::close(file);
+    return false;
+  }
+
+  void *mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  /* The mapping stays valid after the file is closed */
+  ::close(file);
+  if (mapped == MAP_FAILED)
+  {
+    logIt(LogLevel::WARNING) << "Failed to map opening book " << path;
+    return false;
+  }
+
+  data = static_cast<unsigned char const *>(mapped);
+  mappedSize = fileStat.st_size;
+  numOfEntries = mappedSize / BOOK_ENTRY_SIZE;
+  logIt(LogLevel::INFO) << "Loaded opening book " << path << " with " << numOfEntries << " entries";
+  return true;
+}
+
+void OpeningBook::close()
+{
+  if (data)
+  {
+    munmap(const_cast<unsigned char *>(data), mappedSize);
+  }
+  data = nullptr;
+  mappedSize = 0;
+  numOfEntries = 0;
+}
+
+bool OpeningBook::isOpen() const
+{
+  return data != nullptr;
+}
+
+size_t OpeningBook::getNumOfEntries() const
+{
+  return numOfEntries;
+}
+
+BookEntry OpeningBook::readEntry(size_t const index) const
+{
+  unsigned char const *bytes = data + index * BOOK_ENTRY_SIZE;
+  BookEntry entry;
+  entry.key = readBigEndian(bytes, 8);
+  entry.move = static_cast<uint16_t>(readBigEndian(bytes + 8, 2));
+  entry.weight = static_cast<uint16_t>(readBigEndian(bytes + 10, 2));
+  entry.learn = static_cast<uint32_t>(readBigEndian(bytes + 12, 4));
+  return entry;
+}
+
+std::vector<BookMove> OpeningBook::getMoves(Game &game) const
+{
+  std::vector<BookMove> moves;
+  if (!isOpen())
+  {
+    return moves;
+  }
+
+  /* Binary search for the first entry of the key */
+  uint64_t const key = getKey(game);
+  size_t low = 0;
+  size_t high = numOfEntries;
+  while (low < high)
+  {
+    size_t const middle = low + (high - low) / 2;
+    if (readEntry(middle).key < key)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  for (size_t index = low; index < numOfEntries; index++)
+  {
+    BookEntry const entry = readEntry(index);
+    if (entry.key != key)
+    {
+      break;
+    }
+    Move move;
+    if (decodeMove(game, entry.move, move))
+    {
+      moves.push_back({move, entry.weight});
+    }
+  }
+  std::stable_sort(moves.begin(), moves.end(), [](BookMove const &a, BookMove const &b)
+                   { return a.weight > b.weight; });
+  return moves;
+}
+
+bool OpeningBook::probe(Game &game, BookSelection const selection, Move &move)
+{
+  std::vector<BookMove> const moves = getMoves(game);
+  if (moves.empty())
+  {
+    return false;
+  }
+
+  uint64_t totalWeight = 0;
+  for (auto const &bookMove : moves)
+  {
+    totalWeight += bookMove.weight;
+  }
+  if (selection == BookSelection::BEST || totalWeight == 0)
+  {
+    move = moves[0].move;
+    return true;
+  }
+
+  uint64_t pick = std::uniform_int_distribution<uint64_t>(0, totalWeight - 1)(random);
+  for (auto const &bookMove : moves)
+  {
+    if (pick < bookMove.weight)
+    {
+      move = bookMove.move;
+      return true;
+    }
+    pick -= bookMove.weight;
+  }
+  move = moves[0].move;
+  return true;
+}
+
+uint64_t OpeningBook::getKey(Game &game)
+{
+  return getPolyglotKey(game);
+}
+
+uint16_t OpeningBook::encodeMove(Move const &move)
+{
+  int to = move.to;
+  if (Piece::getPieceTypeWithoutColor(move.piece) == Piece::Type::KING && std::abs(move.to - move.from) == 2)
+  {
+    /* Castling, the king goes to the square of the rook */
+    to = move.to > move.from ? move.from + 3 : move.from - 4;
+  }
+
+  int promotion = 0;
+  switch (Piece::getPieceTypeWithoutColor(move.promotionPiece))
+  {
+  case Piece::Type::KNIGHT:
+    promotion = 1;
+    break;
+  case Piece::Type::BISHOP:
+    promotion = 2;
+    break;
+  case Piece::Type::ROOK:
+    promotion = 3;
+    break;
+  case Piece::Type::QUEEN:
+    promotion = 4;
+    break;
+  default:
+    break;
+  }
+  return static_cast<uint16_t>(to | (move.from << 6) | (promotion << 12));
+}
+
+bool OpeningBook::decodeMove(Game &game, uint16_t const bookMove, Move &move)
+{
+  /* Matching the encoding of the legal moves also handles castling and promotions */
+  for (auto const &legalMove : game.getAllLegalMoves())
+  {
+    if (encodeMove(legalMove) == bookMove)
+    {
+      move = legalMove;
+      return true;
+    }
+  }
+  return false;
+}
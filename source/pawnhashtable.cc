@@ -0,0 +1,27 @@
+#include "../include/pawnhashtable.h"
+#include "../include/hashtable.h"
+
+PawnHashTable::PawnHashTable(size_t const sizeKB)
+{
+  resize(sizeKB);
+}
+
+void PawnHashTable::resize(size_t const sizeKB)
+{
+  entries.assign(HashTables::floorPowerOfTwo((sizeKB * 1024) / sizeof(PawnEntry)), PawnEntry());
+  clear();
+}
+
+void PawnHashTable::clear()
+{
+  for (auto &entry : entries)
+  {
+    entry.key = 0;
+    entry.isValid = false;
+  }
+}
+
+PawnEntry &PawnHashTable::getEntry(uint64_t const pawnKey)
+{
+  return entries[pawnKey & (entries.size() - 1)];
+}
@@ -0,0 +1,144 @@
+#include "../include/piecesquaretable.h"
+
+namespace PieceSquareTable
+{
+  Score middlegamePieceValues[NUM_OF_PIECE_KINDS] = {100, 300, 300, 500, 900, 0};
+  Score endgamePieceValues[NUM_OF_PIECE_KINDS] = {120, 280, 300, 520, 900, 0};
+
+  int phaseWeights[NUM_OF_PIECE_KINDS] = {0, 1, 1, 2, 4, 0};
+
+  /* Printed as seen from white, with rank 8 on the first line */
+  Score middlegamePlacementBonuses[NUM_OF_PIECE_KINDS][BOARD_SIZE] = {
+      /* Pawn */
+      {0, 0, 0, 0, 0, 0, 0, 0,
+       50, 50, 50, 50, 50, 50, 50, 50,
+       10, 10, 20, 30, 30, 20, 10, 10,
+       5, 5, 10, 25, 25, 10, 5, 5,
+       0, 0, 0, 20, 20, 0, 0, 0,
+       5, -5, -10, 0, 0, -10, -5, 5,
+       5, 10, 10, -20, -20, 10, 10, 5,
+       0, 0, 0, 0, 0, 0, 0, 0},
+      /* Knight */
+      {-50, -40, -30, -30, -30, -30, -40, -50,
+       -40, -20, 0, 0, 0, 0, -20, -40,
+       -30, 0, 10, 15, 15, 10, 0, -30,
+       -30, 5, 15, 20, 20, 15, 5, -30,
+       -30, 0, 15, 20, 20, 15, 0, -30,
+       -30, 5, 10, 15, 15, 10, 5, -30,
+       -40, -20, 0, 5, 5, 0, -20, -40,
+       -50, -40, -30, -30, -30, -30, -40, -50},
+      /* Bishop */
+      {-20, -10, -10, -10, -10, -10, -10, -20,
+       -10, 0, 0, 0, 0, 0, 0, -10,
+       -10, 0, 5, 10, 10, 5, 0, -10,
+       -10, 5, 5, 10, 10, 5, 5, -10,
+       -10, 0, 10, 10, 10, 10, 0, -10,
+       -10, 10, 10, 10, 10, 10, 10, -10,
+       -10, 5, 0, 0, 0, 0, 5, -10,
+       -20, -10, -10, -10, -10, -10, -10, -20},
+      /* Rook */
+      {0, 0, 0, 0, 0, 0, 0, 0,
+       5, 10, 10, 10, 10, 10, 10, 5,
+       -5, 0, 0, 0, 0, 0, 0, -5,
+       -5, 0, 0, 0, 0, 0, 0, -5,
+       -5, 0, 0, 0, 0, 0, 0, -5,
+       -5, 0, 0, 0, 0, 0, 0, -5,
+       -5, 0, 0, 0, 0, 0, 0, -5,
+       0, 0, 0, 5, 5, 0, 0, 0},
+      /* Queen */
+      {-20, -10, -10, -5, -5, -10, -10, -20,
+       -10, 0, 0, 0, 0, 0, 0, -10,
+       -10, 0, 5, 5, 5, 5, 0, -10,
+       -5, 0, 5, 5, 5, 5, 0, -5,
+       0, 0, 5, 5, 5, 5, 0, -5,
+       -10, 5, 5, 5, 5, 5, 0, -10,
+       -10, 0, 5, 0, 0, 0, 0, -10,
+       -20, -10, -10, -5, -5, -10, -10, -20},
+      /* King */
+      {-30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -20, -30, -30, -40, -40, -30, -30, -20,
+       -10, -20, -20, -20, -20, -20, -20, -10,
+       20, 20, 0, 0, 0, 0, 20, 20,
+       20, 30, 10, 0, 0, 10, 30, 20}};
+
+  /* Pawns gain value as they advance and the king comes to the center once the queens are gone */
+  Score endgamePlacementBonuses[NUM_OF_PIECE_KINDS][BOARD_SIZE] = {
+      /* Pawn */
+      {0, 0, 0, 0, 0, 0, 0, 0,
+       80, 80, 80, 80, 80, 80, 80, 80,
+       50, 50, 50, 50, 50, 50, 50, 50,
+       30, 30, 30, 30, 30, 30, 30, 30,
+       15, 15, 15, 15, 15, 15, 15, 15,
+       5, 5, 5, 5, 5, 5, 5, 5,
+       0, 0, 0, 0, 0, 0, 0, 0,
+       0, 0, 0, 0, 0, 0, 0, 0},
+      /* Knight */
+      {-50, -40, -30, -30, -30, -30, -40, -50,
+       -40, -20, 0, 0, 0, 0, -20, -40,
+       -30, 0, 10, 15, 15, 10, 0, -30,
+       -30, 5, 15, 20, 20, 15, 5, -30,
+       -30, 0, 15, 20, 20, 15, 0, -30,
+       -30, 5, 10, 15, 15, 10, 5, -30,
+       -40, -20, 0, 5, 5, 0, -20, -40,
+       -50, -40, -30, -30, -30, -30, -40, -50},
+      /* Bishop */
+      {-20, -10, -10, -10, -10, -10, -10, -20,
+       -10, 0, 0, 0, 0, 0, 0, -10,
+       -10, 0, 5, 10, 10, 5, 0, -10,
+       -10, 5, 5, 10, 10, 5, 5, -10,
+       -10, 0, 10, 10, 10, 10, 0, -10,
+       -10, 10, 10, 10, 10, 10, 10, -10,
+       -10, 5, 0, 0, 0, 0, 5, -10,
+       -20, -10, -10, -10, -10, -10, -10, -20},
+      /* Rook */
+      {0, 0, 0, 0, 0, 0, 0, 0,
+       10, 10, 10, 10, 10, 10, 10, 10,
+       0, 0, 0, 0, 0, 0, 0, 0,
+       0, 0, 0, 0, 0, 0, 0, 0,
+       0, 0, 0, 0, 0, 0, 0, 0,
+       0, 0, 0, 0, 0, 0, 0, 0,
+       0, 0, 0, 0, 0, 0, 0, 0,
+       0, 0, 0, 0, 0, 0, 0, 0},
+      /* Queen */
+      {-20, -10, -10, -5, -5, -10, -10, -20,
+       -10, 0, 0, 0, 0, 0, 0, -10,
+       -10, 0, 5, 5, 5, 5, 0, -10,
+       -5, 0, 5, 5, 5, 5, 0, -5,
+       -5, 0, 5, 5, 5, 5, 0, -5,
+       -10, 0, 5, 5, 5, 5, 0, -10,
+       -10, 0, 0, 0, 0, 0, 0, -10,
+       -20, -10, -10, -5, -5, -10, -10, -20},
+      /* King */
+      {-50, -40, -30, -20, -20, -30, -40, -50,
+       -30, -20, -10, 0, 0, -10, -20, -30,
+       -30, -10, 20, 30, 30, 20, -10, -30,
+       -30, -10, 30, 40, 40, 30, -10, -30,
+       -30, -10, 30, 40, 40, 30, -10, -30,
+       -30, -10, 20, 30, 30, 20, -10, -30,
+       -30, -30, 0, 0, 0, 0, -30, -30,
+       -50, -30, -30, -30, -30, -30, -30, -50}};
+
+  TaperedScore material[NUM_OF_PIECE_TYPES];
+  TaperedScore placement[NUM_OF_PIECE_TYPES][BOARD_SIZE];
+
+  void init()
+  {
+    for (int kind = 0; kind < NUM_OF_PIECE_KINDS; kind++)
+    {
+      int const white = kind;
+      int const black = kind + NUM_OF_PIECE_KINDS;
+      material[white] = makeTaperedScore(middlegamePieceValues[kind], endgamePieceValues[kind]);
+      material[black] = -material[white];
+      for (int pos = 0; pos < BOARD_SIZE; pos++)
+      {
+        /* The tables are printed with rank 8 first, flipping the rank gives white's view */
+        int const whitePos = pos ^ (BOARD_SIZE - BOARD_LENGTH);
+        placement[white][pos] = makeTaperedScore(middlegamePlacementBonuses[kind][whitePos], endgamePlacementBonuses[kind][whitePos]);
+        placement[black][pos] = -makeTaperedScore(middlegamePlacementBonuses[kind][pos], endgamePlacementBonuses[kind][pos]);
+      }
+    }
+  }
+};
@@ -0,0 +1,316 @@
+#include "../include/playerenginemcts.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+MCTSNodePool::MCTSNodePool(size_t const sizeMB) : capacity(std::max<size_t>(1, sizeMB * 1024 * 1024 / sizeof(MCTSNode))),
+                                                  numOfUsed(0)
+{
+  nodes = std::make_unique<MCTSNode[]>(capacity);
+}
+
+uint32_t MCTSNodePool::allocate(uint32_t const count)
+{
+  uint32_t const first = numOfUsed.fetch_add(count, std::memory_order_relaxed);
+  if (first + static_cast<uint64_t>(count) > capacity)
+  {
+    return capacity;
+  }
+
+  /* Nodes of an earlier search are reused as they are handed out */
+  for (uint32_t index = first; index < first + count; index++)
+  {
+    MCTSNode &node = nodes[index];
+    node.move = Move();
+    node.prior = 0;
+    node.visits.store(0, std::memory_order_relaxed);
+    node.virtualLosses.store(0, std::memory_order_relaxed);
+    node.valueSum.store(0, std::memory_order_relaxed);
+    node.firstChild = 0;
+    node.numOfChildren = 0;
+    node.terminalValue = 0;
+    node.state.store(MCTSNode::UNEXPANDED, std::memory_order_relaxed);
+  }
+  return first;
+}
+
+void MCTSNodePool::reset()
+{
+  numOfUsed = 0;
+}
+
+MCTSNode &MCTSNodePool::operator[](uint32_t const index)
+{
+  return nodes[index];
+}
+
+uint32_t MCTSNodePool::getCapacity() const
+{
+  return capacity;
+}
+
+uint32_t MCTSNodePool::getNumOfUsed() const
+{
+  return std::min(numOfUsed.load(std::memory_order_relaxed), capacity);
+}
+
+PlayerEngineMCTS::PlayerEngineMCTS() : PlayerEngineMCTS(MCTS_DEFAULT_SIMULATIONS) {};
+
+PlayerEngineMCTS::PlayerEngineMCTS(int numSimulations) : PlayerEngineMCTS(numSimulations, std::max(1u, std::thread::hardware_concurrency())) {};
+
+PlayerEngineMCTS::PlayerEngineMCTS(int numSimulations, int numThreads) : numSimulations(std::max(1, numSimulations)),
+                                                                        numThreads(std::max(1, numThreads)),
+                                                                        isQuiescence(true),
+                                                                        evaluator(1, 1),
+                                                                        pawnHashTables(this->numThreads),
+                                                                        materialHashTables(this->numThreads),
+                                                                        stopSearch(false),
+                                                                        simulations(0)
+{
+}
+
+void PlayerEngineMCTS::setNumThreads(int const numThreads)
+{
+  this->numThreads = std::max(1, numThreads);
+  pawnHashTables.resize(this->numThreads);
+  materialHashTables.resize(this->numThreads);
+}
+
+void PlayerEngineMCTS::setQuiescenceLeaves(bool const isQuiescence)
+{
+  this->isQuiescence = isQuiescence;
+}
+
+uint64_t PlayerEngineMCTS::getSimulations() const
+{
+  return simulations.load();
+}
+
+Move PlayerEngineMCTS::getMove(Game game)
+{
+  logIt(LogLevel::INFO) << "Player Engine MCTS is calculating a move with " << numThreads << " thread(s)";
+  std::vector<Move> const moves = game.getAllLegalMoves();
+  if (moves.empty())
+  {
+    logIt(LogLevel::ERROR) << "Engine has no legal moves to make";
+    throw std::runtime_error("Engine has no legal moves to make");
+  }
+
+  /* The network cannot be replaced while the threads evaluate with it */
+  NNUE::UsageLock const networkLock;
+
+  /* The root is expanded before the threads start, so every simulation has a child to go to */
+  pool.reset();
+  MCTSNode &root = pool[pool.allocate(1)];
+  expand(root, game, moves);
+
+  int64_t moveTime = 0;
+  if (timeControl.time[Piece::getColorIndex(game.getTurn())] > 0)
+  {
+    moveTime = TimeManager::allocate(timeControl, game.getTurn()).soft;
+  }
+
+  auto const start = std::chrono::steady_clock::now();
+  stopSearch = false;
+  simulations = 0;
+  std::vector<std::unique_ptr<SearchThread>> threads;
+  for (int i = 0; i < numThreads; i++)
+  {
+    threads.push_back(std::make_unique<SearchThread>());
+    threads[i]->id = i;
+    threads[i]->pawnHashTable = &pawnHashTables[i];
+    threads[i]->materialHashTable = &materialHashTables[i];
+  }
+  std::vector<std::thread> helpers;
+  for (int i = 1; i < numThreads; i++)
+  {
+    helpers.emplace_back([this, &threads, &game, moveTime, i]()
+                         { searchTree(*threads[i], game, moveTime); });
+  }
+  searchTree(*threads[0], game, moveTime);
+  for (auto &helper : helpers)
+  {
+    helper.join();
+  }
+
+  /* The most visited move is the most reliable, its value has been averaged the most */
+  MCTSNode *best = &pool[root.firstChild];
+  for (uint32_t i = 1; i < root.numOfChildren; i++)
+  {
+    MCTSNode &child = pool[root.firstChild + i];
+    if (child.visits > best->visits)
+    {
+      best = &child;
+    }
+  }
+
+  auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  double const value = best->visits > 0 ? static_cast<double>(best->valueSum) / MCTS_VALUE_FIXED_POINT / best->visits : 0;
+  logIt(LogLevel::INFO) << "Player Engine MCTS ran " << simulations << " simulations in " << elapsed << "ms ("
+                        << (simulations * 1000 / std::max<int64_t>(1, elapsed)) << " simulations/s), " << pool.getNumOfUsed() << " of "
+                        << pool.getCapacity() << " nodes used";
+  logIt(LogLevel::INFO) << "Player Engine MCTS made move " << best->move << " with " << best->visits << " visits and value " << value;
+  return best->move;
+}
+
+void PlayerEngineMCTS::searchTree(SearchThread &thread, Game const &root, int64_t const moveTime)
+{
+  auto const start = std::chrono::steady_clock::now();
+  while (!stopSearch.load(std::memory_order_relaxed))
+  {
+    if (!simulate(thread, root))
+    {
+      logIt(LogLevel::DEBUG) << "Player Engine MCTS node pool is full";
+      stopSearch = true;
+    }
+
+    uint64_t const numOfSimulations = ++simulations;
+    bool isLimitReached = stopFlag && stopFlag->load(std::memory_order_relaxed);
+    if (moveTime > 0)
+    {
+      auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+      isLimitReached = isLimitReached || elapsed >= moveTime;
+    }
+    else
+    {
+      isLimitReached = isLimitReached || numOfSimulations >= static_cast<uint64_t>(numSimulations);
+    }
+    if (isLimitReached)
+    {
+      stopSearch = true;
+    }
+  }
+}
+
+bool PlayerEngineMCTS::simulate(SearchThread &thread, Game const &root)
+{
+  /* Selection, the virtual losses keep the other threads off the path until it is backed up */
+  Game game(root);
+  std::vector<MCTSNode *> path = {&pool[0]};
+  MCTSNode *node = path.back();
+  while (node->state.load(std::memory_order_acquire) == MCTSNode::EXPANDED && node->numOfChildren > 0)
+  {
+    node = &selectChild(*node);
+    node->virtualLosses.fetch_add(1, std::memory_order_relaxed);
+    game.makeMove(node->move);
+    path.push_back(node);
+  }
+
+  /* Expansion by the thread that claims the leaf, a node that is already expanded here has no children */
+  double value;
+  bool isPoolFull = false;
+  uint8_t state = MCTSNode::UNEXPANDED;
+  if (node->state.compare_exchange_strong(state, MCTSNode::EXPANDING, std::memory_order_acquire))
+  {
+    std::vector<Move> const moves = game.isGameOver() ? std::vector<Move>() : game.getAllLegalMoves();
+    if (moves.empty())
+    {
+      /* Checkmate or a draw, by stalemate or by the rules */
+      bool const isMated = game.isGameOver() ? game.getResult() != Result::DRAW : game.isKingInCheck(game.getTurn());
+      node->terminalValue = isMated ? -1 : 0;
+      node->state.store(MCTSNode::EXPANDED, std::memory_order_release);
+      value = node->terminalValue;
+    }
+    else
+    {
+      isPoolFull = !expand(*node, game, moves);
+      value = evaluateLeaf(thread, game);
+    }
+  }
+  else if (state == MCTSNode::EXPANDED)
+  {
+    value = node->terminalValue;
+  }
+  else
+  {
+    value = evaluateLeaf(thread, game);
+  }
+
+  /* Backup, a node holds the value for the player who moved into it, so the sign alternates going up */
+  double nodeValue = -value;
+  for (size_t i = path.size(); i-- > 0;)
+  {
+    path[i]->valueSum.fetch_add(std::llround(nodeValue * MCTS_VALUE_FIXED_POINT), std::memory_order_relaxed);
+    path[i]->visits.fetch_add(1, std::memory_order_relaxed);
+    if (i > 0)
+    {
+      path[i]->virtualLosses.fetch_sub(1, std::memory_order_relaxed);
+    }
+    nodeValue = -nodeValue;
+  }
+  return !isPoolFull;
+}
+
+MCTSNode &PlayerEngineMCTS::selectChild(MCTSNode &node)
+{
+  double const parentVisits = node.visits.load(std::memory_order_relaxed) + node.virtualLosses.load(std::memory_order_relaxed);
+  double const exploration = MCTS_EXPLORATION * std::sqrt(std::max(1.0, parentVisits));
+
+  MCTSNode *best = &pool[node.firstChild];
+  double bestScore = -std::numeric_limits<double>::infinity();
+  for (uint32_t i = 0; i < node.numOfChildren; i++)
+  {
+    MCTSNode &child = pool[node.firstChild + i];
+    uint32_t const virtualLosses = child.virtualLosses.load(std::memory_order_relaxed);
+    double const visits = child.visits.load(std::memory_order_relaxed) + virtualLosses;
+
+    /* Unvisited children are valued as a draw, virtual losses count as lost simulations */
+    double const valueSum = static_cast<double>(child.valueSum.load(std::memory_order_relaxed)) / MCTS_VALUE_FIXED_POINT - virtualLosses;
+    double const score = (visits > 0 ? valueSum / visits : 0) + exploration * child.prior / (1 + visits);
+    if (score > bestScore)
+    {
+      bestScore = score;
+      best = &child;
+    }
+  }
+  return *best;
+}
+
+bool PlayerEngineMCTS::expand(MCTSNode &node, Game &game, std::vector<Move> const &moves)
+{
+  uint32_t const first = pool.allocate(moves.size());
+  if (first == pool.getCapacity())
+  {
+    node.state.store(MCTSNode::UNEXPANDED, std::memory_order_release);
+    return false;
+  }
+
+  /* Priors are a softmax over the static exchange evaluation, quiet moves have a logit of 0 */
+  std::vector<double> weights(moves.size());
+  double sum = 0;
+  for (size_t i = 0; i < moves.size(); i++)
+  {
+    double logit = 0;
+    if (game.isCapture(moves[i]) || moves[i].promotionPiece != Piece::Type::BLANK)
+    {
+      logit = game.staticExchangeEvaluation(moves[i]) / MCTS_PRIOR_SCALE;
+    }
+    weights[i] = std::exp(std::clamp(logit, -5.0, 5.0));
+    sum += weights[i];
+  }
+  for (size_t i = 0; i < moves.size(); i++)
+  {
+    MCTSNode &child = pool[first + i];
+    child.move = moves[i];
+    child.prior = static_cast<float>(weights[i] / sum);
+  }
+
+  /* The children are complete before other threads can see them */
+  node.firstChild = first;
+  node.numOfChildren = moves.size();
+  node.state.store(MCTSNode::EXPANDED, std::memory_order_release);
+  return true;
+}
+
+double PlayerEngineMCTS::evaluateLeaf(SearchThread &thread, Game &game)
+{
+  Score const score = evaluator.scoreLeaf(thread, game, isQuiescence);
+  if (isMateScore(score))
+  {
+    return score > 0 ? 1 : -1;
+  }
+  return std::tanh(score / MCTS_VALUE_SCALE);
+}
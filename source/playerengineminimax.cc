@@ -1,8 +1,115 @@
 #include "../include/playerengineminimax.h"
 
-PlayerEngineMiniMax::PlayerEngineMiniMax() : maxDepth(DEFAULT_MAX_DEPTH) {};
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <thread>
 
-PlayerEngineMiniMax::PlayerEngineMiniMax(int maxDepth) : maxDepth(maxDepth) {};
+PlayerEngineMiniMax::PlayerEngineMiniMax() : PlayerEngineMiniMax(DEFAULT_MAX_DEPTH) {};
+
+PlayerEngineMiniMax::PlayerEngineMiniMax(int maxDepth) : PlayerEngineMiniMax(maxDepth, std::max(1u, std::thread::hardware_concurrency())) {};
+
+PlayerEngineMiniMax::PlayerEngineMiniMax(int maxDepth, int numThreads) : maxDepth(maxDepth),
+                                                                        numThreads(std::max(1, numThreads)),
+                                                                        transpositionTable(DEFAULT_HASH_SIZE_MB),
+                                                                        evalCache(DEFAULT_EVAL_CACHE_SIZE_MB),
+                                                                        stopSearch(false),
+                                                                        pawnHashTables(this->numThreads),
+                                                                        materialHashTables(this->numThreads),
+                                                                        isPondering(false),
+                                                                        stopPonder(false)
+{
+  /* The network is shared by all engines, so it is only looked for once */
+  if (!NNUE::isLoaded())
+  {
+    loadNetwork(DEFAULT_NNUE_FILE);
+  }
+  /* The parameter file is loaded once by main, before any game exists */
+  evaluationWeights = EvalParameters::getStartupWeights();
+
+  /* The bitbases and tablebases are shared by all engines as well */
+  if (!Bitbases::isLoaded())
+  {
+    Bitbases::load(DEFAULT_BITBASE_DIRECTORY);
+  }
+  if (!Tablebases::isLoaded())
+  {
+    Tablebases::load(DEFAULT_BITBASE_DIRECTORY);
+  }
+
+  book.open(DEFAULT_BOOK_FILE);
+};
+
+PlayerEngineMiniMax::~PlayerEngineMiniMax()
+{
+  /* The ponder search uses the tables of the engine */
+  stopPondering();
+}
+
+void PlayerEngineMiniMax::setNumThreads(int const numThreads)
+{
+  this->numThreads = std::max(1, numThreads);
+  pawnHashTables.resize(this->numThreads);
+  materialHashTables.resize(this->numThreads);
+}
+
+void PlayerEngineMiniMax::setHashSize(size_t const sizeMB)
+{
+  transpositionTable.resize(sizeMB);
+}
+
+void PlayerEngineMiniMax::setEvalCacheSize(size_t const sizeMB)
+{
+  evalCache.resize(sizeMB);
+}
+
+bool PlayerEngineMiniMax::loadBook(std::string const &path)
+{
+  return book.open(path);
+}
+
+void PlayerEngineMiniMax::setBookSelection(BookSelection const selection)
+{
+  bookSelection = selection;
+}
+
+bool PlayerEngineMiniMax::probeBook(Game game, Move &move)
+{
+  return book.probe(game, bookSelection, move);
+}
+
+EvaluationWeights &PlayerEngineMiniMax::getEvaluationWeights()
+{
+  return evaluationWeights;
+}
+
+bool PlayerEngineMiniMax::loadNetwork(std::string const &path)
+{
+  if (!NNUE::load(path))
+  {
+    logIt(LogLevel::INFO) << "Player Engine MiniMax uses the " << (NNUE::isLoaded() ? "network" : "hand-crafted") << " evaluation";
+    return false;
+  }
+  /* The cached evaluations are from the previous evaluator */
+  evalCache.clear();
+  return true;
+}
+
+void PlayerEngineMiniMax::setPruningMargins(PruningMargins const &margins)
+{
+  pruningMargins = margins;
+}
+
+uint64_t PlayerEngineMiniMax::getNodes()
+{
+  return statistics.nodes;
+}
+
+SearchStatistics PlayerEngineMiniMax::getStatistics()
+{
+  return statistics;
+}
 
 std::vector<Move> PlayerEngineMiniMax::getAllLegalMoves(Game game)
 {
@@ -27,236 +134,1092 @@ std::vector<Move> PlayerEngineMiniMax::getAllLegalMoves(Game game)
 
 Move PlayerEngineMiniMax::getMove(Game game)
 {
-  logIt(LogLevel::INFO) << "Player Engine MiniMax is calculating a move";
-  logIt(LogLevel::INFO) << "Current score: " << evaluateGame(game) << " turn: " << game.getTurn();
-  std::pair<Move, int> bestMove = miniMax(game, 0, INT_MIN, INT_MAX, game.getTurn() == Piece::Color::WHITE);
-  if (bestMove.first.from == -1)
+  Move bookMove;
+  if (book.probe(game, bookSelection, bookMove))
+  {
+    stopPondering();
+    hasPonderMove = false;
+    logIt(LogLevel::INFO) << "Player Engine MiniMax played book move " << bookMove;
+    return bookMove;
+  }
+
+  /* The ponder search has to be resolved first, it uses the tables of the main thread */
+  std::vector<SearchLine> lines;
+  if (ponderResult.valid())
+  {
+    if (game.getZobristKey() == ponderKey)
+    {
+      logIt(LogLevel::INFO) << "Player Engine MiniMax ponder hit on " << ponderMove;
+
+      /* The search does not read its time limits while pondering, so they can be set to the clock of now */
+      SearchLimits hitLimits;
+      applyTimeControl(game.getTurn(), hitLimits);
+      limits.moveTime = hitLimits.moveTime;
+      limits.softTime = hitLimits.softTime;
+      isPondering = false;
+      while (ponderResult.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready)
+      {
+        if (stopFlag && stopFlag->load(std::memory_order_relaxed))
+        {
+          stopPonder = true;
+        }
+      }
+      lines = ponderResult.get();
+    }
+    else
+    {
+      logIt(LogLevel::INFO) << "Player Engine MiniMax ponder miss, expected " << ponderMove;
+      stopPondering();
+    }
+  }
+
+  if (lines.empty())
+  {
+    logIt(LogLevel::INFO) << "Player Engine MiniMax is calculating a move with " << numThreads << " thread(s)";
+    logIt(LogLevel::DEBUG) << "Evaluation breakdown:\n"
+                           << getEvaluationBreakdown(game);
+
+    SearchLimits limits;
+    limits.stop = stopFlag;
+    applyTimeControl(game.getTurn(), limits);
+    lines = search(game, 1, limits);
+  }
+  if (lines.empty() || lines[0].pv.empty())
   {
     logIt(LogLevel::ERROR) << "Engine has no legal moves to make";
     throw std::runtime_error("Engine has no legal moves to make");
   }
-  logIt(LogLevel::INFO) << "Player Engine MiniMax made move " << bestMove.first << " with eval score " << bestMove.second;
+  logIt(LogLevel::INFO) << "Player Engine MiniMax made move " << lines[0].pv[0] << " with eval score " << scoreToString(lines[0].score);
 
-  return bestMove.first;
+  hasPonderMove = lines[0].pv.size() > 1;
+  if (hasPonderMove)
+  {
+    ponderMove = lines[0].pv[1];
+  }
+  return lines[0].pv[0];
 }
 
-int PlayerEngineMiniMax::evaluatePieceValue(Game game)
+void PlayerEngineMiniMax::startPondering(Game game)
 {
-  int score = 0;
-  for (int i = 0; i < BOARD_SIZE; i++)
+  stopPondering();
+  if (!hasPonderMove)
+  {
+    return;
+  }
+  std::vector<Move> const legalMoves = game.getAllLegalMoves();
+  if (std::find(legalMoves.begin(), legalMoves.end(), ponderMove) == legalMoves.end())
   {
-    Piece::Type piece = game.getPieceAtPos(i);
-    if (piece == Piece::Type::BLANK)
+    return;
+  }
+
+  game.makeMove(ponderMove);
+  ponderKey = game.getZobristKey();
+  isPondering = true;
+  stopPonder = false;
+  logIt(LogLevel::INFO) << "Player Engine MiniMax is pondering on " << ponderMove;
+  ponderResult = std::async(std::launch::async, [this, game]() mutable
+                            {
+    SearchLimits limits;
+    limits.stop = &stopPonder;
+    limits.ponder = &isPondering;
+    applyTimeControl(game.getTurn(), limits);
+    return search(game, 1, limits); });
+}
+
+void PlayerEngineMiniMax::applyTimeControl(Piece::Color const color, SearchLimits &limits)
+{
+  if (timeControl.time[Piece::getColorIndex(color)] <= 0)
+  {
+    return;
+  }
+  TimeBudget const budget = TimeManager::allocate(timeControl, color);
+  limits.moveTime = budget.hard;
+  limits.softTime = budget.soft;
+  limits.depth = MAX_PLY - 1;
+  logIt(LogLevel::INFO) << "Player Engine MiniMax has " << timeControl.time[Piece::getColorIndex(color)] << "ms left, soft limit "
+                        << budget.soft << "ms, hard limit " << budget.hard << "ms";
+}
+
+void PlayerEngineMiniMax::stopPondering()
+{
+  if (!ponderResult.valid())
+  {
+    return;
+  }
+  stopPonder = true;
+  ponderResult.wait();
+  ponderResult.get();
+  isPondering = false;
+}
+
+std::vector<SearchLine> PlayerEngineMiniMax::analyse(Game game, int const numLines)
+{
+  logIt(LogLevel::INFO) << "Player Engine MiniMax is analysing the " << numLines << " best lines with " << numThreads << " thread(s)";
+
+  std::vector<SearchLine> lines = search(game, std::max(1, numLines));
+  for (size_t i = 0; i < lines.size(); i++)
+  {
+    std::ostringstream pv;
+    for (auto const &move : lines[i].pv)
     {
-      continue;
+      pv << " " << move;
+    }
+    logIt(LogLevel::INFO) << "Line " << i + 1 << " depth " << lines[i].depth << " score " << scoreToString(lines[i].score) << " pv" << pv.str();
+  }
+
+  return lines;
+}
+
+SearchLine PlayerEngineMiniMax::searchWithLimits(Game game, SearchLimits const &limits)
+{
+  std::vector<SearchLine> lines = search(game, 1, limits);
+  if (lines.empty() || lines[0].pv.empty())
+  {
+    logIt(LogLevel::ERROR) << "Engine has no legal moves to make";
+    throw std::runtime_error("Engine has no legal moves to make");
+  }
+  return lines[0];
+}
+
+void PlayerEngineMiniMax::setInfoCallback(SearchInfoCallback const &callback)
+{
+  infoCallback = callback;
+}
+
+void PlayerEngineMiniMax::clearHashTables()
+{
+  transpositionTable.clear();
+  evalCache.clear();
+  for (auto &pawnHashTable : pawnHashTables)
+  {
+    pawnHashTable.clear();
+  }
+  for (auto &materialHashTable : materialHashTables)
+  {
+    materialHashTable.clear();
+  }
+}
+
+int PlayerEngineMiniMax::getHashFull()
+{
+  return transpositionTable.getHashFull();
+}
+
+std::vector<SearchLine> PlayerEngineMiniMax::search(Game &game, int const numLines, SearchLimits const &limits)
+{
+  auto const start = std::chrono::steady_clock::now();
+
+  /* The network cannot be replaced while the threads evaluate with it */
+  NNUE::UsageLock const networkLock;
+  /* The root may be older than the piece-square tables, its sums are carried to every node */
+  game.refreshTableScores();
+  std::vector<SearchThread> threads(numThreads);
+  this->limits = limits;
+  searchStart = start;
+  limitStart = start;
+  searchThreads = &threads;
+  for (int i = 0; i < numThreads; i++)
+  {
+    threads[i].id = i;
+    threads[i].pawnHashTable = &pawnHashTables[i];
+    threads[i].materialHashTable = &materialHashTables[i];
+  }
+  threads[0].numLines = numLines;
+  tablebaseRootMoves = probeRootTablebases(game);
+
+  /* Helper threads search the same root and only share their results through the transposition table */
+  stopSearch = false;
+  std::vector<std::thread> helpers;
+  for (int i = 1; i < numThreads; i++)
+  {
+    helpers.emplace_back([this, &threads, i, game]() mutable
+                         { iterativeDeepening(threads[i], game); });
+  }
+
+  /* The main thread decides the move, the helpers are stopped when it is done */
+  iterativeDeepening(threads[0], game);
+  stopSearch = true;
+  for (auto &helper : helpers)
+  {
+    helper.join();
+  }
+  searchThreads = nullptr;
+
+  statistics = SearchStatistics();
+  for (auto const &thread : threads)
+  {
+    statistics += thread.statistics;
+  }
+  auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  logIt(LogLevel::INFO) << "Player Engine MiniMax searched " << statistics.nodes << " nodes in " << elapsed << "ms ("
+                        << (statistics.nodes * 1000 / std::max<int64_t>(1, elapsed)) << " nodes/s), hash full " << transpositionTable.getHashFull() << " permille";
+  logIt(LogLevel::INFO) << "Pruned nodes: reverse futility " << statistics.reverseFutilityPrunes << ", futility " << statistics.futilityPrunes
+                        << ", razoring " << statistics.razoringPrunes;
+  logIt(LogLevel::INFO) << "Pawn hash hits " << statistics.pawnHashHits << " of " << statistics.pawnHashProbes << " probes ("
+                        << (statistics.pawnHashHits * 100 / std::max<uint64_t>(1, statistics.pawnHashProbes)) << "%)";
+  logIt(LogLevel::INFO) << "Eval cache hits " << statistics.evalCacheHits << " of " << statistics.evalCacheProbes << " probes ("
+                        << (statistics.evalCacheHits * 100 / std::max<uint64_t>(1, statistics.evalCacheProbes)) << "%)";
+  logIt(LogLevel::INFO) << "Lazy evaluation exits " << statistics.lazyEvalExits << " of " << statistics.lazyEvalProbes << " evaluations ("
+                        << (statistics.lazyEvalExits * 100 / std::max<uint64_t>(1, statistics.lazyEvalProbes)) << "%)";
+  logIt(LogLevel::INFO) << "Tablebase hits " << statistics.tablebaseHits;
+
+  return threads[0].lines;
+}
+
+template <typename Trace>
+TaperedScore PlayerEngineMiniMax::evaluatePieceValue(Game &game, Trace &trace)
+{
+  if constexpr (Trace::isEnabled)
+  {
+    /* The kings are left out, their value is the same for both sides */
+    for (int pos = 0; pos < BOARD_SIZE; pos++)
+    {
+      Piece::Type const piece = game.getPieceAtPos(pos);
+      int const kind = Piece::getPieceIndex(piece) % NUM_OF_PIECE_KINDS;
+      if (piece != Piece::Type::BLANK && Piece::getPieceTypeWithoutColor(piece) != Piece::Type::KING)
+      {
+        trace.add(TERM_MATERIAL, Piece::getColorOfPiece(piece), PieceSquareTable::middlegamePieceValues[kind],
+                  PieceSquareTable::endgamePieceValues[kind], 1);
+      }
     }
+  }
+  return game.getMaterialScore();
+}
+
+template <typename Trace>
+TaperedScore PlayerEngineMiniMax::evaluatePieceMobility(Game &game, Trace &trace)
+{
+  TaperedScore score = 0;
+  Bitboard const occupied = game.getOccupiedBitboard();
+  Piece::Color const colors[2] = {Piece::Color::WHITE, Piece::Color::BLACK};
+  for (int i = 0; i < 2; i++)
+  {
+    Piece::Color const color = colors[i];
+    Piece::Color const enemy = Piece::getOppositeColor(color);
+    int const sign = i == 0 ? 1 : -1;
 
-    switch (piece)
+    /* Positions attacked by enemy pawns are not worth going to for any piece */
+    Bitboard const enemyPawns = game.getPieceBitboard(static_cast<Piece::Type>(enemy | Piece::Type::PAWN));
+    Bitboard const area = ~game.getColorBitboard(color) & ~Bitboards::pawnAttacksOfBitboard(enemy, enemyPawns);
+
+    Bitboard knights = game.getPieceBitboard(static_cast<Piece::Type>(color | Piece::Type::KNIGHT));
+    while (knights)
     {
-    case Piece::Type::WHITE_PAWN:
-      score += 10;
-      break;
-    case Piece::Type::WHITE_KNIGHT:
-      score += 30;
-      break;
-    case Piece::Type::WHITE_BISHOP:
-      score += 30;
-      break;
-    case Piece::Type::WHITE_ROOK:
-      score += 50;
-      break;
-    case Piece::Type::WHITE_QUEEN:
-      score += 90;
-      break;
-    case Piece::Type::BLACK_PAWN:
-      score -= 10;
-      break;
-    case Piece::Type::BLACK_KNIGHT:
-      score -= 30;
-      break;
-    case Piece::Type::BLACK_BISHOP:
-      score -= 30;
-      break;
-    case Piece::Type::BLACK_ROOK:
-      score -= 50;
-      break;
-    case Piece::Type::BLACK_QUEEN:
-      score -= 90;
-      break;
-    default:
-      break;
+      int const pos = Bitboards::popLsb(knights);
+      TaperedScore const &weight = evaluationWeights.knightMobility[Bitboards::popCount(Bitboards::knightAttacks(pos) & area)];
+      score += sign * weight;
+      trace.add(TERM_MOBILITY, color, weight, 1);
+    }
+
+    Bitboard bishops = game.getPieceBitboard(static_cast<Piece::Type>(color | Piece::Type::BISHOP));
+    while (bishops)
+    {
+      int const pos = Bitboards::popLsb(bishops);
+      TaperedScore const &weight = evaluationWeights.bishopMobility[Bitboards::popCount(Bitboards::bishopAttacks(pos, occupied) & area)];
+      score += sign * weight;
+      trace.add(TERM_MOBILITY, color, weight, 1);
+    }
+
+    Bitboard rooks = game.getPieceBitboard(static_cast<Piece::Type>(color | Piece::Type::ROOK));
+    while (rooks)
+    {
+      int const pos = Bitboards::popLsb(rooks);
+      TaperedScore const &weight = evaluationWeights.rookMobility[Bitboards::popCount(Bitboards::rookAttacks(pos, occupied) & area)];
+      score += sign * weight;
+      trace.add(TERM_MOBILITY, color, weight, 1);
+    }
+
+    Bitboard queens = game.getPieceBitboard(static_cast<Piece::Type>(color | Piece::Type::QUEEN));
+    while (queens)
+    {
+      int const pos = Bitboards::popLsb(queens);
+      TaperedScore const &weight = evaluationWeights.queenMobility[Bitboards::popCount(Bitboards::queenAttacks(pos, occupied) & area)];
+      score += sign * weight;
+      trace.add(TERM_MOBILITY, color, weight, 1);
     }
   }
 
   return score;
 }
 
-int PlayerEngineMiniMax::evaluatePieceMobility(Game game)
+template <typename Trace>
+TaperedScore PlayerEngineMiniMax::evaluatePiecePlacement(Game &game, Trace &trace)
 {
-  int score = 0;
-  for (int i = 0; i < BOARD_SIZE; i++)
+  if constexpr (Trace::isEnabled)
   {
-    Piece::Type piece = game.getPieceAtPos(i);
-    if (piece == Piece::Type::BLANK)
+    for (int pos = 0; pos < BOARD_SIZE; pos++)
     {
-      continue;
+      Piece::Type const piece = game.getPieceAtPos(pos);
+      if (piece == Piece::Type::BLANK)
+      {
+        continue;
+      }
+      /* The tables are printed with rank 8 first, white reads them with the rank flipped */
+      Piece::Color const color = Piece::getColorOfPiece(piece);
+      int const kind = Piece::getPieceIndex(piece) % NUM_OF_PIECE_KINDS;
+      int const index = color == Piece::Color::WHITE ? pos ^ (BOARD_SIZE - BOARD_LENGTH) : pos;
+      trace.add(TERM_PLACEMENT, color, PieceSquareTable::middlegamePlacementBonuses[kind][index],
+                PieceSquareTable::endgamePlacementBonuses[kind][index], 1);
     }
+  }
+  return game.getPlacementScore();
+}
 
-    std::vector<Move> legalMoves = game.getLegalMovesForPos(i);
-    if (legalMoves.size() == 0)
+template <typename Trace>
+TaperedScore PlayerEngineMiniMax::evaluatePawnStructure(SearchThread &thread, Game &game, Trace &trace)
+{
+  /* A traced evaluation has to see every term, so it does not use the pawn hash table */
+  PawnEntry tracedEntry;
+  PawnEntry *entry = &tracedEntry;
+  if constexpr (Trace::isEnabled)
+  {
+    evaluatePawnEntry(game, tracedEntry, trace);
+  }
+  else
+  {
+    thread.statistics.pawnHashProbes++;
+    entry = &thread.pawnHashTable->getEntry(game.getPawnKey());
+    if (entry->isValid && entry->key == game.getPawnKey())
     {
-      if (Piece::getColorOfPiece(piece) == Piece::Color::WHITE)
-      {
-        score += legalMoves.size();
-      }
-      else
+      thread.statistics.pawnHashHits++;
+    }
+    else
+    {
+      evaluatePawnEntry(game, *entry, trace);
+    }
+  }
+
+  TaperedScore score = entry->score;
+  Piece::Color const colors[2] = {Piece::Color::WHITE, Piece::Color::BLACK};
+  Piece::Type const kings[2] = {Piece::Type::WHITE_KING, Piece::Type::BLACK_KING};
+  Piece::Type const rooks[2] = {Piece::Type::WHITE_ROOK, Piece::Type::BLACK_ROOK};
+  for (int i = 0; i < 2; i++)
+  {
+    int const sign = i == 0 ? 1 : -1;
+
+    /* The shield only changes when the king moves, so it is cached with the king position */
+    Bitboard const king = game.getPieceBitboard(kings[i]);
+    int const kingPos = king ? Bitboards::lsb(king) : -1;
+    if (entry->kingPos[i] != kingPos)
+    {
+      entry->kingShield[i] = kingPos >= 0 ? evaluateKingShield(game, *entry, colors[i], kingPos, trace) : 0;
+      entry->kingPos[i] = kingPos;
+    }
+    score += sign * entry->kingShield[i];
+
+    Bitboard rookBitboard = game.getPieceBitboard(rooks[i]);
+    while (rookBitboard)
+    {
+      int const column = Bitboards::popLsb(rookBitboard) % BOARD_LENGTH;
+      if (!(entry->semiOpenColumns[i] & (1 << column)))
       {
-        score += legalMoves.size();
+        continue;
       }
+      bool const isOpen = entry->semiOpenColumns[1 - i] & (1 << column);
+      TaperedScore const &weight = isOpen ? evaluationWeights.rookOpenFile : evaluationWeights.rookSemiOpenFile;
+      score += sign * weight;
+      trace.add(TERM_ROOKS, colors[i], weight, 1);
     }
   }
 
   return score;
 }
 
-int PlayerEngineMiniMax::evaluatePiecePlacement(Game game)
+template <typename Trace>
+void PlayerEngineMiniMax::evaluatePawnEntry(Game &game, PawnEntry &entry, Trace &trace)
 {
-  // TODO
-  return 0;
-  int score = 0;
+  entry.key = game.getPawnKey();
+  entry.isValid = true;
+  entry.score = 0;
 
-  for (int i = 0; i < BOARD_SIZE; i++)
+  Piece::Color const colors[2] = {Piece::Color::WHITE, Piece::Color::BLACK};
+  Bitboard const pawns[2] = {game.getPieceBitboard(Piece::Type::WHITE_PAWN), game.getPieceBitboard(Piece::Type::BLACK_PAWN)};
+  for (int i = 0; i < 2; i++)
   {
-    Piece::Type piece = game.getPieceAtPos(i);
-
-    if (piece == Piece::Type::BLANK)
+    entry.pawnAttacks[i] = Bitboards::pawnAttacksOfBitboard(colors[i], pawns[i]);
+    entry.semiOpenColumns[i] = 0;
+    for (int column = 0; column < BOARD_LENGTH; column++)
     {
-      continue;
+      if (!(pawns[i] & Bitboards::fileBitboard(column)))
+      {
+        entry.semiOpenColumns[i] |= 1 << column;
+      }
     }
+    /* Force the shields to be evaluated for the new structure */
+    entry.kingPos[i] = -1;
+  }
 
-    switch (piece)
+  for (int i = 0; i < 2; i++)
+  {
+    Piece::Color const color = colors[i];
+    Bitboard const ownPawns = pawns[i];
+    Bitboard const enemyPawns = pawns[1 - i];
+    int const sign = i == 0 ? 1 : -1;
+
+    TaperedScore score = 0;
+    Bitboard remaining = ownPawns;
+    while (remaining)
     {
-    case Piece::Type::WHITE_PAWN:
-      break;
-    case Piece::Type::BLACK_PAWN:
+      int const pos = Bitboards::popLsb(remaining);
+      Bitboard const pawn = Bitboards::positionToBitboard(pos);
+      Bitboard const front = Bitboards::frontSpan(color, pawn);
+      Bitboard const behindOrLevel = pawn | Bitboards::frontSpan(Piece::getOppositeColor(color), pawn);
+      Bitboard const stop = color == Piece::Color::WHITE ? pawn << BOARD_LENGTH : pawn >> BOARD_LENGTH;
 
-      break;
+      /* Only the pawns behind another pawn on the same file count as doubled */
+      if (front & ownPawns)
+      {
+        score += evaluationWeights.doubledPawn;
+        trace.add(TERM_PAWNS, color, evaluationWeights.doubledPawn, 1);
+      }
+      else if (!((front | Bitboards::adjacentColumns(front)) & enemyPawns))
+      {
+        int const rank = color == Piece::Color::WHITE ? pos / BOARD_LENGTH : BOARD_LENGTH - 1 - pos / BOARD_LENGTH;
+        score += evaluationWeights.passedPawn[rank];
+        trace.add(TERM_PAWNS, color, evaluationWeights.passedPawn[rank], 1);
+      }
 
-    default:
-      break;
+      if (!(Bitboards::adjacentColumns(Bitboards::fileBitboard(pos % BOARD_LENGTH)) & ownPawns))
+      {
+        score += evaluationWeights.isolatedPawn;
+        trace.add(TERM_PAWNS, color, evaluationWeights.isolatedPawn, 1);
+      }
+      /* Backward: no pawn on the adjacent files can defend it and it cannot advance safely */
+      else if (!(Bitboards::adjacentColumns(behindOrLevel) & ownPawns) &&
+               (stop & entry.pawnAttacks[1 - i]))
+      {
+        score += evaluationWeights.backwardPawn;
+        trace.add(TERM_PAWNS, color, evaluationWeights.backwardPawn, 1);
+      }
+    }
+    entry.score += sign * score;
+  }
+}
+
+template <typename Trace>
+TaperedScore PlayerEngineMiniMax::evaluateKingShield(Game &game, PawnEntry const &entry, Piece::Color const color, int const kingPos, Trace &trace)
+{
+  Bitboard const ownPawns = game.getPieceBitboard(color == Piece::Color::WHITE ? Piece::Type::WHITE_PAWN : Piece::Type::BLACK_PAWN);
+  Bitboard const king = Bitboards::positionToBitboard(kingPos);
+  Bitboard const kingColumns = king | Bitboards::adjacentColumns(king);
+  Bitboard const oneAhead = color == Piece::Color::WHITE ? kingColumns << BOARD_LENGTH : kingColumns >> BOARD_LENGTH;
+  Bitboard const twoAhead = color == Piece::Color::WHITE ? oneAhead << BOARD_LENGTH : oneAhead >> BOARD_LENGTH;
+  int const numOfShieldPawns = Bitboards::popCount(ownPawns & oneAhead);
+  int const numOfAdvancedShieldPawns = Bitboards::popCount(ownPawns & twoAhead);
+
+  TaperedScore score = 0;
+  score += evaluationWeights.shieldPawn * numOfShieldPawns;
+  score += evaluationWeights.shieldPawnAdvanced * numOfAdvancedShieldPawns;
+  trace.add(TERM_KING_SHIELD, color, evaluationWeights.shieldPawn, numOfShieldPawns);
+  trace.add(TERM_KING_SHIELD, color, evaluationWeights.shieldPawnAdvanced, numOfAdvancedShieldPawns);
+
+  int const colorIndex = Piece::getColorIndex(color);
+  int const kingColumn = kingPos % BOARD_LENGTH;
+  for (int column = std::max(0, kingColumn - 1); column <= std::min(BOARD_LENGTH - 1, kingColumn + 1); column++)
+  {
+    if (entry.semiOpenColumns[colorIndex] & (1 << column))
+    {
+      score += evaluationWeights.kingSemiOpenFile;
+      trace.add(TERM_KING_SHIELD, color, evaluationWeights.kingSemiOpenFile, 1);
     }
   }
 
   return score;
 }
 
-int PlayerEngineMiniMax::evaluatePawnStructure(Game game)
+template <typename Trace>
+Score PlayerEngineMiniMax::evaluateHandCrafted(SearchThread &thread, Game &game, Trace &trace)
+{
+  TaperedScore score = 0;
+
+  score += evaluatePieceValue(game, trace);
+  score += evaluatePieceMobility(game, trace);
+  score += evaluatePiecePlacement(game, trace);
+  score += evaluatePawnStructure(thread, game, trace);
+
+  /* The middlegame and endgame sums are only split up once, at the end */
+  return taperScore(score, game.getPhase());
+}
+
+Score PlayerEngineMiniMax::evaluateGame(SearchThread &thread, Game &game, Score const alpha, Score const beta)
 {
-  int score = 0;
+  thread.statistics.evalCacheProbes++;
+  Score cachedScore;
+  if (evalCache.probe(game.getZobristKey(), cachedScore))
+  {
+    thread.statistics.evalCacheHits++;
+    return cachedScore;
+  }
 
-  /* Check double pawns */
-  for (int i = 0; i < BOARD_LENGTH; i++)
+  MaterialEntry const &material = thread.materialHashTable->probe(game);
+  if (material.evaluation)
   {
-    int whitePawns = 0;
-    int blackPawns = 0;
-    for (int j = i; j < BOARD_SIZE; j += BOARD_LENGTH)
+    Score const endgameScore = material.evaluation(game, material.strongSide);
+    Score const eval = material.strongSide == Piece::Color::WHITE ? endgameScore : -endgameScore;
+    evalCache.store(game.getZobristKey(), eval);
+    return eval;
+  }
+
+  Score eval;
+  if (NNUE::isLoaded())
+  {
+    Score const networkScore = NNUE::evaluate(game.getAccumulator(), game.getTurn());
+    eval = game.getTurn() == Piece::Color::WHITE ? networkScore : -networkScore;
+  }
+  else
+  {
+    /* A scaled evaluation can end up anywhere between 0 and the full score */
+    if (!material.scaling[0] && !material.scaling[1] && (alpha > -SCORE_INFINITE || beta < SCORE_INFINITE))
     {
-      if (game.getPieceAtPos(Position(j)) == Piece::Type::WHITE_PAWN)
+      thread.statistics.lazyEvalProbes++;
+      Score const lazyEval = taperScore(game.getMaterialScore() + game.getPlacementScore(), game.getPhase());
+      if (lazyEval - LAZY_EVAL_MARGIN >= beta || lazyEval + LAZY_EVAL_MARGIN <= alpha)
       {
-        whitePawns++;
+        thread.statistics.lazyEvalExits++;
+        return lazyEval;
       }
-      if (game.getPieceAtPos(Position(j)) == Piece::Type::BLACK_PAWN)
+    }
+    NoTrace trace;
+    eval = evaluateHandCrafted(thread, game, trace);
+  }
+
+  /* Only the side that is ahead can be stopped from making progress */
+  Piece::Color const strongSide = eval > 0 ? Piece::Color::WHITE : Piece::Color::BLACK;
+  Endgames::ScalingFunction const scaling = material.scaling[Piece::getColorIndex(strongSide)];
+  if (scaling)
+  {
+    eval = eval * scaling(game, strongSide) / SCALE_FACTOR_NORMAL;
+  }
+  evalCache.store(game.getZobristKey(), eval);
+  return eval;
+}
+
+Score PlayerEngineMiniMax::traceEvaluation(SearchThread &thread, Game game, EvalTrace &trace)
+{
+  game.refreshTableScores();
+  trace.clear();
+  return evaluateHandCrafted(thread, game, trace);
+}
+
+std::string PlayerEngineMiniMax::getEvaluationBreakdown(Game game)
+{
+  auto thread = std::make_unique<SearchThread>();
+  auto trace = std::make_unique<EvalTrace>();
+  traceEvaluation(*thread, game, *trace);
+  std::string breakdown = trace->toString(game.getPhase());
+  if (NNUE::isLoaded())
+  {
+    breakdown += "\nThe search uses the network evaluation, not these terms";
+  }
+  return breakdown;
+}
+
+Game PlayerEngineMiniMax::getQuietPosition(SearchThread &thread, Game game)
+{
+  game.refreshTableScores();
+  quiescence(thread, game, 0, -SCORE_INFINITE, SCORE_INFINITE);
+  for (int i = 0; i < thread.pvLength[0]; i++)
+  {
+    game.makeMove(thread.pvTable[0][i]);
+  }
+  return game;
+}
+
+Score PlayerEngineMiniMax::scoreLeaf(SearchThread &thread, Game &game, bool const isQuiescence)
+{
+  return isQuiescence ? quiescence(thread, game, 0, -SCORE_INFINITE, SCORE_INFINITE) : evaluateForTurn(thread, game);
+}
+
+Score PlayerEngineMiniMax::evaluateForTurn(SearchThread &thread, Game &game, Score const alpha, Score const beta)
+{
+  if (game.getTurn() == Piece::Color::WHITE)
+  {
+    return evaluateGame(thread, game, alpha, beta);
+  }
+  return -evaluateGame(thread, game, -beta, -alpha);
+}
+
+std::vector<ScoredMove> PlayerEngineMiniMax::orderMoves(Game &game, std::vector<Move> const &moves, Move const &firstMove)
+{
+  std::vector<ScoredMove> scoredMoves;
+  scoredMoves.reserve(moves.size());
+  for (auto const &move : moves)
+  {
+    ScoredMove scoredMove;
+    scoredMove.move = move;
+    scoredMove.isCapture = game.isCapture(move);
+    scoredMove.see = 0;
+    scoredMove.orderScore = 0;
+    if (move == firstMove)
+    {
+      scoredMove.orderScore = 1000000;
+    }
+    if (scoredMove.isCapture || move.promotionPiece != Piece::Type::BLANK)
+    {
+      scoredMove.see = game.staticExchangeEvaluation(move);
+      if (scoredMove.orderScore == 0)
       {
-        blackPawns++;
+        scoredMove.orderScore = scoredMove.see >= 0 ? 100000 + scoredMove.see : -100000 + scoredMove.see;
       }
     }
-    if (whitePawns > 1)
+    scoredMoves.push_back(scoredMove);
+  }
+
+  std::stable_sort(scoredMoves.begin(), scoredMoves.end(), [](ScoredMove const &a, ScoredMove const &b)
+                   { return a.orderScore > b.orderScore; });
+  return scoredMoves;
+}
+
+void PlayerEngineMiniMax::checkLimits(SearchThread &thread)
+{
+  thread.publishedNodes.store(thread.statistics.nodes, std::memory_order_relaxed);
+  if (thread.id != 0 || thread.completedDepth == 0)
+  {
+    return;
+  }
+
+  bool isLimitReached = limits.stop && limits.stop->load(std::memory_order_relaxed);
+  if (limits.ponder && limits.ponder->load())
+  {
+    /* The own time only starts at the ponder hit */
+    limitStart = std::chrono::steady_clock::now();
+    if (isLimitReached)
     {
-      score -= 5 * (whitePawns - 1);
+      stopSearch = true;
     }
-    if (blackPawns > 1)
+    return;
+  }
+  if (limits.moveTime > 0)
+  {
+    auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - limitStart).count();
+    isLimitReached = isLimitReached || elapsed >= limits.moveTime;
+  }
+  if (limits.nodes > 0)
+  {
+    uint64_t nodes = 0;
+    for (auto const &searchThread : *searchThreads)
     {
-      score += 5 * (blackPawns - 1);
+      nodes += searchThread.publishedNodes.load(std::memory_order_relaxed);
     }
+    isLimitReached = isLimitReached || nodes >= limits.nodes;
   }
 
-  return score;
+  if (isLimitReached)
+  {
+    stopSearch = true;
+  }
 }
 
-int PlayerEngineMiniMax::evaluateGame(Game game)
+std::vector<Move> PlayerEngineMiniMax::probeRootTablebases(Game &game)
 {
-  int score = 0;
+  std::vector<Move> bestMoves;
+  if (Bitboards::popCount(game.getOccupiedBitboard()) > Tablebases::getMaxPieces())
+  {
+    return bestMoves;
+  }
 
-  score += evaluatePieceValue(game);
-  score += evaluatePieceMobility(game);
-  score += evaluatePiecePlacement(game);
-  score += evaluatePawnStructure(game);
+  /* Values and distances are those of the opponent after the move, the lowest rank is the best move */
+  int bestRank = 0;
+  for (auto const &move : game.getAllLegalMoves())
+  {
+    Game newGame(game);
+    newGame.makeMove(move);
+    BitbaseValue value;
+    int distanceToMate;
+    if (!Tablebases::probe(newGame, value, distanceToMate))
+    {
+      return std::vector<Move>();
+    }
 
-  if (game.isGameOver())
+    /* Mating moves first, the quicker the better, then draws, then losing moves, the slower the better */
+    int const rank = value == BitbaseValue::LOSS ? distanceToMate : (value == BitbaseValue::DRAW ? MAX_PLY * 2 : MAX_PLY * 4 - distanceToMate);
+    if (bestMoves.empty() || rank < bestRank)
+    {
+      bestMoves.clear();
+      bestRank = rank;
+    }
+    if (rank == bestRank)
+    {
+      bestMoves.push_back(move);
+    }
+  }
+  if (!bestMoves.empty())
   {
-    if (game.getTurn() == Piece::Color::WHITE)
+    logIt(LogLevel::INFO) << "Tablebases keep " << bestMoves.size() << " root moves";
+  }
+  return bestMoves;
+}
+
+void PlayerEngineMiniMax::iterativeDeepening(SearchThread &thread, Game &game)
+{
+  int const lastDepth = limits.depth > 0 ? std::min(limits.depth, MAX_PLY - 1) : maxDepth;
+  TimeManager timeManager;
+
+  /* Odd helper threads start one ply deeper than the main thread */
+  int const startDepth = 1 + (thread.id % 2);
+  for (int depth = std::min(startDepth, lastDepth); depth <= lastDepth; depth++)
+  {
+    std::vector<SearchLine> lines;
+    thread.excludedRootMoves.clear();
+    for (int lineIndex = 0; lineIndex < thread.numLines; lineIndex++)
     {
-      score -= 1000;
+      Score delta = ASPIRATION_WINDOW;
+      Score alpha = -SCORE_INFINITE;
+      Score beta = SCORE_INFINITE;
+      if (depth >= ASPIRATION_MIN_DEPTH && lineIndex < static_cast<int>(thread.lines.size()))
+      {
+        alpha = std::max(thread.lines[lineIndex].score - delta, -SCORE_INFINITE);
+        beta = std::min(thread.lines[lineIndex].score + delta, SCORE_INFINITE);
+      }
+
+      Score score;
+      while (true)
+      {
+        score = negaMax(thread, game, depth, 0, alpha, beta);
+        if (stopSearch.load(std::memory_order_relaxed))
+        {
+          break;
+        }
+
+        if (score <= alpha && alpha > -SCORE_INFINITE)
+        {
+          /* Fail low, widen the window downwards */
+          logIt(LogLevel::DEBUG) << "Aspiration fail low at depth " << depth << " with score " << score;
+          beta = (alpha + beta) / 2;
+          alpha = std::max(score - delta, -SCORE_INFINITE);
+        }
+        else if (score >= beta && beta < SCORE_INFINITE)
+        {
+          /* Fail high, widen the window upwards */
+          logIt(LogLevel::DEBUG) << "Aspiration fail high at depth " << depth << " with score " << score;
+          beta = std::min(score + delta, SCORE_INFINITE);
+        }
+        else
+        {
+          break;
+        }
+        delta += delta / 2 + 1;
+      }
+
+      /* No root moves left to find a line for */
+      if (stopSearch.load(std::memory_order_relaxed) || thread.pvLength[0] == 0)
+      {
+        break;
+      }
+
+      SearchLine line;
+      line.score = score;
+      line.depth = depth;
+      line.pv.assign(thread.pvTable[0], thread.pvTable[0] + thread.pvLength[0]);
+      thread.excludedRootMoves.push_back(line.pv[0]);
+      lines.push_back(line);
     }
-    else
+
+    /* Results of an iteration that was stopped halfway are not reliable */
+    if (stopSearch.load(std::memory_order_relaxed))
+    {
+      break;
+    }
+    std::stable_sort(lines.begin(), lines.end(), [](SearchLine const &a, SearchLine const &b)
+                     { return a.score > b.score; });
+    thread.lines = lines;
+    thread.completedDepth = depth;
+    if (!lines.empty())
     {
-      score += 1000;
+      logIt(LogLevel::DEBUG) << "Thread " << thread.id << " depth " << depth << " best move " << lines[0].pv[0] << " score " << scoreToString(lines[0].score);
+    }
+
+    if (thread.id == 0 && infoCallback && !lines.empty())
+    {
+      thread.publishedNodes.store(thread.statistics.nodes, std::memory_order_relaxed);
+      uint64_t nodes = 0;
+      for (auto const &searchThread : *searchThreads)
+      {
+        nodes += searchThread.publishedNodes.load(std::memory_order_relaxed);
+      }
+      auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - searchStart).count();
+      infoCallback(lines[0], nodes, elapsed);
+    }
+
+    /* A search on a clock does not start an iteration it is unlikely to finish */
+    if (thread.id == 0 && !lines.empty())
+    {
+      timeManager.update(lines[0].pv[0], lines[0].score);
+      if (!(limits.ponder && limits.ponder->load()) && limits.softTime > 0)
+      {
+        auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - limitStart).count();
+        if (!timeManager.shouldStartIteration(limits.softTime, elapsed))
+        {
+          break;
+        }
+      }
     }
   }
-  return score;
 }
 
-std::pair<Move, int> PlayerEngineMiniMax::miniMax(Game game, int depth, int alpha, int beta, bool isMaximizingPlayer)
+Score PlayerEngineMiniMax::negaMax(SearchThread &thread, Game &game, int depth, int ply, Score alpha, Score beta)
 {
-  if (depth == maxDepth || game.isGameOver())
+  thread.statistics.nodes++;
+  if ((thread.statistics.nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0)
+  {
+    checkLimits(thread);
+  }
+  thread.pvLength[ply] = 0;
+  if (stopSearch.load(std::memory_order_relaxed))
   {
-    return std::make_pair(Move(), evaluateGame(game));
+    return SCORE_DRAW;
   }
 
-  std::vector<Move> allLegalMoves = getAllLegalMoves(game);
+  bool const isPVNode = beta - alpha > 1;
+  uint64_t const key = game.getZobristKey();
 
-  if (isMaximizingPlayer)
+  TTEntry ttEntry;
+  Move ttMove;
+  if (transpositionTable.probe(key, ply, ttEntry))
   {
-    int maxEval = INT_MIN;
-    Move bestMove = Move();
-    for (auto &move : allLegalMoves)
+    ttMove = ttEntry.move;
+    if (!isPVNode && ply > 0 && ttEntry.depth >= depth &&
+        (ttEntry.bound == BOUND_EXACT ||
+         (ttEntry.bound == BOUND_LOWER && ttEntry.score >= beta) ||
+         (ttEntry.bound == BOUND_UPPER && ttEntry.score <= alpha)))
     {
-      Game newGame = Game(game);
-      newGame.makeMove(move);
-      int eval = miniMax(newGame, depth + 1, alpha, beta, false).second;
-      if (eval > maxEval)
+      return ttEntry.score;
+    }
+  }
+
+  if (ply > 0 && game.isGameOver())
+  {
+    return game.getResult() == Result::DRAW ? SCORE_DRAW : matedIn(ply);
+  }
+
+  if (depth <= 0 || ply >= MAX_PLY)
+  {
+    return quiescence(thread, game, ply, alpha, beta);
+  }
+
+  /* Tablebase scores are exact at any depth, they are stored so the next visit is a table cutoff.
+     Distances to mate past MAX_PLY are cut off, they still score as mates */
+  BitbaseValue tablebaseValue;
+  int distanceToMate;
+  if (ply > 0 && Bitboards::popCount(game.getOccupiedBitboard()) <= Tablebases::getMaxPieces() &&
+      Tablebases::probe(game, tablebaseValue, distanceToMate))
+  {
+    thread.statistics.tablebaseHits++;
+    int const mateDistance = std::min(ply + distanceToMate, MAX_PLY - 1);
+    Score const tablebaseScore = tablebaseValue == BitbaseValue::DRAW ? SCORE_DRAW : (tablebaseValue == BitbaseValue::WIN ? mateIn(mateDistance) : matedIn(mateDistance));
+    transpositionTable.store(key, ply, Move(), tablebaseScore, MAX_PLY - 1, BOUND_EXACT);
+    return tablebaseScore;
+  }
+
+  bool const isInCheck = game.isKingInCheck(game.getTurn());
+
+  /* Shallow depth pruning, only away from the principal variation and mate scores */
+  bool canFutilityPrune = false;
+  Score staticEval = -SCORE_INFINITE;
+  if (!isPVNode && !isInCheck && ply > 0 && depth <= PRUNING_MAX_DEPTH && !isMateScore(alpha) && !isMateScore(beta))
+  {
+    staticEval = evaluateForTurn(thread, game);
+
+    /* Reverse futility: the opponent is unlikely to win back the margin in the remaining plies */
+    if (staticEval - pruningMargins.reverseFutility[depth] >= beta)
+    {
+      thread.statistics.reverseFutilityPrunes++;
+      return staticEval;
+    }
+
+    /* Razoring: if even a margin above the static evaluation does not reach alpha, only captures can help */
+    if (staticEval + pruningMargins.razoring[depth] <= alpha)
+    {
+      Score const score = quiescence(thread, game, ply, alpha, alpha + 1);
+      if (score <= alpha)
       {
-        maxEval = eval;
-        bestMove = move;
+        thread.statistics.razoringPrunes++;
+        return score;
       }
-      alpha = std::max(alpha, eval);
-      if (beta <= alpha)
+    }
+
+    /* Futility: quiet moves are unlikely to raise the score by the margin */
+    canFutilityPrune = staticEval + pruningMargins.futility[depth] <= alpha;
+  }
+
+  std::vector<Move> allLegalMoves = game.getAllLegalMoves();
+  if (allLegalMoves.empty())
+  {
+    /* Checkmate or stalemate */
+    return isInCheck ? matedIn(ply) : SCORE_DRAW;
+  }
+
+  /* At the root the best move of the previous iteration for this line is searched first */
+  Move firstMove = ttMove;
+  if (ply == 0)
+  {
+    size_t const lineIndex = thread.excludedRootMoves.size();
+    firstMove = lineIndex < thread.lines.size() ? thread.lines[lineIndex].pv[0] : Move();
+  }
+  std::vector<ScoredMove> scoredMoves = orderMoves(game, allLegalMoves, firstMove);
+
+  Score const originalAlpha = alpha;
+  Score bestScore = -SCORE_INFINITE;
+  Move bestMove;
+  int moveIndex = 0;
+  for (auto const &scoredMove : scoredMoves)
+  {
+    Move const &move = scoredMove.move;
+    if (ply == 0 && (std::find(thread.excludedRootMoves.begin(), thread.excludedRootMoves.end(), move) != thread.excludedRootMoves.end() ||
+                     (!tablebaseRootMoves.empty() && std::find(tablebaseRootMoves.begin(), tablebaseRootMoves.end(), move) == tablebaseRootMoves.end())))
+    {
+      continue;
+    }
+
+    Game newGame = Game(game);
+    newGame.makeMove(move);
+
+    /* Quiet moves and captures that lose material may be pruned or reduced, unless they give check */
+    bool const isQuiet = move.promotionPiece == Piece::Type::BLANK && (!scoredMove.isCapture || scoredMove.see < 0) &&
+                         !newGame.isKingInCheck(newGame.getTurn());
+
+    if (canFutilityPrune && moveIndex > 0 && isQuiet)
+    {
+      thread.statistics.futilityPrunes++;
+      bestScore = std::max(bestScore, staticEval + pruningMargins.futility[depth]);
+      continue;
+    }
+
+    Score score;
+    if (moveIndex++ == 0)
+    {
+      score = -negaMax(thread, newGame, depth - 1, ply + 1, -beta, -alpha);
+    }
+    else
+    {
+      /* Late quiet moves and captures that lose material are searched with reduced depth */
+      int reduction = 0;
+      if (depth >= LMR_MIN_DEPTH && moveIndex > LMR_MIN_MOVE_INDEX && !isInCheck && isQuiet)
       {
-        break;
+        reduction = moveIndex > 2 * LMR_MIN_MOVE_INDEX ? 2 : 1;
+      }
+
+      /* Null window probe, re-search with the full depth and then the full window if it beats alpha */
+      score = -negaMax(thread, newGame, depth - 1 - reduction, ply + 1, -alpha - 1, -alpha);
+      if (score > alpha && reduction > 0)
+      {
+        score = -negaMax(thread, newGame, depth - 1, ply + 1, -alpha - 1, -alpha);
       }
+      if (score > alpha && score < beta)
+      {
+        score = -negaMax(thread, newGame, depth - 1, ply + 1, -beta, -alpha);
+      }
+    }
+
+    if (stopSearch.load(std::memory_order_relaxed))
+    {
+      return SCORE_DRAW;
+    }
+
+    if (score > bestScore)
+    {
+      bestScore = score;
+      if (score > alpha)
+      {
+        bestMove = move;
+
+        /* The principal variation of this node is the move followed by the one of the child */
+        thread.pvTable[ply][0] = move;
+        std::copy(thread.pvTable[ply + 1], thread.pvTable[ply + 1] + thread.pvLength[ply + 1], thread.pvTable[ply] + 1);
+        thread.pvLength[ply] = thread.pvLength[ply + 1] + 1;
+      }
+    }
+    alpha = std::max(alpha, score);
+    if (alpha >= beta)
+    {
+      break;
     }
-    return std::make_pair(bestMove, maxEval);
   }
-  else
+
+  /* A root searched with excluded moves does not give the real score of the position */
+  if (ply > 0 || thread.excludedRootMoves.empty())
+  {
+    Bound const bound = bestScore >= beta ? BOUND_LOWER : (bestScore > originalAlpha ? BOUND_EXACT : BOUND_UPPER);
+    transpositionTable.store(key, ply, bestMove, bestScore, depth, bound);
+  }
+
+  return bestScore;
+}
+
+Score PlayerEngineMiniMax::quiescence(SearchThread &thread, Game &game, int ply, Score alpha, Score beta)
+{
+  thread.statistics.nodes++;
+  if ((thread.statistics.nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0)
+  {
+    checkLimits(thread);
+  }
+  thread.pvLength[ply] = 0;
+  if (stopSearch.load(std::memory_order_relaxed))
+  {
+    return SCORE_DRAW;
+  }
+
+  /* Stand pat, the player to move does not have to capture unless in check */
+  bool const isInCheck = game.isKingInCheck(game.getTurn());
+  Score bestScore = -SCORE_INFINITE;
+  if (!isInCheck || ply >= MAX_PLY)
   {
-    int minEval = INT_MAX;
-    Move bestMove = Move();
-    for (auto &move : allLegalMoves)
+    /* Only whether the stand pat is outside the window matters, so it can be evaluated lazily */
+    bestScore = evaluateForTurn(thread, game, alpha, beta);
+    if (bestScore >= beta || ply >= MAX_PLY)
     {
-      Game newGame = Game(game);
-      newGame.makeMove(move);
-      int eval = miniMax(newGame, depth + 1, alpha, beta, true).second;
-      if (eval < minEval)
+      return bestScore;
+    }
+    alpha = std::max(alpha, bestScore);
+  }
+
+  std::vector<Move> allLegalMoves = game.getAllLegalMoves();
+  if (allLegalMoves.empty())
+  {
+    /* Checkmate or stalemate */
+    return isInCheck ? matedIn(ply) : SCORE_DRAW;
+  }
+
+  for (auto const &scoredMove : orderMoves(game, allLegalMoves, Move()))
+  {
+    if (!isInCheck)
+    {
+      if (!scoredMove.isCapture && scoredMove.move.promotionPiece == Piece::Type::BLANK)
       {
-        minEval = eval;
-        bestMove = move;
+        continue;
       }
-      beta = std::min(beta, eval);
-      if (beta <= alpha)
+
+      /* Captures that lose material are pruned */
+      if (scoredMove.see < 0)
       {
-        break;
+        continue;
       }
     }
-    return std::make_pair(bestMove, minEval);
+
+    Game newGame = Game(game);
+    newGame.makeMove(scoredMove.move);
+    Score const score = -quiescence(thread, newGame, ply + 1, -beta, -alpha);
+    if (stopSearch.load(std::memory_order_relaxed))
+    {
+      return SCORE_DRAW;
+    }
+
+    if (score > bestScore)
+    {
+      bestScore = score;
+      if (score > alpha)
+      {
+        thread.pvTable[ply][0] = scoredMove.move;
+        std::copy(thread.pvTable[ply + 1], thread.pvTable[ply + 1] + thread.pvLength[ply + 1], thread.pvTable[ply] + 1);
+        thread.pvLength[ply] = thread.pvLength[ply + 1] + 1;
+      }
+    }
+    alpha = std::max(alpha, score);
+    if (alpha >= beta)
+    {
+      break;
+    }
   }
-}
\ No newline at end of file
+
+  return bestScore;
+}
@@ -0,0 +1,542 @@
+#include "../include/tablebase.h"
+#include "../include/game.h"
+#include "../include/logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+  constexpr int HEADER_SIZE = 6;
+
+  /* decoded blocks shared by all tablebases, the most recently used first */
+  struct BlockCache
+  {
+    std::mutex mutex;
+    std::list<std::pair<uint64_t, std::shared_ptr<std::vector<uint8_t> const>>> blocks;
+    std::unordered_map<uint64_t, decltype(blocks)::iterator> entries;
+  };
+
+  BlockCache blockCache;
+
+  /* a block the thread has looked up before, it stays valid after the shared cache evicts it */
+  struct ThreadCachedBlock
+  {
+    uint64_t key = UINT64_MAX;
+    std::shared_ptr<std::vector<uint8_t> const> values;
+  };
+
+  /* Hits in the cache of the thread take no lock, only its misses go to the shared cache */
+  thread_local ThreadCachedBlock threadCache[TABLEBASE_THREAD_CACHE_BLOCKS];
+
+  /* ids are never reused, so the blocks of a closed tablebase are only ever evicted */
+  std::atomic<uint64_t> nextId(0);
+
+  std::vector<std::unique_ptr<Tablebase>> tablebases;
+  int maxPieces = 0;
+
+  inline uint64_t cacheKey(uint64_t const id, size_t const block)
+  {
+    return (id << 40) | block;
+  }
+
+  /* neighbouring blocks take neighbouring slots, the id spreads the tablebases apart */
+  inline size_t threadCacheSlot(uint64_t const key)
+  {
+    return ((key >> 40) * 0x9E3779B97F4A7C15ULL + key) & (TABLEBASE_THREAD_CACHE_BLOCKS - 1);
+  }
+
+  /**
+   * @brief lengths of the Huffman codes of the byte values, 0 for values that do not occur
+   *
+   * Codes longer than TABLEBASE_MAX_CODE_LENGTH are avoided by halving the frequencies
+   * until the tree is flat enough, which only costs a little compression on rare values.
+   */
+  std::vector<int> getCodeLengths(std::vector<uint64_t> frequencies)
+  {
+    std::vector<int> lengths(TABLEBASE_NUM_OF_SYMBOLS, 0);
+    while (true)
+    {
+      /* Leaves are the symbols, the inner nodes follow them */
+      std::vector<int> parents;
+      using Node = std::pair<uint64_t, int>;
+      std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+      std::vector<int> leaves(TABLEBASE_NUM_OF_SYMBOLS, -1);
+      for (int symbol = 0; symbol < TABLEBASE_NUM_OF_SYMBOLS; symbol++)
+      {
+        if (frequencies[symbol] > 0)
+        {
+          leaves[symbol] = parents.size();
+          queue.emplace(frequencies[symbol], parents.size());
+          parents.push_back(-1);
+        }
+      }
+
+      /* A single value still needs a code of one bit */
+      if (queue.size() == 1)
+      {
+        lengths[std::find(leaves.begin(), leaves.end(), 0) - leaves.begin()] = 1;
+        return lengths;
+      }
+
+      while (queue.size() > 1)
+      {
+        Node const first = queue.top();
+        queue.pop();
+        Node const second = queue.top();
+        queue.pop();
+        parents[first.second] = parents.size();
+        parents[second.second] = parents.size();
+        queue.emplace(first.first + second.first, parents.size());
+        parents.push_back(-1);
+      }
+
+      int maxLength = 0;
+      for (int symbol = 0; symbol < TABLEBASE_NUM_OF_SYMBOLS; symbol++)
+      {
+        lengths[symbol] = 0;
+        for (int node = leaves[symbol]; node >= 0 && parents[node] >= 0; node = parents[node])
+        {
+          lengths[symbol]++;
+        }
+        maxLength = std::max(maxLength, lengths[symbol]);
+      }
+      if (maxLength <= TABLEBASE_MAX_CODE_LENGTH)
+      {
+        return lengths;
+      }
+      for (auto &frequency : frequencies)
+      {
+        frequency = frequency > 0 ? (frequency >> 1) | 1 : 0;
+      }
+    }
+  }
+
+  /**
+   * @brief canonical codes of the code lengths, the codes of a length count up in the order of the values
+   */
+  std::vector<uint32_t> getCodes(std::vector<int> const &lengths)
+  {
+    std::vector<uint32_t> codes(TABLEBASE_NUM_OF_SYMBOLS, 0);
+    uint32_t code = 0;
+    for (int length = 1; length <= TABLEBASE_MAX_CODE_LENGTH; length++)
+    {
+      for (int symbol = 0; symbol < TABLEBASE_NUM_OF_SYMBOLS; symbol++)
+      {
+        if (lengths[symbol] == length)
+        {
+          codes[symbol] = code++;
+        }
+      }
+      code <<= 1;
+    }
+    return codes;
+  }
+
+  /**
+   * @brief writer of the bits of the codes, the most significant bit of a byte first
+   */
+  class BitWriter
+  {
+  public:
+    BitWriter(std::vector<uint8_t> &bytes) : bytes(bytes), buffer(0), numOfBits(0) {}
+
+    void write(uint32_t const code, int const length)
+    {
+      buffer = (buffer << length) | code;
+      numOfBits += length;
+      while (numOfBits >= 8)
+      {
+        numOfBits -= 8;
+        bytes.push_back(static_cast<uint8_t>(buffer >> numOfBits));
+      }
+    }
+
+    /**
+     * @brief pads the last byte with zeros, so the next block starts on a byte
+     */
+    void flush()
+    {
+      if (numOfBits > 0)
+      {
+        bytes.push_back(static_cast<uint8_t>(buffer << (8 - numOfBits)));
+      }
+      buffer = 0;
+      numOfBits = 0;
+    }
+
+  private:
+    std::vector<uint8_t> &bytes;
+    uint64_t buffer;
+    int numOfBits;
+  };
+
+  inline uint8_t valueByte(Bitbase const &bitbase, size_t const index)
+  {
+    return static_cast<uint8_t>(bitbase.getDistanceToMate(index) + 1);
+  }
+};
+
+Tablebase::Tablebase(std::string const &signature) : id(nextId++),
+                                                     layout(signature),
+                                                     numOfPieces(signature.size()),
+                                                     data(nullptr),
+                                                     mappedSize(0),
+                                                     numOfPositions(0),
+                                                     blockSize(0),
+                                                     numOfBlocks(0),
+                                                     blocks(nullptr)
+{
+}
+
+Tablebase::~Tablebase()
+{
+  close();
+}
+
+std::string const &Tablebase::getSignature() const
+{
+  return layout.getSignature();
+}
+
+int Tablebase::getNumOfPieces() const
+{
+  return numOfPieces;
+}
+
+bool Tablebase::write(std::string const &path, Bitbase const &bitbase)
+{
+  size_t const numOfPositions = bitbase.getNumOfPositions();
+  std::vector<uint64_t> frequencies(TABLEBASE_NUM_OF_SYMBOLS, 0);
+  uint32_t maxDistanceToMate = 0;
+  for (size_t index = 0; index < numOfPositions; index++)
+  {
+    /* A loaded bitbase only knows which positions are won */
+    if (bitbase.isWon(index) && bitbase.getDistanceToMate(index) < 0)
+    {
+      logIt(LogLevel::ERROR) << "Bitbase " << bitbase.getSignature() << " has no distances to mate, it has to be generated";
+      return false;
+    }
+    frequencies[valueByte(bitbase, index)]++;
+    maxDistanceToMate = std::max<uint32_t>(maxDistanceToMate, std::max(0, bitbase.getDistanceToMate(index)));
+  }
+
+  std::vector<int> const lengths = getCodeLengths(frequencies);
+  std::vector<uint32_t> const codes = getCodes(lengths);
+
+  size_t const numOfBlocks = (numOfPositions + TABLEBASE_BLOCK_SIZE - 1) / TABLEBASE_BLOCK_SIZE;
+  std::vector<uint64_t> offsets;
+  std::vector<uint8_t> compressed;
+  BitWriter writer(compressed);
+  for (size_t index = 0; index < numOfPositions; index++)
+  {
+    if (index % TABLEBASE_BLOCK_SIZE == 0)
+    {
+      writer.flush();
+      offsets.push_back(compressed.size());
+    }
+    uint8_t const value = valueByte(bitbase, index);
+    writer.write(codes[value], lengths[value]);
+  }
+  writer.flush();
+  offsets.push_back(compressed.size());
+
+  std::ofstream file(path, std::ios::binary);
+  uint32_t const header[HEADER_SIZE] = {TABLEBASE_FILE_MAGIC, TABLEBASE_FILE_VERSION, static_cast<uint32_t>(numOfPositions),
+                                        TABLEBASE_BLOCK_SIZE, static_cast<uint32_t>(numOfBlocks), maxDistanceToMate};
+  uint8_t codeLengths[TABLEBASE_NUM_OF_SYMBOLS];
+  std::copy(lengths.begin(), lengths.end(), codeLengths);
+  file.write(reinterpret_cast<char const *>(header), sizeof(header));
+  file.write(reinterpret_cast<char const *>(codeLengths), sizeof(codeLengths));
+  file.write(reinterpret_cast<char const *>(offsets.data()), offsets.size() * sizeof(uint64_t));
+  file.write(reinterpret_cast<char const *>(compressed.data()), compressed.size());
+  if (!file)
+  {
+    logIt(LogLevel::ERROR) << "Could not write tablebase " << path;
+    return false;
+  }
+  logIt(LogLevel::DEBUG) << "Compressed " << bitbase.getSignature() << " from " << numOfPositions << " to " << compressed.size() << " bytes";
+  return true;
+}
+
+bool Tablebase::open(std::string const &path)
+{
+  close();
+
+  /* A new id, the caches may still hold blocks of a file opened before */
+  id = nextId++;
+
+  int const file = ::open(path.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    logIt(LogLevel::DEBUG) << "No tablebase at " << path;
+    return false;
+  }
+  struct stat fileStat;
+  size_t const tablesSize = HEADER_SIZE * sizeof(uint32_t) + TABLEBASE_NUM_OF_SYMBOLS;
+  if (fstat(file, &fileStat) != 0 || static_cast<size_t>(fileStat.st_size) < tablesSize)
+  {
+    logIt(LogLevel::WARNING) << "Tablebase " << path << " is truncated";
+    ::close(file);
+    return false;
+  }
+
+  void *mapped = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+  /* The mapping stays valid after the file is closed */
+  ::close(file);
+  if (mapped == MAP_FAILED)
+  {
+    logIt(LogLevel::WARNING) << "Failed to map tablebase " << path;
+    return false;
+  }
+  data = static_cast<unsigned char const *>(mapped);
+  mappedSize = fileStat.st_size;
+
+  uint32_t header[HEADER_SIZE];
+  std::memcpy(header, data, sizeof(header));
+  numOfPositions = header[2];
+  blockSize = header[3];
+  numOfBlocks = header[4];
+  if (header[0] != TABLEBASE_FILE_MAGIC || header[1] != TABLEBASE_FILE_VERSION || numOfPositions != layout.getNumOfPositions() ||
+      blockSize == 0 || numOfBlocks != (numOfPositions + blockSize - 1) / blockSize)
+  {
+    logIt(LogLevel::WARNING) << "Tablebase " << path << " has an unsupported header";
+    close();
+    return false;
+  }
+
+  size_t const blocksStart = tablesSize + (numOfBlocks + 1) * sizeof(uint64_t);
+  blocks = data + blocksStart;
+  if (mappedSize < blocksStart || getBlockOffset(numOfBlocks) > mappedSize - blocksStart)
+  {
+    logIt(LogLevel::WARNING) << "Tablebase " << path << " is truncated";
+    close();
+    return false;
+  }
+
+  /* The decoding tables of the canonical code, the code lengths have to leave no code ambiguous */
+  unsigned char const *codeLengths = data + HEADER_SIZE * sizeof(uint32_t);
+  std::fill(numOfCodes, numOfCodes + TABLEBASE_MAX_CODE_LENGTH + 1, 0);
+  int numOfSymbols = 0;
+  for (int length = 1; length <= TABLEBASE_MAX_CODE_LENGTH; length++)
+  {
+    firstSymbol[length] = numOfSymbols;
+    for (int symbol = 0; symbol < TABLEBASE_NUM_OF_SYMBOLS; symbol++)
+    {
+      if (codeLengths[symbol] == length)
+      {
+        symbols[numOfSymbols++] = symbol;
+        numOfCodes[length]++;
+      }
+    }
+  }
+  int code = 0;
+  for (int length = 1; length <= TABLEBASE_MAX_CODE_LENGTH; length++)
+  {
+    firstCode[length] = code;
+    code = (code + numOfCodes[length]) << 1;
+    if (code > (2 << length))
+    {
+      logIt(LogLevel::WARNING) << "Tablebase " << path << " has invalid code lengths";
+      close();
+      return false;
+    }
+  }
+
+  logIt(LogLevel::DEBUG) << "Opened tablebase " << path << " with " << numOfBlocks << " blocks, longest mate " << header[5] << " plies";
+  return true;
+}
+
+void Tablebase::close()
+{
+  if (data)
+  {
+    munmap(const_cast<unsigned char *>(data), mappedSize);
+  }
+  data = nullptr;
+  mappedSize = 0;
+  blocks = nullptr;
+  numOfBlocks = 0;
+}
+
+bool Tablebase::isOpen() const
+{
+  return data != nullptr;
+}
+
+uint64_t Tablebase::getBlockOffset(size_t const block) const
+{
+  uint64_t offset;
+  std::memcpy(&offset, blocks - (numOfBlocks + 1 - block) * sizeof(uint64_t), sizeof(offset));
+  return offset;
+}
+
+std::shared_ptr<std::vector<uint8_t> const> Tablebase::decodeBlock(size_t const block) const
+{
+  size_t const numOfValues = std::min(blockSize, numOfPositions - block * blockSize);
+  auto decoded = std::make_shared<std::vector<uint8_t>>(numOfValues, 0);
+
+  /* A damaged block reads zeros past its end and decodes to draws rather than out of bounds */
+  uint64_t const begin = getBlockOffset(block);
+  uint64_t const end = std::max(begin, std::min(getBlockOffset(block + 1), getBlockOffset(numOfBlocks)));
+  uint64_t bit = begin * 8;
+  for (auto &value : *decoded)
+  {
+    int code = 0;
+    for (int length = 1; length <= TABLEBASE_MAX_CODE_LENGTH; length++, bit++)
+    {
+      int const nextBit = bit / 8 < end ? (blocks[bit / 8] >> (7 - bit % 8)) & 1 : 0;
+      code = (code << 1) | nextBit;
+      if (code - firstCode[length] < numOfCodes[length])
+      {
+        value = symbols[firstSymbol[length] + code - firstCode[length]];
+        bit++;
+        break;
+      }
+    }
+  }
+  return decoded;
+}
+
+uint8_t Tablebase::getByte(size_t const index) const
+{
+  size_t const block = index / blockSize;
+  uint64_t const key = cacheKey(id, block);
+  ThreadCachedBlock &cached = threadCache[threadCacheSlot(key)];
+  if (cached.key != key)
+  {
+    cached.values = getBlock(block);
+    cached.key = key;
+  }
+  return (*cached.values)[index % blockSize];
+}
+
+std::shared_ptr<std::vector<uint8_t> const> Tablebase::getBlock(size_t const block) const
+{
+  uint64_t const key = cacheKey(id, block);
+  {
+    std::lock_guard<std::mutex> lock(blockCache.mutex);
+    auto const entry = blockCache.entries.find(key);
+    if (entry != blockCache.entries.end())
+    {
+      blockCache.blocks.splice(blockCache.blocks.begin(), blockCache.blocks, entry->second);
+      return entry->second->second;
+    }
+  }
+
+  /* Blocks are decoded outside of the lock, two threads may decode the same block at worst */
+  auto const decoded = decodeBlock(block);
+  std::lock_guard<std::mutex> lock(blockCache.mutex);
+  if (blockCache.entries.find(key) == blockCache.entries.end())
+  {
+    blockCache.blocks.emplace_front(key, decoded);
+    blockCache.entries[key] = blockCache.blocks.begin();
+    if (blockCache.blocks.size() > TABLEBASE_CACHE_BLOCKS)
+    {
+      blockCache.entries.erase(blockCache.blocks.back().first);
+      blockCache.blocks.pop_back();
+    }
+  }
+  return decoded;
+}
+
+bool Tablebase::probe(Game &game, BitbaseValue &value, int &distanceToMate) const
+{
+  size_t index;
+  if (!isOpen() || !layout.getIndex(game, index))
+  {
+    return false;
+  }
+
+  uint8_t const byte = getByte(index);
+  if (byte == 0)
+  {
+    value = BitbaseValue::DRAW;
+    distanceToMate = 0;
+    return true;
+  }
+  /* The positions with the strong side to move make up the first half of the index */
+  value = index < numOfPositions / 2 ? BitbaseValue::WIN : BitbaseValue::LOSS;
+  distanceToMate = byte - 1;
+  return true;
+}
+
+namespace Tablebases
+{
+  std::string getPath(std::string const &directory, std::string const &signature)
+  {
+    return directory + "/" + signature + TABLEBASE_FILE_EXTENSION;
+  }
+
+  bool load(std::string const &directory)
+  {
+    /* Files are named by their signatures */
+    std::vector<std::string> signatures;
+    std::error_code error;
+    for (auto const &entry : std::filesystem::directory_iterator(directory, error))
+    {
+      std::string const signature = entry.path().stem().string();
+      if (entry.path().extension() == TABLEBASE_FILE_EXTENSION && Bitbases::isValidSignature(signature))
+      {
+        signatures.push_back(signature);
+      }
+    }
+    std::sort(signatures.begin(), signatures.end());
+
+    std::vector<std::unique_ptr<Tablebase>> loaded;
+    int loadedMaxPieces = 0;
+    for (auto const &signature : signatures)
+    {
+      auto tablebase = std::make_unique<Tablebase>(signature);
+      if (tablebase->open(getPath(directory, signature)))
+      {
+        loadedMaxPieces = std::max(loadedMaxPieces, tablebase->getNumOfPieces());
+        loaded.push_back(std::move(tablebase));
+      }
+    }
+    if (loaded.empty())
+    {
+      logIt(LogLevel::INFO) << "No tablebases found in " << directory;
+      return false;
+    }
+
+    logIt(LogLevel::INFO) << "Loaded " << loaded.size() << " tablebases of up to " << loadedMaxPieces << " pieces from " << directory;
+    tablebases = std::move(loaded);
+    maxPieces = loadedMaxPieces;
+    return true;
+  }
+
+  bool isLoaded()
+  {
+    return !tablebases.empty();
+  }
+
+  int getMaxPieces()
+  {
+    return maxPieces;
+  }
+
+  bool probe(Game &game, BitbaseValue &value, int &distanceToMate)
+  {
+    for (auto const &tablebase : tablebases)
+    {
+      if (tablebase->probe(game, value, distanceToMate))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+};
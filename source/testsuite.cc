@@ -1,4 +1,363 @@
 #include "../include/testsuite.h"
+#include "../include/bitbase.h"
+#include "../include/openingbook.h"
+#include "../include/tablebase.h"
+#include "../include/texel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+namespace
+{
+  /**
+   * @brief finds the legal move between two squares in chess notation, such as "e2e4",
+   *          with the letter of the promotion piece after it for promotions, such as "e7e8q"
+   *
+   * @return true if there is such a move, otherwise false
+   */
+  bool findMove(Game &game, std::string const &notation, Move &found)
+  {
+    for (Move const &move : game.getAllLegalMoves())
+    {
+      char const promotion = move.promotionPiece == Piece::Type::BLANK ? ' ' : std::tolower(Piece::pieceToChar(move.promotionPiece));
+      if (move.from.toChessNotation() == notation.substr(0, 2) && move.to.toChessNotation() == notation.substr(2, 2) &&
+          promotion == (notation.size() > 4 ? notation[4] : ' '))
+      {
+        found = move;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief plays the legal move of a notation, see findMove
+   *
+   * @return true if there is such a move, otherwise false
+   */
+  bool playMove(Game &game, std::string const &notation)
+  {
+    Move move;
+    if (!findMove(game, notation, move))
+    {
+      return false;
+    }
+    game.makeMove(move);
+    return true;
+  }
+
+  /**
+   * @brief number of leaves of the tree of legal moves of a depth
+   */
+  uint64_t perft(Game &game, int const depth)
+  {
+    if (depth == 0)
+    {
+      return 1;
+    }
+    uint64_t numOfLeaves = 0;
+    for (Move const &move : game.getAllLegalMoves())
+    {
+      Game child(game);
+      child.makeMove(move);
+      numOfLeaves += perft(child, depth - 1);
+    }
+    return numOfLeaves;
+  }
+};
+
+void TestSuite::check(bool const isPassed, std::string const &description)
+{
+  numOfChecks++;
+  if (!isPassed)
+  {
+    numOfFailedChecks++;
+    std::cout << "FAILED: " << description << std::endl;
+  }
+}
+
+void TestSuite::testBitbases()
+{
+  Bitbase draws("KK");
+  draws.generate(1, {});
+
+  /* The longest mates are 10 moves with the queen and 16 with the rook, counted from the move of the lone king */
+  struct LongestMate
+  {
+    std::string signature;
+    std::string FEN;
+    int distanceToMate;
+  };
+  for (auto const &longestMate : {LongestMate{"KQK", "8/8/8/8/4k3/8/1Q6/K7 b - - 0 1", 20},
+                                  LongestMate{"KRK", "8/8/8/8/8/8/1Rk5/K7 b - - 0 1", 32}})
+  {
+    std::string const &signature = longestMate.signature;
+    Bitbase bitbase(signature);
+    bitbase.generate(2, {&draws});
+    check(bitbase.isReady(), signature + " bitbase is generated");
+
+    bool isVerified = true;
+    int maxDistanceToMate = 0;
+    for (size_t index = 0; index < bitbase.getNumOfPositions(); index++)
+    {
+      isVerified = bitbase.verifyPosition(index, {&bitbase, &draws}) && isVerified;
+      maxDistanceToMate = std::max(maxDistanceToMate, bitbase.getDistanceToMate(index));
+    }
+    check(isVerified, signature + " bitbase matches a search of one ply in every position");
+    check(maxDistanceToMate == longestMate.distanceToMate,
+          signature + " longest mate is " + std::to_string(maxDistanceToMate) + " plies, expected " + std::to_string(longestMate.distanceToMate));
+
+    Game game(longestMate.FEN);
+    BitbaseValue value;
+    size_t index;
+    check(bitbase.probe(game, value) && value == BitbaseValue::LOSS && bitbase.getIndex(game, index) &&
+              bitbase.getDistanceToMate(index) == longestMate.distanceToMate,
+          signature + " probe of " + longestMate.FEN);
+  }
+}
+
+void TestSuite::testTablebases()
+{
+  Bitbase draws("KK");
+  draws.generate(1, {});
+
+  /* Tablebases of all draws compress to a single symbol, the others to codes of several lengths */
+  std::vector<std::unique_ptr<Bitbase>> bitbases;
+  std::vector<std::unique_ptr<Tablebase>> tablebases;
+  std::vector<std::string> paths;
+  bool isWritten = true;
+  for (std::string const signature : {"KQK", "KRK", "KBK", "KNK"})
+  {
+    bitbases.push_back(std::make_unique<Bitbase>(signature));
+    bitbases.back()->generate(1, {&draws});
+    paths.push_back(Tablebases::getPath(std::filesystem::temp_directory_path().string(), "regression_" + signature));
+    tablebases.push_back(std::make_unique<Tablebase>(signature));
+    isWritten = Tablebase::write(paths.back(), *bitbases.back()) && tablebases.back()->open(paths.back()) && isWritten;
+  }
+  check(isWritten, "tablebases are written and opened");
+
+  /* The tablebases are probed in turn, so their blocks share the caches of the threads */
+  auto const countMismatches = [&](size_t const first, size_t const step)
+  {
+    size_t numOfMismatches = 0;
+    for (size_t index = first; index < bitbases[0]->getNumOfPositions(); index += step)
+    {
+      for (size_t i = 0; i < bitbases.size(); i++)
+      {
+        std::string const FEN = bitbases[i]->getFEN(index);
+        if (FEN.empty())
+        {
+          continue;
+        }
+        Game game(FEN);
+        BitbaseValue value;
+        int distanceToMate;
+        bool const isWon = bitbases[i]->isWon(index);
+        if (!tablebases[i]->probe(game, value, distanceToMate) || (value != BitbaseValue::DRAW) != isWon ||
+            (isWon && distanceToMate != bitbases[i]->getDistanceToMate(index)))
+        {
+          numOfMismatches++;
+        }
+      }
+    }
+    return numOfMismatches;
+  };
+  check(countMismatches(0, 1) == 0, "tablebase probes match the bitbases");
+
+  int const numOfThreads = 4;
+  std::atomic<size_t> numOfMismatches(0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < numOfThreads; i++)
+  {
+    threads.emplace_back([&, i]()
+                         { numOfMismatches += countMismatches(i, numOfThreads); });
+  }
+  for (auto &thread : threads)
+  {
+    thread.join();
+  }
+  check(numOfMismatches == 0, "tablebase probes from several threads match the bitbases");
+
+  Game game("8/8/8/3k4/8/8/8/Q3K3 w - - 0 1");
+  BitbaseValue value;
+  int distanceToMate;
+  check(!tablebases[1]->probe(game, value, distanceToMate), "KRK tablebase does not cover KQK");
+
+  for (size_t i = 0; i < tablebases.size(); i++)
+  {
+    tablebases[i]->close();
+    std::filesystem::remove(paths[i]);
+  }
+}
+
+void TestSuite::testPolyglotKeys()
+{
+  /* The example positions of the Polyglot book format with their keys */
+  struct PolyglotExample
+  {
+    std::string FEN;
+    std::vector<std::string> moves;
+    uint64_t key;
+  };
+  std::vector<PolyglotExample> const examples = {
+      {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", {}, 0x463B96181691FC9CULL},
+      {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1", {"e2e4"}, 0x823C9B50FD114196ULL},
+      {"rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2", {"e2e4", "d7d5"}, 0x0756B94461C50FB0ULL},
+      {"rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2", {"e2e4", "d7d5", "e4e5"}, 0x662FAFB965DB29D4ULL},
+      {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", {"e2e4", "d7d5", "e4e5", "f7f5"}, 0x22A48B5A8E47FF78ULL},
+      {"rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3", {"e2e4", "d7d5", "e4e5", "f7f5", "e1e2"}, 0x652A607CA3F242C1ULL},
+      {"rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4", {"e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7"}, 0x00FDD303C946BDD9ULL},
+      {"rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3", {"a2a4", "b7b5", "h2h4", "b5b4", "c2c4"}, 0x3C8123EA7B067637ULL},
+      {"rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4", {"a2a4", "b7b5", "h2h4", "b5b4", "c2c4", "b4c3", "a1a3"}, 0x5C3F9B829B279560ULL},
+  };
+
+  for (auto const &example : examples)
+  {
+    Game fromFEN(example.FEN);
+    check(OpeningBook::getKey(fromFEN) == example.key, "Polyglot key of " + example.FEN);
+
+    /* The castling rights and en passant squares have to come out the same when the moves are played */
+    Game fromMoves;
+    bool isPlayed = true;
+    for (auto const &move : example.moves)
+    {
+      isPlayed = isPlayed && playMove(fromMoves, move);
+    }
+    check(isPlayed && OpeningBook::getKey(fromMoves) == example.key, "Polyglot key after the moves to " + example.FEN);
+  }
+}
+
+void TestSuite::testTexelTuning()
+{
+  PlayerEngineMiniMax engine(DEFAULT_MAX_DEPTH, 1);
+  std::vector<EvalParameter> const parameters = EvalParameters::getParameters(engine.getEvaluationWeights());
+  std::unordered_map<void const *, int> indices;
+  std::vector<double> values = Texel::indexParameters(parameters, indices);
+
+  /* Lines without a result or without both kings are skipped, the capture of the second line is played out */
+  std::string const text = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1 [0.5]\n"
+                           "r1bqkbnr/pppp1ppp/2n5/4p3/3PP3/5N2/PPP2PPP/RNBQKB1R b KQkq d3 0 3 1-0\n"
+                           "this line has no position\n"
+                           "8/8/8/8/8/8/8/8 w - - 0 1 1-0\n"
+                           "8/5k2/8/8/3R4/8/5K2/8 w - - 0 1 [1.0]\n"
+                           "4k3/8/8/8/8/8/4P3/4K3 b - - 0 1 \"1/2-1/2\";\n"
+                           "r5k1/5ppp/8/8/8/2q5/5PPP/3R2K1 w - - 0 1 0-1";
+  Chunk chunk;
+  Texel::extractPositions(engine, text, 0, text.size(), indices, values, chunk);
+  chunk.gradient.assign(values.size(), 0.0);
+  std::vector<double> results;
+  for (auto const &position : chunk.positions)
+  {
+    results.push_back(position.result);
+  }
+  check(results == std::vector<double>({0.5, 1.0, 1.0, 0.5, 0.0}), "Texel extraction reads the positions and results of the lines");
+  check(chunk.numOfMismatches == 0, "Texel coefficients give back the evaluation of every position");
+
+  /* The gradient leaves out the factor 2 * K * ln(10) / 400 of the derivative of the error */
+  double const K = 1.0;
+  double const scale = 2 * K * std::log(10.0) / 400;
+  double const delta = 1e-3;
+  Texel::computeGradient(chunk, values, K);
+  bool isGradientCorrect = true;
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    double const value = values[i];
+    values[i] = value + delta;
+    Texel::computeError(chunk, values, K);
+    double const errorAbove = chunk.error;
+    values[i] = value - delta;
+    Texel::computeError(chunk, values, K);
+    double const errorBelow = chunk.error;
+    values[i] = value;
+    double const slope = (errorAbove - errorBelow) / (2 * delta);
+    isGradientCorrect = isGradientCorrect && std::abs(slope - scale * chunk.gradient[i]) <= 1e-9 + 1e-4 * std::abs(slope);
+  }
+  check(isGradientCorrect, "Texel gradient matches the slope of the error");
+
+  Texel::computeError(chunk, values, K);
+  double const initialError = chunk.error;
+  AdamOptimizer optimizer(values.size());
+  for (int step = 0; step < 20; step++)
+  {
+    Texel::computeGradient(chunk, values, K);
+    optimizer.step(values, chunk.gradient);
+  }
+  Texel::computeError(chunk, values, K);
+  check(chunk.error < initialError, "Texel descent steps lower the error");
+}
+
+void TestSuite::testMoveGeneration()
+{
+  /* The positions of the Chess Programming Wiki perft results, with castling, en passant and promotions */
+  struct PerftResult
+  {
+    std::string FEN;
+    int depth;
+    uint64_t numOfLeaves;
+  };
+  for (auto const &result : {PerftResult{STANDARD_OPENING_FEN, 4, 197281},
+                             PerftResult{"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq -", 3, 97862},
+                             PerftResult{"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - -", 5, 674624},
+                             PerftResult{"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq -", 4, 422333},
+                             PerftResult{"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ -", 4, 422333},
+                             PerftResult{"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ -", 3, 62379},
+                             PerftResult{"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - -", 3, 89890}})
+  {
+    Game game(result.FEN);
+    uint64_t const numOfLeaves = perft(game, result.depth);
+    check(numOfLeaves == result.numOfLeaves, "perft " + std::to_string(result.depth) + " of " + result.FEN + " is " + std::to_string(numOfLeaves) +
+                                                 ", expected " + std::to_string(result.numOfLeaves));
+  }
+
+  /* Exchanges on one position, with x-rays, en passant and promotions */
+  struct Exchange
+  {
+    std::string FEN;
+    std::string move;
+    int gain;
+  };
+  for (auto const &exchange : {Exchange{"1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - -", "e1e5", 100},
+                               Exchange{"1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - -", "d3e5", -200},
+                               Exchange{"4k3/8/3p4/4p3/3P4/8/8/4K3 w - -", "d4e5", 0},
+                               Exchange{"4k3/8/3p4/4p3/8/8/8/4Q1K1 w - -", "e1e5", -800},
+                               Exchange{"4k3/4r3/4r3/8/8/4R3/4R3/6K1 w - -", "e3e6", 500},
+                               Exchange{"4k3/8/8/3pP3/8/8/8/4K3 w - d6", "e5d6", 100},
+                               Exchange{"k7/4P3/8/8/8/8/8/K7 w - -", "e7e8q", 800},
+                               Exchange{"k3r3/3P4/8/8/8/8/8/K7 w - -", "d7e8n", 700}})
+  {
+    Game game(exchange.FEN);
+    Move move;
+    bool const isFound = findMove(game, exchange.move, move);
+    int const gain = isFound ? game.staticExchangeEvaluation(move) : 0;
+    check(isFound && gain == exchange.gain, "static exchange of " + exchange.move + " in " + exchange.FEN + " gains " + std::to_string(gain) +
+                                                ", expected " + std::to_string(exchange.gain));
+  }
+}
+
+bool TestSuite::runRegressionTests()
+{
+  numOfChecks = 0;
+  numOfFailedChecks = 0;
+  auto const start = std::chrono::steady_clock::now();
+
+  testBitbases();
+  testTablebases();
+  testPolyglotKeys();
+  testTexelTuning();
+  testMoveGeneration();
+
+  auto const end = std::chrono::steady_clock::now();
+  std::cout << "Regression tests: " << numOfChecks - numOfFailedChecks << " of " << numOfChecks << " checks passed in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl
+            << std::endl;
+  return numOfFailedChecks == 0;
+}
 
 void TestSuite::testPossiblePositions(Game game, int currentDepth, int totalDepth, std::unordered_map<int, int> &gameCounts, std::unordered_map<int, int> &checkmateCounts)
 {
@@ -28,6 +387,7 @@ void TestSuite::menu()
     std::string input;
     std::cout << ">> What would you like to do? (Input a letter)" << std::endl
               << "\"P\": Test number of possible positions in a given depth" << std::endl
+              << "\"R\": Run the regression tests" << std::endl
               << "\"C\": Close test menu" << std::endl
               << std::endl
               << std::endl;
@@ -79,6 +439,10 @@ void TestSuite::menu()
                   << std::endl;
         break;
       }
+      case 'R':
+      case 'r':
+        runRegressionTests();
+        break;
       case 'C':
       case 'c':
         return;
@@ -0,0 +1,220 @@
+#include "../include/texel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+namespace
+{
+  /**
+   * @brief reads the result of a line, as a PGN result or as [1.0], [0.5] or [0.0]
+   *
+   * @return true if the line has a result, otherwise false
+   */
+  bool parseResult(std::string const &line, double &result)
+  {
+    if (line.find("1/2-1/2") != std::string::npos || line.find("[0.5]") != std::string::npos)
+    {
+      result = 0.5;
+    }
+    else if (line.find("1-0") != std::string::npos || line.find("[1.0]") != std::string::npos)
+    {
+      result = 1.0;
+    }
+    else if (line.find("0-1") != std::string::npos || line.find("[0.0]") != std::string::npos)
+    {
+      result = 0.0;
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+  /**
+   * @brief the first four fields of a line, the board, turn, castling and en passant,
+   *          written into a buffer that is reused for every line
+   */
+  void parseFEN(std::string const &line, std::string &FENString)
+  {
+    FENString.clear();
+    size_t end = 0;
+    for (int i = 0; i < 4; i++)
+    {
+      size_t const begin = line.find_first_not_of(" \t\r", end);
+      if (begin == std::string::npos)
+      {
+        return;
+      }
+      end = std::min(line.find_first_of(" \t\r", begin), line.size());
+      if (i > 0)
+      {
+        FENString += ' ';
+      }
+      FENString.append(line, begin, end - begin);
+    }
+  }
+};
+
+AdamOptimizer::AdamOptimizer(size_t const numOfValues) : numOfSteps(0),
+                                                         momentum(numOfValues, 0.0),
+                                                         velocity(numOfValues, 0.0)
+{
+}
+
+void AdamOptimizer::step(std::vector<double> &values, std::vector<double> const &gradient)
+{
+  numOfSteps++;
+  for (size_t i = 0; i < values.size(); i++)
+  {
+    momentum[i] = TEXEL_BETA1 * momentum[i] + (1 - TEXEL_BETA1) * gradient[i];
+    velocity[i] = TEXEL_BETA2 * velocity[i] + (1 - TEXEL_BETA2) * gradient[i] * gradient[i];
+    double const momentumEstimate = momentum[i] / (1 - std::pow(TEXEL_BETA1, numOfSteps));
+    double const velocityEstimate = velocity[i] / (1 - std::pow(TEXEL_BETA2, numOfSteps));
+    values[i] -= TEXEL_LEARNING_RATE * momentumEstimate / (std::sqrt(velocityEstimate) + TEXEL_EPSILON);
+  }
+}
+
+namespace Texel
+{
+  std::vector<double> indexParameters(std::vector<EvalParameter> const &parameters, std::unordered_map<void const *, int> &indices)
+  {
+    std::vector<double> values(2 * parameters.size());
+    for (size_t i = 0; i < parameters.size(); i++)
+    {
+      indices[parameters[i].getAddress()] = i;
+      values[2 * i] = parameters[i].getMiddlegame();
+      values[2 * i + 1] = parameters[i].getEndgame();
+    }
+    return values;
+  }
+
+  void extractPositions(PlayerEngineMiniMax &engine, std::string const &text, size_t begin, size_t const end,
+                        std::unordered_map<void const *, int> const &indices, std::vector<double> const &parameters, Chunk &chunk)
+  {
+    /* The worker keeps one search thread, one set of hash tables and one line for all its positions */
+    auto thread = std::make_unique<SearchThread>();
+    PawnHashTable pawnHashTable(QUIET_POSITION_PAWN_HASH_SIZE_KB);
+    MaterialHashTable materialHashTable(QUIET_POSITION_MATERIAL_HASH_SIZE_KB);
+    thread->pawnHashTable = &pawnHashTable;
+    thread->materialHashTable = &materialHashTable;
+    auto trace = std::make_unique<EvalTrace>();
+    std::vector<int> sums(indices.size(), 0);
+    std::vector<int> touched;
+    std::string line;
+    std::string FENString;
+    while (begin < end)
+    {
+      size_t lineEnd = text.find('\n', begin);
+      if (lineEnd == std::string::npos || lineEnd > end)
+      {
+        lineEnd = end;
+      }
+      line.assign(text, begin, lineEnd - begin);
+      begin = lineEnd + 1;
+
+      double result;
+      if (!parseResult(line, result))
+      {
+        continue;
+      }
+      parseFEN(line, FENString);
+      Game game(FENString);
+      if (!game.getPieceBitboard(Piece::Type::WHITE_KING) || !game.getPieceBitboard(Piece::Type::BLACK_KING))
+      {
+        continue;
+      }
+
+      /* The evaluation is only meant for positions without pending captures */
+      Game quiet = engine.getQuietPosition(*thread, game);
+      if (quiet.isKingInCheck(quiet.getTurn()))
+      {
+        continue;
+      }
+      Score const score = engine.traceEvaluation(*thread, quiet, *trace);
+
+      TuningPosition position;
+      position.result = result;
+      position.phase = quiet.getPhase();
+      position.begin = chunk.coefficients.size();
+      for (int i = 0; i < trace->numOfEntries; i++)
+      {
+        EvalTrace::Entry const &entry = trace->entries[i];
+        auto const found = indices.find(entry.parameter);
+        if (found == indices.end())
+        {
+          continue;
+        }
+        if (sums[found->second] == 0)
+        {
+          touched.push_back(found->second);
+        }
+        sums[found->second] += entry.color == Piece::Color::WHITE ? entry.count : -entry.count;
+      }
+      for (int const index : touched)
+      {
+        if (sums[index] != 0)
+        {
+          chunk.coefficients.push_back({static_cast<uint16_t>(index), static_cast<int16_t>(sums[index])});
+        }
+        sums[index] = 0;
+      }
+      touched.clear();
+      position.count = chunk.coefficients.size() - position.begin;
+      chunk.positions.push_back(position);
+
+      /* The coefficients have to give back the evaluation, up to its rounding */
+      if (std::abs(evaluate(position, &chunk.coefficients[position.begin], parameters) - score) > 1.0)
+      {
+        chunk.numOfMismatches++;
+      }
+    }
+  }
+
+  double evaluate(TuningPosition const &position, Coefficient const *coefficients, std::vector<double> const &parameters)
+  {
+    double middlegame = 0;
+    double endgame = 0;
+    for (int i = 0; i < position.count; i++)
+    {
+      middlegame += coefficients[i].value * parameters[2 * coefficients[i].index];
+      endgame += coefficients[i].value * parameters[2 * coefficients[i].index + 1];
+    }
+    return (middlegame * position.phase + endgame * (PHASE_MAX - position.phase)) / PHASE_MAX;
+  }
+
+  double sigmoid(double const K, double const eval)
+  {
+    return 1.0 / (1.0 + std::pow(10.0, -K * eval / 400.0));
+  }
+
+  void computeError(Chunk &chunk, std::vector<double> const &parameters, double const K)
+  {
+    chunk.error = 0;
+    for (auto const &position : chunk.positions)
+    {
+      double const difference = position.result - sigmoid(K, evaluate(position, &chunk.coefficients[position.begin], parameters));
+      chunk.error += difference * difference;
+    }
+  }
+
+  void computeGradient(Chunk &chunk, std::vector<double> const &parameters, double const K)
+  {
+    std::fill(chunk.gradient.begin(), chunk.gradient.end(), 0.0);
+    for (auto const &position : chunk.positions)
+    {
+      Coefficient const *coefficients = &chunk.coefficients[position.begin];
+      double const prediction = sigmoid(K, evaluate(position, coefficients, parameters));
+      /* The constant factors of the derivative are left to the learning rate */
+      double const base = (prediction - position.result) * prediction * (1.0 - prediction);
+      double const middlegame = base * position.phase / PHASE_MAX;
+      double const endgame = base * (PHASE_MAX - position.phase) / PHASE_MAX;
+      for (int i = 0; i < position.count; i++)
+      {
+        chunk.gradient[2 * coefficients[i].index] += middlegame * coefficients[i].value;
+        chunk.gradient[2 * coefficients[i].index + 1] += endgame * coefficients[i].value;
+      }
+    }
+  }
+};
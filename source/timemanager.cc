@@ -0,0 +1,46 @@
+#include "../include/timemanager.h"
+
+#include <algorithm>
+
+TimeBudget TimeManager::allocate(TimeControl const &control, Piece::Color const color)
+{
+  int const index = Piece::getColorIndex(color);
+  int const movesToGo = control.movesToGo > 0 ? control.movesToGo : TIME_DEFAULT_MOVES_TO_GO;
+  int64_t const available = std::max<int64_t>(1, control.time[index] - TIME_MOVE_OVERHEAD);
+
+  /* The last move before the time control may use all of the time, other moves keep a reserve */
+  int64_t const maximum = movesToGo == 1 ? available : available * TIME_MAX_USAGE_PERCENT / 100;
+
+  int64_t const share = available / movesToGo + control.increment[index] * 3 / 4;
+
+  TimeBudget budget;
+  budget.hard = std::max<int64_t>(1, std::min(share * TIME_HARD_LIMIT_FACTOR, maximum));
+  budget.soft = std::min(std::max<int64_t>(1, share), budget.hard);
+  return budget;
+}
+
+void TimeManager::update(Move const &bestMove, Score const score)
+{
+  bool const isChanged = hasBestMove && !(bestMove == this->bestMove);
+  stableIterations = isChanged || !hasBestMove ? 0 : stableIterations + 1;
+  instability = instability / 2 + (isChanged ? 100 : 0);
+  scoreDrop = hasBestMove ? this->score - score : 0;
+
+  this->bestMove = bestMove;
+  this->score = score;
+  hasBestMove = true;
+}
+
+bool TimeManager::shouldStartIteration(int64_t const softTime, int64_t const elapsed) const
+{
+  int64_t scaled = softTime * (100 + instability * TIME_BEST_MOVE_CHANGE_PERCENT / 100) / 100;
+  if (stableIterations >= TIME_STABLE_ITERATIONS)
+  {
+    scaled = scaled * TIME_STABLE_PERCENT / 100;
+  }
+  if (scoreDrop >= TIME_SCORE_DROP)
+  {
+    scaled = scaled * TIME_SCORE_DROP_PERCENT / 100;
+  }
+  return elapsed < scaled * TIME_NEW_ITERATION_PERCENT / 100;
+}
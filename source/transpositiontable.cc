@@ -0,0 +1,124 @@
+#include "../include/transpositiontable.h"
+#include "../include/hashtable.h"
+
+#include <algorithm>
+
+TranspositionTable::TranspositionTable(size_t const sizeMB) : numOfSlots(0)
+{
+  resize(sizeMB);
+}
+
+void TranspositionTable::resize(size_t const sizeMB)
+{
+  numOfSlots = HashTables::floorPowerOfTwo((sizeMB * 1024 * 1024) / sizeof(Slot));
+  slots = std::make_unique<Slot[]>(numOfSlots);
+  clear();
+}
+
+void TranspositionTable::clear()
+{
+  for (size_t i = 0; i < numOfSlots; i++)
+  {
+    slots[i].keyXorData.store(0, std::memory_order_relaxed);
+    slots[i].data.store(0, std::memory_order_relaxed);
+  }
+}
+
+uint64_t TranspositionTable::packEntry(Move const &move, Score const score, int const depth, Bound const bound)
+{
+  /* from (7 bits) | to (7 bits) | piece (8 bits) | promotion (8 bits) | score (16 bits) | depth (8 bits) | bound (2 bits) */
+  uint64_t data = 0;
+  data |= static_cast<uint64_t>(static_cast<int>(move.from) & 0x7F);
+  data |= static_cast<uint64_t>(static_cast<int>(move.to) & 0x7F) << 7;
+  data |= static_cast<uint64_t>(static_cast<uint8_t>(move.piece)) << 14;
+  data |= static_cast<uint64_t>(static_cast<uint8_t>(move.promotionPiece)) << 22;
+  data |= static_cast<uint64_t>(static_cast<uint16_t>(static_cast<int16_t>(score))) << 30;
+  data |= static_cast<uint64_t>(static_cast<uint8_t>(std::max(0, std::min(depth, 255)))) << 46;
+  data |= static_cast<uint64_t>(bound) << 54;
+  return data;
+}
+
+TTEntry TranspositionTable::unpackEntry(uint64_t const data)
+{
+  TTEntry entry;
+  int const from = data & 0x7F;
+  int const to = (data >> 7) & 0x7F;
+  entry.move = Move(from == 0x7F ? -1 : from, to == 0x7F ? -1 : to,
+                    static_cast<Piece::Type>((data >> 14) & 0xFF),
+                    static_cast<Piece::Type>((data >> 22) & 0xFF));
+  entry.score = static_cast<int16_t>((data >> 30) & 0xFFFF);
+  entry.depth = (data >> 46) & 0xFF;
+  entry.bound = static_cast<Bound>((data >> 54) & 0x3);
+  return entry;
+}
+
+bool TranspositionTable::probe(uint64_t const key, int const ply, TTEntry &entry) const
+{
+  Slot const &slot = slots[key & (numOfSlots - 1)];
+  uint64_t const data = slot.data.load(std::memory_order_relaxed);
+  if ((slot.keyXorData.load(std::memory_order_relaxed) ^ data) != key || data == 0)
+  {
+    return false;
+  }
+
+  entry = unpackEntry(data);
+
+  /* Mate scores are stored relative to the position, convert them back to the root */
+  if (entry.score >= SCORE_MATE_IN_MAX_PLY)
+  {
+    entry.score -= ply;
+  }
+  else if (entry.score <= -SCORE_MATE_IN_MAX_PLY)
+  {
+    entry.score += ply;
+  }
+  return true;
+}
+
+void TranspositionTable::store(uint64_t const key, int const ply, Move const &move, Score const score, int const depth, Bound const bound)
+{
+  Slot &slot = slots[key & (numOfSlots - 1)];
+
+  /* Keep a deeper result of the same position unless the new one is exact */
+  uint64_t const oldData = slot.data.load(std::memory_order_relaxed);
+  bool const samePosition = (slot.keyXorData.load(std::memory_order_relaxed) ^ oldData) == key;
+  if (samePosition && bound != BOUND_EXACT && unpackEntry(oldData).depth > depth + 2)
+  {
+    return;
+  }
+
+  /* Keep the old move if the search did not find a best move for this position */
+  Move storedMove = move;
+  if (move.from == -1 && samePosition)
+  {
+    storedMove = unpackEntry(oldData).move;
+  }
+
+  Score storedScore = score;
+  if (score >= SCORE_MATE_IN_MAX_PLY)
+  {
+    storedScore += ply;
+  }
+  else if (score <= -SCORE_MATE_IN_MAX_PLY)
+  {
+    storedScore -= ply;
+  }
+
+  uint64_t const data = packEntry(storedMove, storedScore, depth, bound);
+  slot.keyXorData.store(key ^ data, std::memory_order_relaxed);
+  slot.data.store(data, std::memory_order_relaxed);
+}
+
+int TranspositionTable::getHashFull() const
+{
+  size_t const sample = std::min<size_t>(1000, numOfSlots);
+  int used = 0;
+  for (size_t i = 0; i < sample; i++)
+  {
+    if (slots[i].data.load(std::memory_order_relaxed) != 0)
+    {
+      used++;
+    }
+  }
+  return used * 1000 / sample;
+}
@@ -0,0 +1,330 @@
+#include "../include/uci.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+UCI::UCI() : engine(DEFAULT_MAX_DEPTH, 1), game(STANDARD_OPENING_FEN), stopSearch(false), isPondering(false), ownBook(true)
+{
+    engine.setInfoCallback([this](SearchLine const &line, uint64_t const nodes, int64_t const elapsed)
+                           { sendInfo(line, nodes, elapsed); });
+}
+
+UCI::~UCI()
+{
+    stopAndWait();
+}
+
+std::string UCI::moveToString(Move const &move)
+{
+    std::string notation = move.from.toChessNotation() + move.to.toChessNotation();
+    if (move.promotionPiece != Piece::Type::BLANK)
+    {
+        notation += static_cast<char>(std::tolower(Piece::pieceToChar(move.promotionPiece)));
+    }
+    return notation;
+}
+
+void UCI::run()
+{
+    std::string line;
+    while (std::getline(std::cin, line))
+    {
+        std::istringstream command(line);
+        std::string token;
+        command >> token;
+
+        if (token == "uci")
+        {
+            handleUCI();
+        }
+        else if (token == "isready")
+        {
+            send("readyok");
+        }
+        else if (token == "setoption")
+        {
+            handleSetOption(command);
+        }
+        else if (token == "ucinewgame")
+        {
+            stopAndWait();
+            engine.clearHashTables();
+        }
+        else if (token == "position")
+        {
+            handlePosition(command);
+        }
+        else if (token == "go")
+        {
+            handleGo(command);
+        }
+        else if (token == "ponderhit")
+        {
+            isPondering = false;
+        }
+        else if (token == "stop")
+        {
+            stopAndWait();
+        }
+        else if (token == "quit")
+        {
+            break;
+        }
+        else if (!token.empty())
+        {
+            logIt(LogLevel::WARNING) << "Unknown UCI command: " << line;
+        }
+    }
+    stopAndWait();
+}
+
+void UCI::send(std::string const &line)
+{
+    std::lock_guard<std::mutex> lock(outputMutex);
+    std::cout << line << std::endl;
+}
+
+void UCI::handleUCI()
+{
+    send("id name " UCI_ENGINE_NAME);
+    send("id author " UCI_ENGINE_AUTHOR);
+    send("option name Hash type spin default " + std::to_string(DEFAULT_HASH_SIZE_MB) + " min 1 max " + std::to_string(UCI_MAX_HASH_SIZE_MB));
+    send("option name Threads type spin default 1 min 1 max " + std::to_string(UCI_MAX_THREADS));
+    send("option name Ponder type check default false");
+    send("option name OwnBook type check default true");
+    send("option name BookFile type string default " DEFAULT_BOOK_FILE);
+    send("uciok");
+}
+
+void UCI::handleSetOption(std::istringstream &command)
+{
+    /* setoption name <name> value <value> */
+    std::string token;
+    std::string name;
+    std::string value;
+    command >> token >> name >> token >> value;
+
+    /* The options can not change under a running search */
+    stopAndWait();
+    if (name == "Hash")
+    {
+        engine.setHashSize(std::clamp(std::atoi(value.c_str()), 1, UCI_MAX_HASH_SIZE_MB));
+    }
+    else if (name == "Threads")
+    {
+        engine.setNumThreads(std::clamp(std::atoi(value.c_str()), 1, UCI_MAX_THREADS));
+    }
+    else if (name == "OwnBook")
+    {
+        ownBook = value == "true";
+    }
+    else if (name == "BookFile")
+    {
+        /* A path may contain spaces */
+        std::string rest;
+        std::getline(command, rest);
+        engine.loadBook(value + rest);
+    }
+    else if (name == "Ponder")
+    {
+        /* Pondering is started by the GUI with go ponder, there is nothing to set up */
+    }
+    else
+    {
+        logIt(LogLevel::WARNING) << "Unknown UCI option: " << name;
+    }
+}
+
+void UCI::handlePosition(std::istringstream &command)
+{
+    stopAndWait();
+
+    std::string token;
+    command >> token;
+    if (token == "startpos")
+    {
+        game = Game(STANDARD_OPENING_FEN);
+        command >> token;
+    }
+    else if (token == "fen")
+    {
+        std::string FENString;
+        while (command >> token && token != "moves")
+        {
+            FENString += (FENString.empty() ? "" : " ") + token;
+        }
+        game = Game(FENString);
+    }
+    else
+    {
+        logIt(LogLevel::WARNING) << "Invalid UCI position command";
+        return;
+    }
+
+    if (token != "moves")
+    {
+        return;
+    }
+    while (command >> token)
+    {
+        Move move;
+        if (!parseMove(token, move))
+        {
+            logIt(LogLevel::WARNING) << "Illegal UCI move: " << token;
+            return;
+        }
+        game.makeMove(move);
+    }
+}
+
+void UCI::handleGo(std::istringstream &command)
+{
+    stopAndWait();
+    if (game.getAllLegalMoves().empty())
+    {
+        send("bestmove 0000");
+        return;
+    }
+
+    SearchLimits limits;
+    TimeControl control;
+    bool isInfinite = false;
+    bool ponder = false;
+    std::string token;
+    while (command >> token)
+    {
+        if (token == "depth")
+        {
+            command >> limits.depth;
+        }
+        else if (token == "movetime")
+        {
+            command >> limits.moveTime;
+        }
+        else if (token == "nodes")
+        {
+            command >> limits.nodes;
+        }
+        else if (token == "wtime")
+        {
+            command >> control.time[0];
+        }
+        else if (token == "btime")
+        {
+            command >> control.time[1];
+        }
+        else if (token == "winc")
+        {
+            command >> control.increment[0];
+        }
+        else if (token == "binc")
+        {
+            command >> control.increment[1];
+        }
+        else if (token == "movestogo")
+        {
+            command >> control.movesToGo;
+        }
+        else if (token == "infinite")
+        {
+            isInfinite = true;
+        }
+        else if (token == "ponder")
+        {
+            ponder = true;
+        }
+    }
+
+    /* A book move is played at once, unless the GUI waits for a stop or a ponderhit */
+    Move bookMove;
+    if (ownBook && !isInfinite && !ponder && engine.probeBook(game, bookMove))
+    {
+        send("bestmove " + moveToString(bookMove));
+        return;
+    }
+
+    /* A fixed move time takes precedence over the clock */
+    if (limits.moveTime == 0 && control.time[Piece::getColorIndex(game.getTurn())] > 0)
+    {
+        TimeBudget const budget = TimeManager::allocate(control, game.getTurn());
+        limits.moveTime = budget.hard;
+        limits.softTime = budget.soft;
+    }
+    if (limits.depth == 0 && limits.moveTime == 0 && limits.nodes == 0)
+    {
+        isInfinite = true;
+    }
+    if (limits.depth == 0)
+    {
+        limits.depth = MAX_PLY - 1;
+    }
+
+    stopSearch = false;
+    isPondering = ponder;
+    limits.stop = &stopSearch;
+    limits.ponder = &isPondering;
+    searchThread = std::thread([this, limits, isInfinite]()
+                               {
+        SearchLine const line = engine.searchWithLimits(game, limits);
+
+        /* An infinite search only reports its move when it is stopped, a ponder search not before ponderhit */
+        while ((isInfinite || isPondering.load()) && !stopSearch.load())
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::string bestMove = "bestmove " + moveToString(line.pv[0]);
+        if (line.pv.size() > 1)
+        {
+            bestMove += " ponder " + moveToString(line.pv[1]);
+        }
+        send(bestMove); });
+}
+
+void UCI::stopAndWait()
+{
+    stopSearch = true;
+    isPondering = false;
+    if (searchThread.joinable())
+    {
+        searchThread.join();
+    }
+}
+
+bool UCI::parseMove(std::string const &notation, Move &move)
+{
+    for (auto const &legalMove : game.getAllLegalMoves())
+    {
+        if (moveToString(legalMove) == notation)
+        {
+            move = legalMove;
+            return true;
+        }
+    }
+    return false;
+}
+
+void UCI::sendInfo(SearchLine const &line, uint64_t const nodes, int64_t const elapsed)
+{
+    std::ostringstream info;
+    info << "info depth " << line.depth << " score ";
+    if (line.score >= SCORE_MATE_IN_MAX_PLY)
+    {
+        info << "mate " << (SCORE_MATE - line.score + 1) / 2;
+    }
+    else if (line.score <= -SCORE_MATE_IN_MAX_PLY)
+    {
+        info << "mate -" << (SCORE_MATE + line.score) / 2;
+    }
+    else
+    {
+        info << "cp " << line.score;
+    }
+    info << " nodes " << nodes << " nps " << nodes * 1000 / std::max<int64_t>(1, elapsed) << " time " << elapsed
+         << " hashfull " << engine.getHashFull() << " pv";
+    for (auto const &move : line.pv)
+    {
+        info << " " << moveToString(move);
+    }
+    send(info.str());
+}
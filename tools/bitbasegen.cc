@@ -0,0 +1,148 @@
+#include "../include/bitbase.h"
+#include "../include/endgame.h"
+#include "../include/logger.h"
+#include "../include/piecesquaretable.h"
+#include "../include/tablebase.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <set>
+#include <thread>
+
+/* positions checked against the rules of Game per bitbase, bigger bitbases are sampled evenly */
+#define BITBASE_DEFAULT_VERIFY_POSITIONS (1 << 20)
+
+namespace
+{
+  /**
+   * @brief adds a signature to the ones to generate after the signatures of the
+   *          material its captures and promotions lead to
+   */
+  void addSignature(std::string const &signature, std::vector<std::string> &signatures, std::set<uint64_t> &materialKeys)
+  {
+    if (!materialKeys.insert(Endgames::materialKeyOf(signature)).second)
+    {
+      return;
+    }
+    for (auto const &subtableSignature : Bitbase(signature).getSubtableSignatures())
+    {
+      addSignature(subtableSignature, signatures, materialKeys);
+    }
+    signatures.push_back(signature);
+  }
+
+  /**
+   * @brief verifies evenly spread positions of a bitbase in parallel
+   *
+   * @return number of positions that do not match the search
+   */
+  size_t verify(Bitbase const &bitbase, std::vector<Bitbase const *> const &bitbases, int const numThreads, size_t const maxPositions)
+  {
+    size_t const step = std::max<size_t>(1, bitbase.getNumOfPositions() / std::max<size_t>(1, maxPositions));
+    std::atomic<size_t> nextIndex(0);
+    std::atomic<size_t> numOfErrors(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; i++)
+    {
+      threads.emplace_back([&]()
+                           {
+        size_t index;
+        while ((index = nextIndex.fetch_add(step)) < bitbase.getNumOfPositions())
+        {
+          if (!bitbase.verifyPosition(index, bitbases))
+          {
+            numOfErrors++;
+          }
+        } });
+    }
+    for (auto &thread : threads)
+    {
+      thread.join();
+    }
+    return numOfErrors;
+  }
+};
+
+int main(int argc, char *argv[])
+{
+  PieceSquareTable::init();
+
+  std::string const directory = argc > 1 ? argv[1] : DEFAULT_BITBASE_DIRECTORY;
+  int const numThreads = std::max(1, argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency()));
+  size_t const maxVerifyPositions = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : BITBASE_DEFAULT_VERIFY_POSITIONS;
+
+  /* Signatures past the options are generated on top of the bitbases of the evaluation */
+  std::vector<std::string> requested = Bitbases::getSignatures();
+  for (int i = 4; i < argc; i++)
+  {
+    if (!Bitbases::isValidSignature(argv[i]))
+    {
+      std::cerr << "usage: " << argv[0] << " [directory] [threads] [positions to verify] [signatures such as KRPK...]" << std::endl;
+      return 1;
+    }
+    requested.push_back(argv[i]);
+  }
+
+  std::error_code error;
+  std::filesystem::create_directories(directory, error);
+  if (error)
+  {
+    logIt(LogLevel::ERROR) << "Could not create " << directory << ": " << error.message();
+    return 1;
+  }
+
+  /* The bitbases that captures and promotions lead to are generated first */
+  std::vector<std::string> signatures;
+  std::set<uint64_t> materialKeys;
+  for (auto const &signature : requested)
+  {
+    addSignature(signature, signatures, materialKeys);
+  }
+
+  std::vector<std::unique_ptr<Bitbase>> bitbases;
+  std::vector<Bitbase const *> generated;
+  size_t numOfErrors = 0;
+  for (auto const &signature : signatures)
+  {
+    auto bitbase = std::make_unique<Bitbase>(signature);
+    auto const start = std::chrono::steady_clock::now();
+    bitbase->generate(numThreads, generated);
+    auto const generateTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    size_t numOfWins = 0;
+    int maxDistanceToMate = 0;
+    for (size_t index = 0; index < bitbase->getNumOfPositions(); index++)
+    {
+      numOfWins += bitbase->isWon(index);
+      maxDistanceToMate = std::max(maxDistanceToMate, bitbase->getDistanceToMate(index));
+    }
+    generated.push_back(bitbase.get());
+
+    auto const verifyStart = std::chrono::steady_clock::now();
+    size_t const numOfBitbaseErrors = verify(*bitbase, generated, numThreads, maxVerifyPositions);
+    auto const verifyTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - verifyStart).count();
+    numOfErrors += numOfBitbaseErrors;
+
+    std::string const path = Bitbases::getPath(directory, signature);
+    std::string const tablebasePath = Tablebases::getPath(directory, signature);
+    if (!bitbase->save(path) || !Tablebase::write(tablebasePath, *bitbase))
+    {
+      return 1;
+    }
+    logIt(LogLevel::INFO) << "Generated " << path << " and " << tablebasePath << ": " << bitbase->getNumOfPositions() << " positions, "
+                          << numOfWins << " won, longest mate " << maxDistanceToMate << " plies, in " << generateTime << "ms, "
+                          << numOfBitbaseErrors << " errors verifying in " << verifyTime << "ms";
+    bitbases.push_back(std::move(bitbase));
+  }
+
+  if (numOfErrors > 0)
+  {
+    logIt(LogLevel::ERROR) << numOfErrors << " positions do not match the search";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,660 @@
+#include "../include/game.h"
+#include "../include/openingbook.h"
+#include "../include/logger.h"
+#include "../include/piecesquaretable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#define BOOK_BUILDER_DEFAULT_OUTPUT DEFAULT_BOOK_FILE
+#define BOOK_BUILDER_DEFAULT_PLIES 24
+#define BOOK_BUILDER_DEFAULT_MIN_GAMES 3
+
+/* streaming, the file is read in blocks and handed to the workers in batches of whole games */
+#define BOOK_BUILDER_READ_SIZE (1 << 20)
+#define BOOK_BUILDER_BATCH_SIZE (1 << 20)
+#define BOOK_BUILDER_BATCHES_PER_THREAD 2
+#define BOOK_BUILDER_LOG_INTERVAL_MB 256
+
+/* the counts are kept in shards by the top byte of the key, so the shards are sorted ranges of keys */
+#define BOOK_BUILDER_NUM_OF_SHARDS 256
+#define BOOK_BUILDER_DEFAULT_MAX_ENTRIES (16 * 1024 * 1024)
+
+/**
+ * @brief a move played in a position
+ */
+struct BookKey
+{
+  uint64_t key;
+  uint16_t move;
+
+  bool operator==(BookKey const &other) const
+  {
+    return key == other.key && move == other.move;
+  }
+};
+
+struct BookKeyHash
+{
+  size_t operator()(BookKey const &bookKey) const
+  {
+    return bookKey.key ^ (static_cast<uint64_t>(bookKey.move) * 0x9E3779B97F4A7C15ULL);
+  }
+};
+
+/**
+ * @brief results of the games a move was played in, from the point of view of the player that played it
+ */
+struct BookCounts
+{
+  uint32_t wins = 0;
+  uint32_t draws = 0;
+  uint32_t losses = 0;
+
+  uint32_t getNumOfGames() const
+  {
+    return wins + draws + losses;
+  }
+};
+
+/**
+ * @brief counts of the keys in one range, with a lock so all workers can add to it
+ */
+struct Shard
+{
+  std::mutex mutex;
+  std::unordered_map<BookKey, BookCounts, BookKeyHash> counts;
+  uint64_t numOfPruned = 0;
+};
+
+/**
+ * @brief queue of batches of games between the reader and the workers, the reader
+ *          waits when it is full so at most a few batches are in memory
+ */
+class BatchQueue
+{
+public:
+  BatchQueue(size_t const capacity) : capacity(capacity), isClosed(false) {}
+
+  void push(std::string &&batch)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    notFull.wait(lock, [this]()
+                 { return batches.size() < capacity; });
+    batches.push_back(std::move(batch));
+    notEmpty.notify_one();
+  }
+
+  /**
+   * @brief takes the next batch
+   *
+   * @return true if a batch is taken, false if the queue is closed and empty
+   */
+  bool pop(std::string &batch)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    notEmpty.wait(lock, [this]()
+                  { return !batches.empty() || isClosed; });
+    if (batches.empty())
+    {
+      return false;
+    }
+    batch = std::move(batches.front());
+    batches.pop_front();
+    notFull.notify_one();
+    return true;
+  }
+
+  void close()
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    isClosed = true;
+    notEmpty.notify_all();
+  }
+
+private:
+  size_t const capacity;
+  bool isClosed;
+  std::deque<std::string> batches;
+  std::mutex mutex;
+  std::condition_variable notFull;
+  std::condition_variable notEmpty;
+};
+
+/**
+ * @brief settings and shared state of a build
+ */
+struct BookBuilder
+{
+  int maxPlies = BOOK_BUILDER_DEFAULT_PLIES;
+  size_t maxEntriesPerShard = BOOK_BUILDER_DEFAULT_MAX_ENTRIES / BOOK_BUILDER_NUM_OF_SHARDS;
+  std::vector<Shard> shards = std::vector<Shard>(BOOK_BUILDER_NUM_OF_SHARDS);
+
+  std::atomic<uint64_t> numOfGames{0};
+  std::atomic<uint64_t> numOfSkippedGames{0};
+};
+
+namespace
+{
+  /**
+   * @brief finds the legal move of a game for a move in standard algebraic notation,
+   *          such as e4, exd5, Nbd7, R1e2, e8=Q or O-O
+   *
+   * @return true if the notation is a legal move, otherwise false
+   */
+  bool parseSAN(Game &game, std::string san, Move &move)
+  {
+    while (!san.empty() && std::string("+#!?").find(san.back()) != std::string::npos)
+    {
+      san.pop_back();
+    }
+    if (san.size() < 2)
+    {
+      return false;
+    }
+    std::vector<Move> const legalMoves = game.getAllLegalMoves();
+
+    if (san == "O-O" || san == "0-0" || san == "O-O-O" || san == "0-0-0")
+    {
+      int const step = san.size() == 3 ? 2 : -2;
+      for (auto const &legalMove : legalMoves)
+      {
+        if (Piece::getPieceTypeWithoutColor(legalMove.piece) == Piece::Type::KING && legalMove.to - legalMove.from == step)
+        {
+          move = legalMove;
+          return true;
+        }
+      }
+      return false;
+    }
+
+    Piece::Type promotion = Piece::Type::BLANK;
+    size_t const equals = san.find('=');
+    char const promotionChar = equals != std::string::npos && equals + 1 < san.size() ? san[equals + 1] : (std::isdigit(san[san.size() - 2]) && std::isupper(san.back()) ? san.back() : 0);
+    if (promotionChar)
+    {
+      san = san.substr(0, equals != std::string::npos ? equals : san.size() - 1);
+    }
+
+    Piece::Type type = Piece::Type::PAWN;
+    size_t begin = 0;
+    switch (san[0])
+    {
+    case 'N':
+      type = Piece::Type::KNIGHT;
+      begin = 1;
+      break;
+    case 'B':
+      type = Piece::Type::BISHOP;
+      begin = 1;
+      break;
+    case 'R':
+      type = Piece::Type::ROOK;
+      begin = 1;
+      break;
+    case 'Q':
+      type = Piece::Type::QUEEN;
+      begin = 1;
+      break;
+    case 'K':
+      type = Piece::Type::KING;
+      begin = 1;
+      break;
+    default:
+      break;
+    }
+    switch (promotionChar)
+    {
+    case 'N':
+      promotion = Piece::Type::KNIGHT;
+      break;
+    case 'B':
+      promotion = Piece::Type::BISHOP;
+      break;
+    case 'R':
+      promotion = Piece::Type::ROOK;
+      break;
+    case 'Q':
+      promotion = Piece::Type::QUEEN;
+      break;
+    default:
+      break;
+    }
+
+    san.erase(std::remove(san.begin(), san.end(), 'x'), san.end());
+    if (san.size() < begin + 2)
+    {
+      return false;
+    }
+    int const toColumn = san[san.size() - 2] - 'a';
+    int const toRow = san[san.size() - 1] - '1';
+    if (toColumn < 0 || toColumn >= BOARD_LENGTH || toRow < 0 || toRow >= BOARD_LENGTH)
+    {
+      return false;
+    }
+    int const to = toRow * BOARD_LENGTH + toColumn;
+
+    /* Disambiguation by the file and/or row the piece comes from */
+    int fromColumn = -1;
+    int fromRow = -1;
+    for (size_t i = begin; i + 2 < san.size(); i++)
+    {
+      if (san[i] >= 'a' && san[i] <= 'h')
+      {
+        fromColumn = san[i] - 'a';
+      }
+      else if (san[i] >= '1' && san[i] <= '8')
+      {
+        fromRow = san[i] - '1';
+      }
+    }
+
+    for (auto const &legalMove : legalMoves)
+    {
+      if (Piece::getPieceTypeWithoutColor(legalMove.piece) == type && legalMove.to == to &&
+          Piece::getPieceTypeWithoutColor(legalMove.promotionPiece) == promotion &&
+          (fromColumn < 0 || legalMove.from % BOARD_LENGTH == fromColumn) &&
+          (fromRow < 0 || legalMove.from / BOARD_LENGTH == fromRow))
+      {
+        move = legalMove;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  /**
+   * @brief splits movetext into its moves, without move numbers, comments, variations,
+   *          annotations and the result
+   */
+  std::vector<std::string> tokenizeMovetext(std::string const &movetext)
+  {
+    std::vector<std::string> tokens;
+    std::string token;
+    int variationDepth = 0;
+    bool isInComment = false;
+    bool isInLineComment = false;
+    auto const flush = [&tokens, &token]()
+    {
+      /* Move numbers such as 12. or 12... end with a dot, results start with a digit or * */
+      size_t const dot = token.find_last_of('.');
+      if (dot != std::string::npos)
+      {
+        token = token.substr(dot + 1);
+      }
+      if (!token.empty() && token[0] != '$' && token[0] != '*' && !std::isdigit(token[0]))
+      {
+        tokens.push_back(token);
+      }
+      token.clear();
+    };
+
+    for (char const c : movetext)
+    {
+      if (isInLineComment)
+      {
+        isInLineComment = c != '\n';
+      }
+      else if (isInComment)
+      {
+        isInComment = c != '}';
+      }
+      else if (c == '{')
+      {
+        flush();
+        isInComment = true;
+      }
+      else if (c == ';')
+      {
+        flush();
+        isInLineComment = true;
+      }
+      else if (c == '(')
+      {
+        flush();
+        variationDepth++;
+      }
+      else if (c == ')')
+      {
+        token.clear();
+        variationDepth = std::max(0, variationDepth - 1);
+      }
+      else if (variationDepth > 0)
+      {
+        continue;
+      }
+      else if (std::isspace(static_cast<unsigned char>(c)))
+      {
+        flush();
+      }
+      else
+      {
+        token += c;
+      }
+    }
+    flush();
+    return tokens;
+  }
+
+  /**
+   * @brief reads the value of a tag pair line such as [Result "1-0"]
+   */
+  std::string getTagValue(std::string const &line)
+  {
+    size_t const begin = line.find('"');
+    size_t const end = line.rfind('"');
+    return begin != std::string::npos && end > begin ? line.substr(begin + 1, end - begin - 1) : "";
+  }
+
+  /**
+   * @brief drops the rarest entries of a shard until it is well below its limit,
+   *          a move that is rare this far into the corpus is unlikely to make the book
+   */
+  void pruneShard(Shard &shard, size_t const maxEntries)
+  {
+    for (uint32_t minGames = 2; shard.counts.size() > maxEntries * 3 / 4; minGames++)
+    {
+      for (auto it = shard.counts.begin(); it != shard.counts.end();)
+      {
+        if (it->second.getNumOfGames() < minGames)
+        {
+          it = shard.counts.erase(it);
+          shard.numOfPruned++;
+        }
+        else
+        {
+          it++;
+        }
+      }
+    }
+  }
+
+  /**
+   * @brief replays one game up to the maximum plies and counts its result for every move
+   */
+  void addGame(BookBuilder &builder, std::string const &text)
+  {
+    std::string result;
+    std::string FEN = STANDARD_OPENING_FEN;
+    std::string movetext;
+    size_t begin = 0;
+    while (begin < text.size())
+    {
+      size_t end = text.find('\n', begin);
+      end = end == std::string::npos ? text.size() : end;
+      std::string const line = text.substr(begin, end - begin);
+      if (!line.empty() && line[0] == '[')
+      {
+        if (line.rfind("[Result ", 0) == 0)
+        {
+          result = getTagValue(line);
+        }
+        else if (line.rfind("[FEN ", 0) == 0)
+        {
+          FEN = getTagValue(line);
+        }
+      }
+      else
+      {
+        movetext += line;
+        movetext += '\n';
+      }
+      begin = end + 1;
+    }
+
+    /* Only decided games and draws count, unfinished games have no result to learn from */
+    int whiteResult;
+    if (result == "1-0")
+    {
+      whiteResult = 1;
+    }
+    else if (result == "0-1")
+    {
+      whiteResult = -1;
+    }
+    else if (result == "1/2-1/2")
+    {
+      whiteResult = 0;
+    }
+    else
+    {
+      builder.numOfSkippedGames++;
+      return;
+    }
+
+    Game game(FEN);
+    int ply = 0;
+    for (auto const &san : tokenizeMovetext(movetext))
+    {
+      if (ply >= builder.maxPlies)
+      {
+        break;
+      }
+      Move move;
+      if (!parseSAN(game, san, move))
+      {
+        logIt(LogLevel::DEBUG) << "Illegal move " << san << " at ply " << ply << ", the rest of the game is skipped";
+        break;
+      }
+
+      BookKey const bookKey = {OpeningBook::getKey(game), OpeningBook::encodeMove(move)};
+      int const moverResult = game.getTurn() == Piece::Color::WHITE ? whiteResult : -whiteResult;
+      Shard &shard = builder.shards[bookKey.key >> 56];
+      {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        BookCounts &counts = shard.counts[bookKey];
+        counts.wins += moverResult > 0;
+        counts.draws += moverResult == 0;
+        counts.losses += moverResult < 0;
+        if (shard.counts.size() > builder.maxEntriesPerShard)
+        {
+          pruneShard(shard, builder.maxEntriesPerShard);
+        }
+      }
+
+      game.makeMove(move);
+      ply++;
+    }
+    builder.numOfGames++;
+  }
+
+  /**
+   * @brief adds the games of batches until the queue is closed
+   */
+  void work(BookBuilder &builder, BatchQueue &queue)
+  {
+    std::string batch;
+    while (queue.pop(batch))
+    {
+      size_t begin = 0;
+      while (begin < batch.size())
+      {
+        size_t end = batch.find("\n[Event ", begin);
+        end = end == std::string::npos ? batch.size() : end + 1;
+        addGame(builder, batch.substr(begin, end - begin));
+        begin = end;
+      }
+    }
+  }
+
+  void writeBigEndian(std::ofstream &file, uint64_t const value, int const numOfBytes)
+  {
+    for (int i = numOfBytes - 1; i >= 0; i--)
+    {
+      file.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+  }
+
+  /**
+   * @brief turns the counts of a shard into book entries sorted by key, the weight of
+   *          a move is its score in half points (two per win, one per draw), scaled down
+   *          if needed so the weights of a position fit in 16 bits
+   */
+  std::vector<BookEntry> getShardEntries(Shard &shard, uint32_t const minGames)
+  {
+    struct ScoredEntry
+    {
+      BookKey bookKey;
+      uint64_t score;
+    };
+    std::vector<ScoredEntry> scoredEntries;
+    for (auto const &[bookKey, counts] : shard.counts)
+    {
+      uint64_t const score = 2ULL * counts.wins + counts.draws;
+      if (counts.getNumOfGames() >= minGames && score > 0)
+      {
+        scoredEntries.push_back({bookKey, score});
+      }
+    }
+    shard.counts.clear();
+    std::sort(scoredEntries.begin(), scoredEntries.end(), [](ScoredEntry const &a, ScoredEntry const &b)
+              { return a.bookKey.key != b.bookKey.key ? a.bookKey.key < b.bookKey.key : a.score > b.score; });
+
+    std::vector<BookEntry> entries;
+    entries.reserve(scoredEntries.size());
+    for (size_t begin = 0; begin < scoredEntries.size();)
+    {
+      size_t end = begin;
+      while (end < scoredEntries.size() && scoredEntries[end].bookKey.key == scoredEntries[begin].bookKey.key)
+      {
+        end++;
+      }
+      /* The first move of a position has the highest score */
+      uint64_t const maxScore = scoredEntries[begin].score;
+      for (size_t i = begin; i < end; i++)
+      {
+        uint64_t const weight = maxScore > UINT16_MAX ? std::max<uint64_t>(1, scoredEntries[i].score * UINT16_MAX / maxScore) : scoredEntries[i].score;
+        entries.push_back({scoredEntries[i].bookKey.key, scoredEntries[i].bookKey.move, static_cast<uint16_t>(weight), 0});
+      }
+      begin = end;
+    }
+    return entries;
+  }
+};
+
+int main(int argc, char *argv[])
+{
+  PieceSquareTable::init();
+
+  if (argc < 2)
+  {
+    std::cerr << "usage: " << argv[0] << " <pgn> [output] [plies] [threads] [min games] [max entries]" << std::endl;
+    return 1;
+  }
+  std::string const outputPath = argc > 2 ? argv[2] : BOOK_BUILDER_DEFAULT_OUTPUT;
+  int const numThreads = std::max(1, argc > 4 ? std::atoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency()));
+  uint32_t const minGames = std::max(1, argc > 5 ? std::atoi(argv[5]) : BOOK_BUILDER_DEFAULT_MIN_GAMES);
+
+  BookBuilder builder;
+  builder.maxPlies = argc > 3 ? std::atoi(argv[3]) : BOOK_BUILDER_DEFAULT_PLIES;
+  if (argc > 6)
+  {
+    builder.maxEntriesPerShard = std::max<size_t>(1, std::strtoull(argv[6], nullptr, 10) / BOOK_BUILDER_NUM_OF_SHARDS);
+  }
+
+  std::ifstream file(argv[1], std::ios::binary);
+  if (!file)
+  {
+    logIt(LogLevel::ERROR) << "Could not read PGN file " << argv[1];
+    return 1;
+  }
+
+  BatchQueue queue(BOOK_BUILDER_BATCHES_PER_THREAD * numThreads);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < numThreads; i++)
+  {
+    workers.emplace_back(work, std::ref(builder), std::ref(queue));
+  }
+
+  /* Stream the file, a batch ends before the last game that may not be read completely */
+  auto const start = std::chrono::steady_clock::now();
+  std::string buffer;
+  std::vector<char> block(BOOK_BUILDER_READ_SIZE);
+  uint64_t numOfBytesRead = 0;
+  uint64_t nextLog = static_cast<uint64_t>(BOOK_BUILDER_LOG_INTERVAL_MB) << 20;
+  while (file.read(block.data(), block.size()) || file.gcount() > 0)
+  {
+    buffer.append(block.data(), file.gcount());
+    numOfBytesRead += file.gcount();
+    if (buffer.size() >= BOOK_BUILDER_BATCH_SIZE)
+    {
+      size_t const boundary = buffer.rfind("\n[Event ");
+      if (boundary != std::string::npos && boundary > 0)
+      {
+        std::string rest = buffer.substr(boundary + 1);
+        buffer.resize(boundary + 1);
+        queue.push(std::move(buffer));
+        buffer = std::move(rest);
+      }
+    }
+    if (numOfBytesRead >= nextLog)
+    {
+      logIt(LogLevel::INFO) << "Read " << (numOfBytesRead >> 20) << " MB, " << builder.numOfGames << " games";
+      nextLog += static_cast<uint64_t>(BOOK_BUILDER_LOG_INTERVAL_MB) << 20;
+    }
+  }
+  if (!buffer.empty())
+  {
+    queue.push(std::move(buffer));
+  }
+  queue.close();
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+
+  /* The shards are converted in parallel and written in order, which sorts the book by key */
+  std::vector<std::vector<BookEntry>> shardEntries(BOOK_BUILDER_NUM_OF_SHARDS);
+  std::vector<std::thread> converters;
+  uint64_t numOfPruned = 0;
+  for (auto const &shard : builder.shards)
+  {
+    numOfPruned += shard.numOfPruned;
+  }
+  for (int i = 0; i < numThreads; i++)
+  {
+    converters.emplace_back([&builder, &shardEntries, minGames, numThreads, i]()
+                            {
+      for (int shard = i; shard < BOOK_BUILDER_NUM_OF_SHARDS; shard += numThreads)
+      {
+        shardEntries[shard] = getShardEntries(builder.shards[shard], minGames);
+      } });
+  }
+  for (auto &converter : converters)
+  {
+    converter.join();
+  }
+
+  std::ofstream output(outputPath, std::ios::binary);
+  if (!output)
+  {
+    logIt(LogLevel::ERROR) << "Could not write book file " << outputPath;
+    return 1;
+  }
+  uint64_t numOfEntries = 0;
+  for (auto const &entries : shardEntries)
+  {
+    for (auto const &entry : entries)
+    {
+      writeBigEndian(output, entry.key, 8);
+      writeBigEndian(output, entry.move, 2);
+      writeBigEndian(output, entry.weight, 2);
+      writeBigEndian(output, entry.learn, 4);
+    }
+    numOfEntries += entries.size();
+  }
+
+  auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+  logIt(LogLevel::INFO) << "Built " << outputPath << " with " << numOfEntries << " entries from " << builder.numOfGames << " games ("
+                        << builder.numOfSkippedGames << " without a result skipped, " << numOfPruned << " rare entries pruned) in " << elapsed << "ms";
+  return 0;
+}
@@ -0,0 +1,363 @@
+#include "../include/game.h"
+#include "../include/playerenginerandom.h"
+#include "../include/logger.h"
+#include "../include/piecesquaretable.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#define RANDOM_GAMES_DEFAULT_SEED 1
+#define RANDOM_GAMES_DEFAULT_MAX_PLIES 1024
+#define RANDOM_GAMES_DEFAULT_POSITIONS_PER_GAME 1
+
+/* games a thread takes at a time, small enough to keep the threads busy until the end */
+#define RANDOM_GAMES_CHUNK_SIZE 256
+
+/* the positions of a thread are written once its buffer reaches this size */
+#define RANDOM_GAMES_WRITE_SIZE (1 << 20)
+#define RANDOM_GAMES_MAX_REPORTED_ERRORS 10
+
+/* plies without a capture or a pawn move that draw a game */
+#define FIFTY_MOVE_RULE_PLIES 100
+
+/* the positions are sampled with a generator of their own, so the games are the same with and without output */
+#define RANDOM_GAMES_SAMPLE_SEED 0x53616D706C65ULL
+
+/**
+ * @brief ways a random game ends, a game that reaches the ply limit is counted as a draw
+ */
+enum Termination
+{
+  CHECKMATE,
+  STALEMATE,
+  INSUFFICIENT_MATERIAL,
+  FIFTY_MOVES,
+  REPETITION,
+  PLY_LIMIT,
+  NUM_OF_TERMINATIONS
+};
+
+char const *const terminationNames[NUM_OF_TERMINATIONS] = {"checkmate", "stalemate", "insufficient material", "fifty moves", "threefold repetition", "ply limit"};
+
+/**
+ * @brief settings of a run, the same settings and seed always give the same games
+ *
+ * verify: checks every position against the game set up from its FEN-notation, which
+ *          has to have the same Zobrist key and the same number of legal moves
+ */
+struct RandomGames
+{
+  uint64_t numOfGames = 0;
+  uint64_t seed = RANDOM_GAMES_DEFAULT_SEED;
+  int maxPlies = RANDOM_GAMES_DEFAULT_MAX_PLIES;
+  int positionsPerGame = RANDOM_GAMES_DEFAULT_POSITIONS_PER_GAME;
+  bool verify = false;
+  std::string startFEN = STANDARD_OPENING_FEN;
+
+  std::ofstream output;
+  std::mutex outputMutex;
+  std::atomic<uint64_t> nextGame{0};
+};
+
+/**
+ * @brief counts of the games of a thread, summed up at the end
+ */
+struct GameStatistics
+{
+  uint64_t numOfGames = 0;
+  uint64_t numOfPlies = 0;
+  uint64_t numOfPositions = 0;
+  uint64_t numOfErrors = 0;
+  int minPlies = INT32_MAX;
+  int maxPlies = 0;
+  uint64_t results[3] = {};
+  uint64_t terminations[NUM_OF_TERMINATIONS] = {};
+
+  void add(GameStatistics const &other)
+  {
+    numOfGames += other.numOfGames;
+    numOfPlies += other.numOfPlies;
+    numOfPositions += other.numOfPositions;
+    numOfErrors += other.numOfErrors;
+    minPlies = std::min(minPlies, other.minPlies);
+    maxPlies = std::max(maxPlies, other.maxPlies);
+    for (int i = 0; i < 3; i++)
+    {
+      results[i] += other.results[i];
+    }
+    for (int i = 0; i < NUM_OF_TERMINATIONS; i++)
+    {
+      terminations[i] += other.terminations[i];
+    }
+  }
+};
+
+namespace
+{
+  /**
+   * @brief checks that a position set up from its FEN-notation is the position the
+   *          moves led to, which catches moves that corrupt the board or the keys
+   */
+  bool verifyPosition(Game &game, std::vector<Move> const &legalMoves, uint64_t const gameIndex, int const ply, GameStatistics &statistics)
+  {
+    std::string const FEN = game.getFEN();
+    Game copy(FEN);
+    if (copy.getZobristKey() == game.getZobristKey() && copy.getAllLegalMoves().size() == legalMoves.size())
+    {
+      return true;
+    }
+    if (statistics.numOfErrors++ < RANDOM_GAMES_MAX_REPORTED_ERRORS)
+    {
+      logIt(LogLevel::ERROR) << "Game " << gameIndex << " ply " << ply << " does not match its FEN-notation " << FEN << ": "
+                             << legalMoves.size() << " legal moves instead of " << copy.getAllLegalMoves().size();
+    }
+    return false;
+  }
+
+  /**
+   * @brief plays one game of random moves to its end
+   *
+   * @return the result, the termination and the sampled positions are written to the arguments
+   */
+  Result playGame(RandomGames &settings, Game const &start, uint64_t const gameIndex, GameStatistics &statistics,
+                  Termination &termination, std::vector<std::string> &positions)
+  {
+    Game game(start);
+    PlayerEngineRandom player(settings.seed + gameIndex);
+    RandomGenerator sampler(settings.seed + gameIndex + RANDOM_GAMES_SAMPLE_SEED);
+
+    /* Keys since the last capture or pawn move, positions before it cannot repeat */
+    std::vector<uint64_t> keys = {game.getZobristKey()};
+    int repetitions = 0;
+    Result result = Result::ONGOING;
+    int ply = 0;
+    for (;;)
+    {
+      std::vector<Move> const legalMoves = game.getAllLegalMoves();
+      if (settings.verify)
+      {
+        verifyPosition(game, legalMoves, gameIndex, ply, statistics);
+      }
+      if (legalMoves.empty())
+      {
+        bool const isCheckmate = game.isKingInCheck(game.getTurn());
+        termination = isCheckmate ? Termination::CHECKMATE : Termination::STALEMATE;
+        result = !isCheckmate ? Result::DRAW : (game.getTurn() == Piece::Color::WHITE ? Result::BLACK_WIN : Result::WHITE_WIN);
+        break;
+      }
+      /* A checkmate on the last move before a draw by the rules still wins */
+      if (repetitions >= 2 || keys.size() > FIFTY_MOVE_RULE_PLIES)
+      {
+        termination = repetitions >= 2 ? Termination::REPETITION : Termination::FIFTY_MOVES;
+        result = Result::DRAW;
+        break;
+      }
+      if (game.isGameOver())
+      {
+        termination = Termination::INSUFFICIENT_MATERIAL;
+        result = Result::DRAW;
+        break;
+      }
+      if (ply >= settings.maxPlies)
+      {
+        termination = Termination::PLY_LIMIT;
+        result = Result::DRAW;
+        break;
+      }
+
+      /* Reservoir sampling, every position with a move to make is equally likely to be kept */
+      if (settings.positionsPerGame > 0)
+      {
+        uint32_t const slot = positions.size() < static_cast<size_t>(settings.positionsPerGame) ? positions.size() : sampler.nextBelow(ply + 1);
+        if (slot < static_cast<uint32_t>(settings.positionsPerGame))
+        {
+          std::string const FEN = game.getFEN() + " " + std::to_string(keys.size() - 1) + " " + std::to_string(game.getMoveCounter());
+          if (slot < positions.size())
+          {
+            positions[slot] = FEN;
+          }
+          else
+          {
+            positions.push_back(FEN);
+          }
+        }
+      }
+
+      Move const &move = player.pickMove(legalMoves);
+      bool const isIrreversible = game.isCapture(move) || Piece::getPieceTypeWithoutColor(move.piece) == Piece::Type::PAWN;
+      game.makeMove(move);
+      ply++;
+
+      if (isIrreversible)
+      {
+        keys.clear();
+      }
+      /* Only positions with the same player to move can be repetitions */
+      uint64_t const key = game.getZobristKey();
+      repetitions = 0;
+      for (size_t i = keys.size() % 2; i < keys.size(); i += 2)
+      {
+        repetitions += keys[i] == key;
+      }
+      keys.push_back(key);
+    }
+
+    statistics.numOfGames++;
+    statistics.numOfPlies += ply;
+    statistics.minPlies = std::min(statistics.minPlies, ply);
+    statistics.maxPlies = std::max(statistics.maxPlies, ply);
+    statistics.results[static_cast<int>(result)]++;
+    statistics.terminations[termination]++;
+    return result;
+  }
+
+  /**
+   * @brief plays chunks of games until all games are played
+   */
+  void work(RandomGames &settings, Game const &start, GameStatistics &statistics)
+  {
+    std::string buffer;
+    std::vector<std::string> positions;
+    auto const flush = [&settings, &buffer]()
+    {
+      std::lock_guard<std::mutex> lock(settings.outputMutex);
+      settings.output << buffer;
+      buffer.clear();
+    };
+
+    for (;;)
+    {
+      uint64_t const first = settings.nextGame.fetch_add(RANDOM_GAMES_CHUNK_SIZE);
+      if (first >= settings.numOfGames)
+      {
+        break;
+      }
+      uint64_t const last = std::min(settings.numOfGames, first + RANDOM_GAMES_CHUNK_SIZE);
+      for (uint64_t gameIndex = first; gameIndex < last; gameIndex++)
+      {
+        Termination termination;
+        positions.clear();
+        Result const result = playGame(settings, start, gameIndex, statistics, termination, positions);
+        if (!settings.output.is_open())
+        {
+          continue;
+        }
+
+        /* The result is written the way the Texel tuner reads it */
+        char const *const resultText = result == Result::WHITE_WIN ? " [1.0]\n" : (result == Result::BLACK_WIN ? " [0.0]\n" : " [0.5]\n");
+        for (auto const &FEN : positions)
+        {
+          buffer += FEN;
+          buffer += resultText;
+        }
+        statistics.numOfPositions += positions.size();
+        if (buffer.size() >= RANDOM_GAMES_WRITE_SIZE)
+        {
+          flush();
+        }
+      }
+    }
+    if (!buffer.empty())
+    {
+      flush();
+    }
+  }
+};
+
+/**
+ * usage: Random_games <games> [threads] [seed] [max plies] [output] [positions per game] [verify] [FEN]
+ */
+int main(int argc, char *argv[])
+{
+  PieceSquareTable::init();
+
+  if (argc < 2 || std::strtoull(argv[1], nullptr, 10) == 0)
+  {
+    std::cerr << "usage: " << argv[0] << " <games> [threads] [seed] [max plies] [output] [positions per game] [verify] [FEN]" << std::endl;
+    return 1;
+  }
+  RandomGames settings;
+  settings.numOfGames = std::strtoull(argv[1], nullptr, 10);
+  int const numThreads = std::max(1, argc > 2 ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency()));
+  settings.seed = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : RANDOM_GAMES_DEFAULT_SEED;
+  settings.maxPlies = std::max(0, argc > 4 ? std::atoi(argv[4]) : RANDOM_GAMES_DEFAULT_MAX_PLIES);
+  settings.positionsPerGame = std::max(0, argc > 6 ? std::atoi(argv[6]) : RANDOM_GAMES_DEFAULT_POSITIONS_PER_GAME);
+  settings.verify = argc > 7 && std::atoi(argv[7]) != 0;
+  if (argc > 8)
+  {
+    settings.startFEN = argv[8];
+  }
+
+  if (argc > 5 && std::string(argv[5]) != "-")
+  {
+    settings.output.open(argv[5], std::ios::binary);
+    if (!settings.output)
+    {
+      logIt(LogLevel::ERROR) << "Could not write position file " << argv[5];
+      return 1;
+    }
+  }
+  else
+  {
+    settings.positionsPerGame = 0;
+  }
+
+  /* Every game starts from a copy, so the FEN-notation is only parsed once */
+  Game const start(settings.startFEN);
+  if (Game(start).getAllLegalMoves().empty())
+  {
+    logIt(LogLevel::ERROR) << "The start position " << settings.startFEN << " has no legal moves";
+    return 1;
+  }
+
+  auto const begin = std::chrono::steady_clock::now();
+  std::vector<GameStatistics> threadStatistics(numThreads);
+  std::vector<std::thread> workers;
+  for (int i = 0; i < numThreads; i++)
+  {
+    workers.emplace_back(work, std::ref(settings), std::cref(start), std::ref(threadStatistics[i]));
+  }
+  for (auto &worker : workers)
+  {
+    worker.join();
+  }
+  auto const elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+
+  GameStatistics statistics;
+  for (auto const &other : threadStatistics)
+  {
+    statistics.add(other);
+  }
+
+  logIt(LogLevel::INFO) << "Played " << statistics.numOfGames << " games with " << statistics.numOfPlies << " plies in " << elapsed << "ms ("
+                        << (statistics.numOfPlies * 1000 / std::max<int64_t>(1, elapsed)) << " plies/s) on " << numThreads << " thread(s) from seed " << settings.seed;
+  logIt(LogLevel::INFO) << "Plies per game: " << (statistics.numOfPlies / statistics.numOfGames) << " on average, " << statistics.minPlies
+                        << " to " << statistics.maxPlies;
+  logIt(LogLevel::INFO) << "Results: " << statistics.results[Result::WHITE_WIN] << " white wins, " << statistics.results[Result::BLACK_WIN]
+                        << " black wins, " << statistics.results[Result::DRAW] << " draws";
+  for (int i = 0; i < NUM_OF_TERMINATIONS; i++)
+  {
+    logIt(LogLevel::INFO) << "Ended by " << terminationNames[i] << ": " << statistics.terminations[i];
+  }
+  if (settings.output.is_open())
+  {
+    logIt(LogLevel::INFO) << "Wrote " << statistics.numOfPositions << " positions to " << argv[5];
+  }
+  if (settings.verify)
+  {
+    if (statistics.numOfErrors > 0)
+    {
+      logIt(LogLevel::ERROR) << "Verified every position, " << statistics.numOfErrors << " mismatches";
+    }
+    else
+    {
+      logIt(LogLevel::INFO) << "Verified every position, no mismatches";
+    }
+  }
+  return statistics.numOfErrors > 0 ? 1 : 0;
+}
@@ -0,0 +1,262 @@
+#include "../include/playerengineminimax.h"
+#include "../include/evaluationweights.h"
+#include "../include/nnue.h"
+#include "../include/logger.h"
+#include "../include/piecesquaretable.h"
+#include "../include/texel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#define TUNER_DEFAULT_EPOCHS 500
+#define TUNER_LOG_INTERVAL 50
+
+/* scaling constant K of the sigmoid, searched in [0, TUNER_K_MAX] */
+#define TUNER_K_MAX 3.0
+#define TUNER_K_PRECISION 10
+
+/**
+ * @brief worker threads that live through the whole tuning, a run hands every worker
+ *          its index and returns when all of them are done
+ */
+class WorkerPool
+{
+public:
+  WorkerPool(int const numOfWorkers)
+  {
+    for (int i = 0; i < numOfWorkers; i++)
+    {
+      workers.emplace_back([this, i]()
+                           { work(i); });
+    }
+  }
+
+  ~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      isStopping = true;
+    }
+    wake.notify_all();
+    for (auto &worker : workers)
+    {
+      worker.join();
+    }
+  }
+
+  void run(std::function<void(int)> const &function)
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    task = &function;
+    numOfPending = workers.size();
+    generation++;
+    wake.notify_all();
+    done.wait(lock, [this]()
+              { return numOfPending == 0; });
+    task = nullptr;
+  }
+
+private:
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  std::function<void(int)> const *task = nullptr;
+  uint64_t generation = 0;
+  size_t numOfPending = 0;
+  bool isStopping = false;
+
+  void work(int const index)
+  {
+    uint64_t lastGeneration = 0;
+    while (true)
+    {
+      std::function<void(int)> const *function;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [this, lastGeneration]()
+                  { return isStopping || generation != lastGeneration; });
+        if (isStopping)
+        {
+          return;
+        }
+        lastGeneration = generation;
+        function = task;
+      }
+      (*function)(index);
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--numOfPending == 0)
+        {
+          done.notify_one();
+        }
+      }
+    }
+  }
+};
+
+namespace
+{
+  double totalError(WorkerPool &pool, std::vector<Chunk> &chunks, std::vector<double> const &parameters, double const K, size_t const numOfPositions)
+  {
+    pool.run([&](int const worker)
+             { Texel::computeError(chunks[worker], parameters, K); });
+    double error = 0;
+    for (auto const &chunk : chunks)
+    {
+      error += chunk.error;
+    }
+    return error / numOfPositions;
+  }
+
+  /**
+   * @brief finds the K for which the current parameters fit the results best,
+   *          one digit more precise per round
+   */
+  double findK(WorkerPool &pool, std::vector<Chunk> &chunks, std::vector<double> const &parameters, size_t const numOfPositions)
+  {
+    double bestK = 1.0;
+    double bestError = totalError(pool, chunks, parameters, bestK, numOfPositions);
+    double step = 0.1;
+    for (int round = 0; round < TUNER_K_PRECISION / 2; round++)
+    {
+      double const center = bestK;
+      for (double K = std::max(0.0, center - 10 * step); K <= std::min(TUNER_K_MAX, center + 10 * step); K += step)
+      {
+        double const error = totalError(pool, chunks, parameters, K, numOfPositions);
+        if (error < bestError)
+        {
+          bestError = error;
+          bestK = K;
+        }
+      }
+      step /= 10;
+    }
+    return bestK;
+  }
+};
+
+/**
+ * @brief tunes the hand-crafted evaluation parameters on positions with known results
+ *
+ * Each line of the input holds a FEN and the result of the game it comes from, for
+ * example "<fen> 1-0" or "<fen> [0.5]". The positions are replaced by the leaf of their
+ * quiescence search, traced once into coefficients, and the parameters are then fitted
+ * with Adam so that the sigmoid of the evaluation predicts the results.
+ *
+ * usage: Texel_tuner <positions> [output] [epochs] [threads]
+ */
+int main(int argc, char *argv[])
+{
+  PieceSquareTable::init();
+
+  if (argc < 2)
+  {
+    std::cerr << "usage: " << argv[0] << " <positions> [output] [epochs] [threads]" << std::endl;
+    return 1;
+  }
+  std::string const outputPath = argc > 2 ? argv[2] : DEFAULT_PARAMETER_FILE;
+  int const numOfEpochs = argc > 3 ? std::atoi(argv[3]) : TUNER_DEFAULT_EPOCHS;
+  int const numThreads = std::max(1, argc > 4 ? std::atoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency()));
+
+  /* Tuning continues from the parameters the engine plays with */
+  EvalParameters::loadStartupParameters(DEFAULT_PARAMETER_FILE);
+
+  /* The quiescence search has to use the evaluation that is tuned */
+  PlayerEngineMiniMax engine(DEFAULT_MAX_DEPTH, 1);
+  NNUE::unload();
+
+  std::ifstream file(argv[1], std::ios::binary);
+  if (!file)
+  {
+    logIt(LogLevel::ERROR) << "Could not read position file " << argv[1];
+    return 1;
+  }
+  std::string const text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+  std::vector<EvalParameter> parameters = EvalParameters::getParameters(engine.getEvaluationWeights());
+  std::unordered_map<void const *, int> indices;
+  std::vector<double> values = Texel::indexParameters(parameters, indices);
+
+  /* Every worker parses the lines of its own part of the file and keeps its positions for all epochs */
+  std::vector<Chunk> chunks(numThreads);
+  std::vector<std::pair<size_t, size_t>> parts;
+  size_t begin = 0;
+  for (int i = 0; i < numThreads; i++)
+  {
+    size_t end = i == numThreads - 1 ? text.size() : text.size() * (i + 1) / numThreads;
+    end = std::max(end, begin);
+    while (end < text.size() && text[end] != '\n')
+    {
+      end++;
+    }
+    parts.push_back({begin, end});
+    begin = end;
+  }
+  WorkerPool pool(numThreads);
+  pool.run([&](int const worker)
+           { Texel::extractPositions(engine, text, parts[worker].first, parts[worker].second, indices, values, chunks[worker]); });
+
+  size_t numOfPositions = 0;
+  int numOfMismatches = 0;
+  for (auto &chunk : chunks)
+  {
+    numOfPositions += chunk.positions.size();
+    numOfMismatches += chunk.numOfMismatches;
+    chunk.gradient.assign(values.size(), 0.0);
+  }
+  if (numOfPositions == 0)
+  {
+    logIt(LogLevel::ERROR) << "No positions with a result found in " << argv[1];
+    return 1;
+  }
+  logIt(LogLevel::INFO) << "Extracted " << numOfPositions << " quiet positions with " << parameters.size() << " parameters";
+  if (numOfMismatches > 0)
+  {
+    logIt(LogLevel::WARNING) << numOfMismatches << " traces do not match the evaluation, some terms are not traced";
+  }
+
+  double const K = findK(pool, chunks, values, numOfPositions);
+  logIt(LogLevel::INFO) << "K " << K << " error " << totalError(pool, chunks, values, K, numOfPositions);
+
+  AdamOptimizer optimizer(values.size());
+  std::vector<double> gradient(values.size());
+  for (int epoch = 1; epoch <= numOfEpochs; epoch++)
+  {
+    pool.run([&](int const worker)
+             { Texel::computeGradient(chunks[worker], values, K); });
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+      gradient[i] = 0;
+      for (auto const &chunk : chunks)
+      {
+        gradient[i] += chunk.gradient[i];
+      }
+      gradient[i] /= numOfPositions;
+    }
+    optimizer.step(values, gradient);
+
+    if (epoch % TUNER_LOG_INTERVAL == 0 || epoch == numOfEpochs)
+    {
+      logIt(LogLevel::INFO) << "Epoch " << epoch << " error " << totalError(pool, chunks, values, K, numOfPositions);
+    }
+  }
+
+  for (size_t i = 0; i < parameters.size(); i++)
+  {
+    parameters[i].set(static_cast<Score>(std::lround(values[2 * i])), static_cast<Score>(std::lround(values[2 * i + 1])));
+  }
+  if (!EvalParameters::save(outputPath, engine.getEvaluationWeights()))
+  {
+    return 1;
+  }
+  logIt(LogLevel::INFO) << "Wrote the tuned parameters to " << outputPath;
+  return 0;
+}